@@ -0,0 +1,55 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "AllocationCounter.h"
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "CommandExecutor.h"
+
+namespace bavykin
+{
+  // Usage: allocations [commands per operation = 1000] [entries per dataset = 256]
+  int runAllocationBenchmark(int argc, char* argv[])
+  {
+    size_t commandCount = std::max< size_t >(argumentOr(argc, argv, 1, 1000), 1);
+    size_t entryCount = argumentOr(argc, argv, 2, 256);
+
+    std::ostringstream dataSet;
+    for (const char* name : { "a", "b" })
+    {
+      dataSet << name;
+      for (size_t i = 0; i < entryCount; i++)
+      {
+        dataSet << " " << (name[0] == 'a' ? i : i + entryCount / 2) << " value" << i % 32;
+      }
+      dataSet << "\n";
+    }
+
+    NullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+    CommandExecutor executor(nullStream);
+    std::istringstream dataSetStream(dataSet.str());
+    executor.readFile(dataSetStream);
+
+    const char* const commands[] = { "print a", "union r a b", "intersect r a b", "complement r a b" };
+    std::cout << "entries per dataset: " << entryCount << "\n";
+    for (const char* command : commands)
+    {
+      executor.execute(std::string(command));
+      executor.flushOutput();
+
+      size_t bytesBefore = allocatedBytes();
+      size_t countBefore = allocationCount();
+      for (size_t i = 0; i < commandCount; i++)
+      {
+        executor.execute(std::string(command));
+      }
+      executor.flushOutput();
+
+      std::cout << command << ": " << (allocatedBytes() - bytesBefore) / commandCount << " bytes, "
+                << (allocationCount() - countBefore) / commandCount << " allocations per command\n";
+    }
+
+    return 0;
+  }
+}
@@ -0,0 +1,68 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  std::atomic< size_t > g_AllocatedBytes(0);
+  std::atomic< size_t > g_AllocationCount(0);
+
+  void* countedAllocate(size_t size)
+  {
+    g_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+    {
+      throw std::bad_alloc();
+    }
+
+    return memory;
+  }
+}
+
+void* operator new(size_t size)
+{
+  return countedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+  return countedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+  std::free(memory);
+}
+
+namespace bavykin
+{
+  size_t allocatedBytes()
+  {
+    return g_AllocatedBytes.load(std::memory_order_relaxed);
+  }
+
+  size_t allocationCount()
+  {
+    return g_AllocationCount.load(std::memory_order_relaxed);
+  }
+}
@@ -0,0 +1,11 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+#include <cstddef>
+
+namespace bavykin
+{
+  // Totals since program start, collected by the replaced global operator new in AllocationCounter.cpp.
+  size_t allocatedBytes();
+  size_t allocationCount();
+}
+#endif
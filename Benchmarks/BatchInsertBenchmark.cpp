@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "BinarySearchTree.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    using Tree = BST< int, int >;
+    using Entries = std::vector< std::pair< int, int > >;
+
+    Entries treeEntries(size_t treeSize)
+    {
+      Entries entries;
+      entries.reserve(treeSize);
+      for (size_t i = 0; i < treeSize; i++)
+      {
+        entries.emplace_back(static_cast< int >(i * 2), 0);
+      }
+
+      return entries;
+    }
+
+    const size_t REPEATS = 3;
+
+    // Best time in nanoseconds of merging the batch into a fresh copy of the tree.
+    template < typename Merge >
+    double timedMerge(const Entries& existing, Merge merge)
+    {
+      uint64_t best = UINT64_MAX;
+      for (size_t repeat = 0; repeat < REPEATS; repeat++)
+      {
+        Tree tree;
+        tree.assignSorted(existing.cbegin(), existing.cend());
+
+        Stopwatch stopwatch;
+        merge(tree);
+        best = std::min(best, stopwatch.elapsedNanoseconds());
+        doNotOptimize(tree.size());
+      }
+
+      return static_cast< double >(best);
+    }
+  }
+
+  // Usage: batches [tree size = 200000] [threads = 1]
+  // Merges random batches of 0.001 to 10 times the tree size into a tree of even keys, so about half of the batch
+  // keys are new, and compares one insert per entry with each insertBatch strategy.
+  int runBatchInsertBenchmark(int argc, char* argv[])
+  {
+    size_t treeSize = std::max< size_t >(argumentOr(argc, argv, 1, 200000), 1);
+    size_t threadCount = std::max< size_t >(argumentOr(argc, argv, 2, 1), 1);
+    const double ratios[] = { 0.001, 0.01, 0.1, 0.3, 1.0, 3.0, 10.0 };
+
+    Entries existing = treeEntries(treeSize);
+    std::mt19937 random(19);
+
+    std::cout << "tree size: " << treeSize << ", threads: " << threadCount << ", ns per batch entry\n";
+    std::cout << std::setw(8) << "ratio" << std::setw(12) << "insert" << std::setw(14) << "incremental"
+              << std::setw(12) << "rebuild" << std::setw(12) << "automatic" << "\n";
+    for (double ratio : ratios)
+    {
+      size_t batchSize = std::max< size_t >(static_cast< size_t >(treeSize * ratio), 1);
+      std::uniform_int_distribution< int > pick(0, static_cast< int >(std::max(treeSize, batchSize)) * 2);
+      Entries batch;
+      for (size_t i = 0; i < batchSize; i++)
+      {
+        batch.emplace_back(pick(random), static_cast< int >(i));
+      }
+
+      auto batched = [&batch, threadCount](Tree::BatchStrategy strategy)
+      {
+        return [&batch, threadCount, strategy](Tree& tree)
+        {
+          tree.insertBatch(batch.cbegin(), batch.cend(), strategy, threadCount);
+        };
+      };
+      double inserted = timedMerge(existing, [&batch](Tree& tree)
+        {
+          for (const std::pair< int, int >& entry : batch)
+          {
+            tree.insert(entry);
+          }
+        });
+      double incremental = timedMerge(existing, batched(Tree::BatchStrategy::Incremental));
+      double rebuilt = timedMerge(existing, batched(Tree::BatchStrategy::Rebuild));
+      double automatic = timedMerge(existing, batched(Tree::BatchStrategy::Automatic));
+
+      std::cout << std::setw(8) << ratio << std::setw(12) << inserted / batchSize << std::setw(14)
+                << incremental / batchSize << std::setw(12) << rebuilt / batchSize << std::setw(12)
+                << automatic / batchSize << "\n";
+    }
+
+    return 0;
+  }
+}
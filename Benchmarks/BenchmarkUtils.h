@@ -0,0 +1,80 @@
+#ifndef BENCHMARK_UTILS_H
+#define BENCHMARK_UTILS_H
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+namespace bavykin
+{
+  class Stopwatch
+  {
+  public:
+    Stopwatch(): m_Start(std::chrono::steady_clock::now())
+    {
+    }
+
+    void restart()
+    {
+      m_Start = std::chrono::steady_clock::now();
+    }
+
+    uint64_t elapsedNanoseconds() const
+    {
+      return static_cast< uint64_t >(
+        std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now() - m_Start).count());
+    }
+
+    double elapsedSeconds() const
+    {
+      return elapsedNanoseconds() / 1e9;
+    }
+
+  private:
+    std::chrono::steady_clock::time_point m_Start;
+  };
+
+  class NullBuffer: public std::streambuf
+  {
+  protected:
+    int overflow(int value) override
+    {
+      return value;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override
+    {
+      return count;
+    }
+  };
+
+  inline uint64_t percentile(std::vector< uint64_t > samples, double fraction)
+  {
+    if (samples.empty())
+    {
+      return 0;
+    }
+
+    size_t index = static_cast< size_t >(fraction * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+  }
+
+  // Stores a result where the optimizer cannot prove it unused, so the work producing it is not dropped.
+  template < typename T >
+  void doNotOptimize(const T& value)
+  {
+    static volatile T sink;
+    sink = value;
+    static_cast< void >(sink);
+  }
+
+  inline size_t argumentOr(int argc, char* argv[], int index, size_t fallback)
+  {
+    return index < argc ? static_cast< size_t >(std::strtoull(argv[index], nullptr, 10)) : fallback;
+  }
+}
+#endif
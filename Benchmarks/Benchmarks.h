@@ -0,0 +1,24 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+namespace bavykin
+{
+  int runCommandReplayBenchmark(int argc, char* argv[]);
+  int runPipelineBenchmark(int argc, char* argv[]);
+  int runSchedulerBenchmark(int argc, char* argv[]);
+  int runAllocationBenchmark(int argc, char* argv[]);
+  int runValueStorageBenchmark(int argc, char* argv[]);
+  int runDensityBenchmark(int argc, char* argv[]);
+  int runContainerBenchmark(int argc, char* argv[]);
+  int runInstrumentationBenchmark(int argc, char* argv[]);
+  int runEraseBenchmark(int argc, char* argv[]);
+  int runScanBenchmark(int argc, char* argv[]);
+  int runLookupBenchmark(int argc, char* argv[]);
+  int runBatchInsertBenchmark(int argc, char* argv[]);
+  int runPolicyBenchmark(int argc, char* argv[]);
+  int runConcurrentMapBenchmark(int argc, char* argv[]);
+  int runStringKeyBenchmark(int argc, char* argv[]);
+  int runHotKeyBenchmark(int argc, char* argv[]);
+  int runMembershipFilterBenchmark(int argc, char* argv[]);
+}
+#endif
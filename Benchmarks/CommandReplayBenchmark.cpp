@@ -0,0 +1,147 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "CommandExecutor.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    const char* const VALUES[] = { "name", "surname", "mouse", "keyboard", "monitor", "cable", "chair", "table" };
+    const char* const OPERATIONS[] = { "union", "intersect", "complement" };
+
+    std::string makeDataSet(size_t dataSets, size_t entries, std::mt19937& random)
+    {
+      std::uniform_int_distribution< int > keys(0, static_cast< int >(entries * 2));
+      std::uniform_int_distribution< size_t > values(0, sizeof(VALUES) / sizeof(VALUES[0]) - 1);
+      std::ostringstream out;
+
+      for (size_t i = 0; i < dataSets; i++)
+      {
+        out << "d" << i;
+        for (size_t j = 0; j < entries; j++)
+        {
+          out << " " << keys(random) << " " << VALUES[values(random)];
+        }
+        out << "\n";
+      }
+
+      return out.str();
+    }
+
+    std::vector< std::string > makeCommands(size_t count, size_t dataSets, std::mt19937& random)
+    {
+      std::uniform_int_distribution< size_t > names(0, dataSets - 1);
+      std::uniform_int_distribution< size_t > operations(0, 3);
+      std::vector< std::string > commands;
+      commands.reserve(count);
+
+      for (size_t i = 0; i < count; i++)
+      {
+        size_t operation = operations(random);
+        if (operation == 3)
+        {
+          commands.push_back("print d" + std::to_string(names(random)));
+        }
+        else
+        {
+          commands.push_back(std::string(OPERATIONS[operation]) + " t" + std::to_string(i % 8) + " d" +
+            std::to_string(names(random)) + " d" + std::to_string(names(random)));
+        }
+      }
+
+      return commands;
+    }
+  }
+
+  // Usage: replay [commands = 1000000] [datasets = 32] [entries per dataset = 32]
+  int runCommandReplayBenchmark(int argc, char* argv[])
+  {
+    size_t commandCount = argumentOr(argc, argv, 1, 1000000);
+    size_t dataSetCount = std::max< size_t >(argumentOr(argc, argv, 2, 32), 1);
+    size_t entryCount = argumentOr(argc, argv, 3, 32);
+
+    std::mt19937 random(42);
+    std::istringstream dataSet(makeDataSet(dataSetCount, entryCount, random));
+    std::vector< std::string > commands = makeCommands(commandCount, dataSetCount, random);
+
+    NullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+    CommandExecutor executor(nullStream);
+    executor.readFile(dataSet);
+
+    std::vector< uint64_t > latencies;
+    latencies.reserve(commands.size());
+    Stopwatch total;
+    Stopwatch single;
+
+    for (const std::string& command : commands)
+    {
+      single.restart();
+      executor.execute(command);
+      latencies.push_back(single.elapsedNanoseconds());
+    }
+    executor.flushOutput();
+
+    double seconds = total.elapsedSeconds();
+    std::cout << "commands: " << commands.size() << "\n";
+    std::cout << "seconds: " << seconds << "\n";
+    std::cout << "commands/sec: " << (seconds > 0 ? commands.size() / seconds : 0) << "\n";
+    std::cout << "p50 latency ns: " << percentile(latencies, 0.50) << "\n";
+    std::cout << "p99 latency ns: " << percentile(latencies, 0.99) << "\n";
+
+    return 0;
+  }
+
+  // Usage: pipeline [commands = 1000000] [datasets = 32] [entries per dataset = 32]
+  int runPipelineBenchmark(int argc, char* argv[])
+  {
+    size_t commandCount = argumentOr(argc, argv, 1, 1000000);
+    size_t dataSetCount = std::max< size_t >(argumentOr(argc, argv, 2, 32), 1);
+    size_t entryCount = argumentOr(argc, argv, 3, 32);
+
+    std::mt19937 random(42);
+    std::string dataSet = makeDataSet(dataSetCount, entryCount, random);
+    std::string script = "";
+    for (const std::string& command : makeCommands(commandCount, dataSetCount, random))
+    {
+      script += command;
+      script += '\n';
+    }
+
+    std::string outputs[2];
+    double seconds[2] = {};
+    for (int pipelined = 0; pipelined < 2; pipelined++)
+    {
+      std::istringstream dataSetStream(dataSet);
+      std::istringstream commands(script);
+      std::ostringstream output;
+      CommandExecutor executor(output);
+      executor.readFile(dataSetStream);
+
+      Stopwatch total;
+      if (pipelined)
+      {
+        executor.executePipelined(commands);
+      }
+      else
+      {
+        executor.execute(commands);
+      }
+      seconds[pipelined] = total.elapsedSeconds();
+      outputs[pipelined] = output.str();
+    }
+
+    std::cout << "commands: " << commandCount << "\n";
+    std::cout << "serial commands/sec: " << commandCount / seconds[0] << "\n";
+    std::cout << "pipelined commands/sec: " << commandCount / seconds[1] << "\n";
+    std::cout << "speedup: " << seconds[0] / seconds[1] << "\n";
+    std::cout << "outputs match: " << (outputs[0] == outputs[1] ? "yes" : "no") << "\n";
+
+    return outputs[0] == outputs[1] ? 0 : 3;
+  }
+}
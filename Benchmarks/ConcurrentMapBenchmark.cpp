@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "BinarySearchTree.h"
+#include "ConcurrentSkipList.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    // The serialized baseline: one tree behind one mutex, as the ingest threads share a dictionary today.
+    class LockedTree
+    {
+    public:
+      void insert(const std::pair< int, int >& value)
+      {
+        std::lock_guard< std::mutex > lock(m_Mutex);
+        m_Tree.insert(value);
+      }
+
+      void erase(int value)
+      {
+        std::lock_guard< std::mutex > lock(m_Mutex);
+        m_Tree.erase(value);
+      }
+
+      bool contains(int value)
+      {
+        std::lock_guard< std::mutex > lock(m_Mutex);
+        return m_Tree.find(value) != m_Tree.end();
+      }
+
+      bool isConsistent()
+      {
+        return m_Tree.validate();
+      }
+
+    private:
+      std::mutex m_Mutex;
+      BST< int, int > m_Tree;
+    };
+
+    class SkipList
+    {
+    public:
+      void insert(const std::pair< int, int >& value)
+      {
+        m_List.insert(value);
+      }
+
+      void erase(int value)
+      {
+        m_List.erase(value);
+      }
+
+      bool contains(int value)
+      {
+        return m_List.contains(value);
+      }
+
+      // Walks the list once the workers are done: keys must ascend and their count match size().
+      bool isConsistent()
+      {
+        size_t count = 0;
+        int previous = -1;
+        for (ConcurrentSkipList< int, int >::iterator i = m_List.begin(); i != m_List.end(); ++i, count++)
+        {
+          if (i->first <= previous)
+          {
+            return false;
+          }
+          previous = i->first;
+        }
+
+        return count == m_List.size();
+      }
+
+    private:
+      ConcurrentSkipList< int, int > m_List;
+    };
+
+    // Fills every other key, then lets the threads run half lookups, a quarter inserts and a quarter erases over the
+    // key range, all starting together. Returns millions of operations per second, or a negative value when the
+    // map is inconsistent afterwards.
+    template < class Map >
+    double run(size_t threadCount, size_t operationCount, int keyRange)
+    {
+      Map map;
+      for (int key = 0; key < keyRange; key += 2)
+      {
+        map.insert(std::make_pair(key, key));
+      }
+
+      std::atomic< bool > start(false);
+      std::vector< std::thread > workers;
+      std::vector< size_t > hits(threadCount);
+      for (size_t thread = 0; thread < threadCount; thread++)
+      {
+        workers.emplace_back([&map, &start, &hits, thread, operationCount, keyRange]
+          {
+            std::mt19937 random(static_cast< uint32_t >(thread * 31 + 1));
+            std::uniform_int_distribution< int > key(0, keyRange - 1);
+            while (!start.load(std::memory_order_acquire))
+            {
+              std::this_thread::yield();
+            }
+
+            for (size_t i = 0; i < operationCount; i++)
+            {
+              uint32_t roll = random() % 4;
+              int value = key(random);
+              if (roll == 0)
+              {
+                map.insert(std::make_pair(value, value));
+              }
+              else if (roll == 1)
+              {
+                map.erase(value);
+              }
+              else
+              {
+                hits[thread] += map.contains(value);
+              }
+            }
+          });
+      }
+
+      Stopwatch stopwatch;
+      start.store(true, std::memory_order_release);
+      for (std::thread& worker : workers)
+      {
+        worker.join();
+      }
+      double seconds = stopwatch.elapsedSeconds();
+      doNotOptimize(hits.data());
+
+      if (!map.isConsistent())
+      {
+        return -1.0;
+      }
+
+      return threadCount * operationCount / seconds / 1e6;
+    }
+  }
+
+  // Usage: concurrent [max threads = 64] [operations per thread = 100000] [key range = 100000]
+  // Scales a mixed workload from one thread up to max threads, doubling each step, on one mutex-guarded tree and on
+  // the concurrent skip list, and reports millions of operations per second.
+  int runConcurrentMapBenchmark(int argc, char* argv[])
+  {
+    size_t maxThreads = std::max< size_t >(argumentOr(argc, argv, 1, 64), 1);
+    size_t operationCount = std::max< size_t >(argumentOr(argc, argv, 2, 100000), 1);
+    int keyRange = static_cast< int >(std::max< size_t >(argumentOr(argc, argv, 3, 100000), 2));
+
+    std::cout << "operations per thread: " << operationCount << ", key range: " << keyRange
+              << ", hardware threads: " << std::thread::hardware_concurrency() << ", M operations/s\n";
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "locked tree" << std::setw(12) << "skip list" << "\n";
+    for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+      double locked = run< LockedTree >(threadCount, operationCount, keyRange);
+      double skipList = run< SkipList >(threadCount, operationCount, keyRange);
+
+      std::cout << std::setw(8) << threadCount << std::setw(14) << locked << std::setw(12) << skipList
+                << (locked < 0 || skipList < 0 ? "  inconsistent" : "") << "\n";
+    }
+
+    return 0;
+  }
+}
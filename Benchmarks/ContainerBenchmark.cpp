@@ -0,0 +1,510 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "Dictionary.h"
+#include "ForwardList.h"
+#include "StringUtils.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    // ForwardList::pushBack and operator[] walk the list, so these cases are quadratic and only run up to this size.
+    const size_t QUADRATIC_LIMIT = 100000;
+
+    enum class Distribution
+    {
+      Random,
+      Sorted,
+      Reverse,
+      Zipf
+    };
+
+    const std::pair< const char*, Distribution > DISTRIBUTIONS[] = {
+      { "random", Distribution::Random },
+      { "sorted", Distribution::Sorted },
+      { "reverse", Distribution::Reverse },
+      { "zipf", Distribution::Zipf },
+    };
+
+    using Tree = BST< int, int >;
+    using Map = std::map< int, int >;
+    using Dict = dictionary< int, int >;
+    using Entries = std::vector< std::pair< int, int > >;
+
+    std::vector< int > zipfKeys(size_t size, std::uniform_int_distribution< int >& uniform, std::mt19937& random)
+    {
+      std::vector< double > cumulative(size);
+      double total = 0;
+      for (size_t rank = 0; rank < size; rank++)
+      {
+        total += 1.0 / std::pow(static_cast< double >(rank + 1), 0.99);
+        cumulative[rank] = total;
+      }
+
+      std::vector< int > permutation(size);
+      std::generate(permutation.begin(), permutation.end(), [&] { return uniform(random); });
+      std::uniform_real_distribution< double > draw(0, total);
+      std::vector< int > keys(size);
+      for (int& key : keys)
+      {
+        size_t rank = std::lower_bound(cumulative.cbegin(), cumulative.cend(), draw(random)) - cumulative.cbegin();
+        key = permutation[std::min(rank, size - 1)];
+      }
+
+      return keys;
+    }
+
+    // Keys for one run. Random and Zipfian keys are drawn from [0, 4 * size); Zipfian ranks (s = 0.99) are mapped
+    // through a random permutation so the hot keys are scattered over the tree instead of forming one sorted edge.
+    std::vector< int > makeKeys(Distribution distribution, size_t size, std::mt19937& random)
+    {
+      std::vector< int > keys(size);
+      std::uniform_int_distribution< int > uniform(0, static_cast< int >(size * 4));
+
+      switch (distribution)
+      {
+      case Distribution::Random:
+        std::generate(keys.begin(), keys.end(), [&] { return uniform(random); });
+        break;
+      case Distribution::Sorted:
+        std::iota(keys.begin(), keys.end(), 0);
+        break;
+      case Distribution::Reverse:
+        std::iota(keys.rbegin(), keys.rend(), 0);
+        break;
+      case Distribution::Zipf:
+        keys = zipfKeys(size, uniform, random);
+        break;
+      }
+
+      return keys;
+    }
+
+    using Pass = std::function< uint64_t() >;
+
+    // One measured case. Preparing it builds whatever the case only reads (trees are built from sorted entries, which
+    // is linear, so setup stays cheap even where inserting is not); each pass then returns the nanoseconds spent in
+    // its timed part.
+    struct Case
+    {
+      const char* m_Family;
+      const char* m_Container;
+      size_t m_SizeLimit;
+      std::function< Pass(const std::vector< int >&) > m_Prepare;
+    };
+
+    struct Result
+    {
+      std::string m_Name;
+      const char* m_Family;
+      const char* m_Container;
+      const char* m_Distribution;
+      size_t m_Size;
+      size_t m_Iterations;
+      double m_NanosecondsPerItem;
+    };
+
+    template < typename F >
+    uint64_t timed(F function)
+    {
+      Stopwatch stopwatch;
+      function();
+      return stopwatch.elapsedNanoseconds();
+    }
+
+    Entries sortedEntries(const std::vector< int >& keys, int offset)
+    {
+      Map ordered;
+      for (int key : keys)
+      {
+        ordered.insert({ key + offset, key });
+      }
+
+      return Entries(ordered.cbegin(), ordered.cend());
+    }
+
+    template < typename C >
+    std::shared_ptr< C > assigned(const Entries& entries)
+    {
+      std::shared_ptr< C > result = std::make_shared< C >();
+      if constexpr (std::is_same< C, Map >::value)
+      {
+        result->insert(entries.cbegin(), entries.cend());
+      }
+      else
+      {
+        result->assignSorted(entries.cbegin(), entries.cend());
+      }
+
+      return result;
+    }
+
+    // Set operations run on the keys against the same keys shifted by half their count, so sorted inputs overlap
+    // by a half and random ones by most of their keys.
+    int overlapOffset(const std::vector< int >& keys)
+    {
+      return static_cast< int >(keys.size() / 2);
+    }
+
+    template < typename Operation >
+    Case dictionaryCase(const char* family, Operation operation)
+    {
+      return { family, "Dictionary", SIZE_MAX, [operation](const std::vector< int >& keys)
+        {
+          std::shared_ptr< Dict > left = assigned< Dict >(sortedEntries(keys, 0));
+          std::shared_ptr< Dict > right = assigned< Dict >(sortedEntries(keys, overlapOffset(keys)));
+          return Pass([=]
+            {
+              return timed([&] { doNotOptimize((left.get()->*operation)(*right).size()); });
+            });
+        } };
+    }
+
+    template < typename Algorithm >
+    Case standardSetCase(const char* family, Algorithm algorithm)
+    {
+      return { family, "std::set_*", SIZE_MAX, [algorithm](const std::vector< int >& keys)
+        {
+          std::shared_ptr< Entries > left = std::make_shared< Entries >(sortedEntries(keys, 0));
+          std::shared_ptr< Entries > right = std::make_shared< Entries >(sortedEntries(keys, overlapOffset(keys)));
+          return Pass([=]
+            {
+              auto byKey = [](const std::pair< int, int >& a, const std::pair< int, int >& b)
+              {
+                return a.first < b.first;
+              };
+              Entries result;
+              return timed([&]
+                {
+                  algorithm(left->cbegin(), left->cend(), right->cbegin(), right->cend(), std::back_inserter(result),
+                    byKey);
+                  doNotOptimize(result.size());
+                });
+            });
+        } };
+    }
+
+    template < typename C >
+    Case insertCase(const char* container)
+    {
+      return { "insert", container, SIZE_MAX, [](const std::vector< int >& keys)
+        {
+          return Pass([&keys]
+            {
+              C tree;
+              return timed([&]
+                {
+                  for (int key : keys)
+                  {
+                    tree.insert({ key, key });
+                  }
+                });
+            });
+        } };
+    }
+
+    // Inserts with the previously inserted entry as the hint, the way readFile loads a dataset.
+    template < typename C >
+    Case hintedInsertCase(const char* container)
+    {
+      return { "insert_hint", container, SIZE_MAX, [](const std::vector< int >& keys)
+        {
+          return Pass([&keys]
+            {
+              C tree;
+              return timed([&]
+                {
+                  typename C::iterator position = tree.end();
+                  for (int key : keys)
+                  {
+                    position = tree.insert(position, { key, key });
+                  }
+                });
+            });
+        } };
+    }
+
+    template < typename C >
+    Case findCase(const char* container)
+    {
+      return { "find", container, SIZE_MAX, [](const std::vector< int >& keys)
+        {
+          std::shared_ptr< C > tree = assigned< C >(sortedEntries(keys, 0));
+          return Pass([tree, &keys]
+            {
+              return timed([&]
+                {
+                  size_t found = 0;
+                  for (int key : keys)
+                  {
+                    found += tree->find(key) != tree->end();
+                  }
+                  doNotOptimize(found);
+                });
+            });
+        } };
+    }
+
+    template < typename C >
+    Case eraseCase(const char* container)
+    {
+      return { "erase", container, SIZE_MAX, [](const std::vector< int >& keys)
+        {
+          std::shared_ptr< Entries > entries = std::make_shared< Entries >(sortedEntries(keys, 0));
+          return Pass([entries, &keys]
+            {
+              std::shared_ptr< C > tree = assigned< C >(*entries);
+              return timed([&]
+                {
+                  for (int key : keys)
+                  {
+                    tree->erase(key);
+                  }
+                });
+            });
+        } };
+    }
+
+    template < typename C >
+    Case copyCase(const char* container)
+    {
+      return { "copy", container, SIZE_MAX, [](const std::vector< int >& keys)
+        {
+          std::shared_ptr< C > tree = assigned< C >(sortedEntries(keys, 0));
+          return Pass([tree]
+            {
+              return timed([&]
+                {
+                  C copy(*tree);
+                  doNotOptimize(copy.size());
+                });
+            });
+        } };
+    }
+
+    std::vector< Case > makeCases()
+    {
+      std::vector< Case > cases = {
+        insertCase< Tree >("BST"),
+        insertCase< Map >("std::map"),
+        hintedInsertCase< Tree >("BST"),
+        hintedInsertCase< Map >("std::map"),
+        findCase< Tree >("BST"),
+        findCase< Map >("std::map"),
+        eraseCase< Tree >("BST"),
+        eraseCase< Map >("std::map"),
+        { "iterate", "BST", SIZE_MAX, [](const std::vector< int >& keys)
+          {
+            std::shared_ptr< Tree > tree = assigned< Tree >(sortedEntries(keys, 0));
+            return Pass([tree]
+              {
+                return timed([&]
+                  {
+                    long long sum = 0;
+                    for (auto i = tree->cbegin(); i != tree->cend(); ++i)
+                    {
+                      sum += i.m_Current->m_Content.second;
+                    }
+                    doNotOptimize(sum);
+                  });
+              });
+          } },
+        { "iterate", "std::map", SIZE_MAX, [](const std::vector< int >& keys)
+          {
+            std::shared_ptr< Map > map = assigned< Map >(sortedEntries(keys, 0));
+            return Pass([map]
+              {
+                return timed([&]
+                  {
+                    long long sum = 0;
+                    for (const auto& entry : *map)
+                    {
+                      sum += entry.second;
+                    }
+                    doNotOptimize(sum);
+                  });
+              });
+          } },
+        copyCase< Tree >("BST"),
+        copyCase< Map >("std::map"),
+        dictionaryCase("union", &Dict::getUnion),
+        standardSetCase("union", [](auto... arguments) { std::set_union(arguments...); }),
+        dictionaryCase("intersect", &Dict::getIntersect),
+        standardSetCase("intersect", [](auto... arguments) { std::set_intersection(arguments...); }),
+        dictionaryCase("complement", &Dict::getComplement),
+        standardSetCase("complement", [](auto... arguments) { std::set_difference(arguments...); }),
+        { "push_front", "ForwardList", SIZE_MAX, [](const std::vector< int >& keys)
+          {
+            return Pass([&keys]
+              {
+                forward_list< int > list;
+                return timed([&]
+                  {
+                    for (int key : keys)
+                    {
+                      list.pushFront(key);
+                    }
+                  });
+              });
+          } },
+        { "push_back", "ForwardList", QUADRATIC_LIMIT, [](const std::vector< int >& keys)
+          {
+            return Pass([&keys]
+              {
+                forward_list< int > list;
+                return timed([&]
+                  {
+                    for (int key : keys)
+                    {
+                      list.pushBack(key);
+                    }
+                  });
+              });
+          } },
+        { "iterate", "ForwardList", SIZE_MAX, [](const std::vector< int >& keys)
+          {
+            std::shared_ptr< forward_list< int > > list = std::make_shared< forward_list< int > >();
+            for (int key : keys)
+            {
+              list->pushFront(key);
+            }
+
+            return Pass([list]
+              {
+                return timed([&]
+                  {
+                    long long sum = 0;
+                    for (auto i = list->cbegin(); i != list->cend(); ++i)
+                    {
+                      sum += *i;
+                    }
+                    doNotOptimize(sum);
+                  });
+              });
+          } },
+        { "split", "splitString", QUADRATIC_LIMIT, [](const std::vector< int >& keys)
+          {
+            std::ostringstream line;
+            for (int key : keys)
+            {
+              line << key << " ";
+            }
+
+            std::shared_ptr< std::string > text = std::make_shared< std::string >(line.str());
+            return Pass([text]
+              {
+                return timed([&] { doNotOptimize(splitString(*text, " ").size()); });
+              });
+          } },
+      };
+
+      return cases;
+    }
+
+    // Repeats a case until it has run at least the given time and reports the fastest pass, which is the least
+    // disturbed by the rest of the machine.
+    Result run(const Case& benchmark, const char* distribution, const std::vector< int >& keys, uint64_t minimumTime)
+    {
+      Pass pass = benchmark.m_Prepare(keys);
+      uint64_t best = UINT64_MAX;
+      uint64_t total = 0;
+      size_t iterations = 0;
+      while (iterations == 0 || total < minimumTime)
+      {
+        uint64_t elapsed = pass();
+        best = std::min(best, elapsed);
+        total += elapsed;
+        iterations++;
+      }
+
+      std::string name = std::string(benchmark.m_Family) + "/" + benchmark.m_Container + "/" + distribution + "/" +
+        std::to_string(keys.size());
+      return { name, benchmark.m_Family, benchmark.m_Container, distribution, keys.size(), iterations,
+        static_cast< double >(best) / std::max< size_t >(keys.size(), 1) };
+    }
+
+    // Writes the results in the layout Google Benchmark uses for --benchmark_format=json, so its compare.py can
+    // diff two runs.
+    void writeJson(std::ostream& out, const std::vector< Result >& results)
+    {
+      out << std::fixed << std::setprecision(3);
+      out << "{\n  \"context\": {\n    \"executable\": \"Benchmarks containers\",\n    \"time_unit\": \"ns\"\n  },\n"
+          << "  \"benchmarks\": [";
+      for (size_t i = 0; i < results.size(); i++)
+      {
+        const Result& result = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.m_Name << "\", \"run_name\": \""
+            << result.m_Name << "\", \"run_type\": \"iteration\", \"family\": \"" << result.m_Family
+            << "\", \"container\": \"" << result.m_Container << "\", \"distribution\": \""
+            << result.m_Distribution << "\", \"size\": " << result.m_Size << ", \"iterations\": "
+            << result.m_Iterations << ", \"real_time\": " << result.m_NanosecondsPerItem
+            << ", \"cpu_time\": " << result.m_NanosecondsPerItem << ", \"time_unit\": \"ns\"}";
+      }
+      out << "\n  ]\n}\n";
+    }
+  }
+
+  // Usage: containers [maximum size = 1000] [json file = containers.json] [minimum ms per case = 100]
+  // Sizes grow tenfold from 1000 up to the maximum (10^8 at most). Results go to the console and,
+  // in Google Benchmark's JSON layout, to the given file.
+  int runContainerBenchmark(int argc, char* argv[])
+  {
+    size_t maximumSize = std::max< size_t >(argumentOr(argc, argv, 1, 1000), 1000);
+    std::string jsonPath = argc > 2 ? argv[2] : "containers.json";
+    uint64_t minimumTime = argumentOr(argc, argv, 3, 100) * 1000000;
+    std::vector< Case > cases = makeCases();
+    std::vector< Result > results;
+    std::mt19937 random(37);
+
+    std::cout << std::left << std::setw(44) << "benchmark" << std::right << std::setw(14) << "ns/item"
+              << std::setw(12) << "passes" << "\n";
+    for (size_t size = 1000; size <= maximumSize; size *= 10)
+    {
+      for (const auto& distribution : DISTRIBUTIONS)
+      {
+        std::vector< int > keys = makeKeys(distribution.second, size, random);
+        for (const Case& benchmark : cases)
+        {
+          if (size > benchmark.m_SizeLimit)
+          {
+            continue;
+          }
+
+          results.push_back(run(benchmark, distribution.first, keys, minimumTime));
+          const Result& result = results.back();
+          std::cout << std::left << std::setw(44) << result.m_Name << std::right << std::setw(14) << std::fixed
+                    << std::setprecision(2) << result.m_NanosecondsPerItem << std::defaultfloat << std::setw(12)
+                    << result.m_Iterations << std::endl;
+        }
+      }
+    }
+
+    std::ofstream json(jsonPath);
+    if (!json)
+    {
+      throw std::runtime_error("Cannot write '" + jsonPath + "'.");
+    }
+    writeJson(json, results);
+    std::cout << "results written to " << jsonPath << "\n";
+
+    return 0;
+  }
+}
@@ -0,0 +1,95 @@
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "SetExpression.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    const double DENSITIES[] = { 1.0, 0.5, 0.2, 0.1, 0.05, 0.02, 1.0 / 64, 0.005, 0.001 };
+
+    DataSetHandle makeDataSet(const std::string& name, size_t range, double density, std::mt19937& random)
+    {
+      std::bernoulli_distribution present(density);
+      std::vector< std::pair< int, DataSetValue > > entries;
+      for (size_t key = 0; key < range; key++)
+      {
+        if (present(random))
+        {
+          entries.emplace_back(static_cast< int >(key), DataSetValue("v" + std::to_string(key % 16)));
+        }
+      }
+
+      std::shared_ptr< DataSet > result = std::make_shared< DataSet >(name);
+      result->assignSorted(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+
+      return result;
+    }
+
+    double timeOperation(SetExpression::Operation operation, const ExpressionHandle& left,
+      const ExpressionHandle& right, size_t repetitions)
+    {
+      Stopwatch stopwatch;
+      for (size_t i = 0; i < repetitions; i++)
+      {
+        SetExpression::combine(operation, "r", { left, right })->size();
+      }
+
+      return stopwatch.elapsedSeconds() * 1e3 / repetitions;
+    }
+  }
+
+  // Usage: density [key range = 1048576] [repetitions = 5]
+  int runDensityBenchmark(int argc, char* argv[])
+  {
+    size_t range = std::max< size_t >(argumentOr(argc, argv, 1, 1 << 20), 1);
+    size_t repetitions = std::max< size_t >(argumentOr(argc, argv, 2, 5), 1);
+    const std::pair< const char*, SetExpression::Operation > operations[] = {
+      { "union", SetExpression::Operation::Union },
+      { "intersect", SetExpression::Operation::Intersect },
+      { "complement", SetExpression::Operation::Complement },
+    };
+    std::mt19937 random(11);
+
+    std::cout << "key range: " << range << ", ms per operation (tree merge / adaptive)\n";
+    std::cout << std::setw(9) << "density" << std::setw(8) << "keys" << std::setw(9) << "storage";
+    for (const auto& operation : operations)
+    {
+      std::cout << std::setw(24) << operation.first;
+    }
+    std::cout << std::setw(16) << "bytes/key" << "\n";
+
+    for (double density : DENSITIES)
+    {
+      DataSetHandle leftData = makeDataSet("a", range, density, random);
+      DataSetHandle rightData = makeDataSet("b", range, density, random);
+      ExpressionHandle leftTree = std::make_shared< const SetExpression >(leftData);
+      ExpressionHandle rightTree = std::make_shared< const SetExpression >(rightData);
+      ExpressionHandle leftAdaptive = SetExpression::fromDataSet(leftData);
+      ExpressionHandle rightAdaptive = SetExpression::fromDataSet(rightData);
+
+      std::cout << std::setw(9) << density << std::setw(8) << leftData->size() << std::setw(9)
+                << (leftAdaptive->isDense() ? "dense" : "tree");
+      for (const auto& operation : operations)
+      {
+        double tree = timeOperation(operation.second, leftTree, rightTree, repetitions);
+        double adaptive = timeOperation(operation.second, leftAdaptive, rightAdaptive, repetitions);
+        std::cout << std::setw(11) << std::fixed << std::setprecision(3) << tree << " / " << std::setw(8) << adaptive
+                  << std::defaultfloat;
+      }
+
+      size_t treeBytes = sizeof(BinarySearchTreeNode< std::pair< int, DataSetValue > >);
+      size_t denseBytes = DenseDataSet::fromDataSet(*leftData)->memoryUsage() / std::max< size_t >(leftData->size(), 1);
+      std::cout << std::setw(8) << treeBytes << " / " << std::setw(5) << denseBytes << "\n";
+    }
+
+    return 0;
+  }
+}
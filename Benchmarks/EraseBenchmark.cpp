@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "AllocationCounter.h"
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "Dictionary.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    // Erases every key of a tree holding large values in random order. Erasing must only free nodes, so any
+    // allocation seen while it runs is a value being copied.
+    template < typename V >
+    void measure(const char* mode, size_t entryCount, const V& value)
+    {
+      std::vector< std::pair< int, V > > source;
+      source.reserve(entryCount);
+      for (size_t i = 0; i < entryCount; i++)
+      {
+        source.emplace_back(static_cast< int >(i), value);
+      }
+
+      dictionary< int, V > values;
+      values.assignSorted(source.cbegin(), source.cend());
+      source.clear();
+
+      std::vector< int > order(entryCount);
+      std::iota(order.begin(), order.end(), 0);
+      std::shuffle(order.begin(), order.end(), std::mt19937(7));
+
+      size_t countBefore = allocationCount();
+      size_t bytesBefore = allocatedBytes();
+      Stopwatch erase;
+      for (int key : order)
+      {
+        values.erase(key);
+      }
+      double eraseSeconds = erase.elapsedSeconds();
+
+      std::cout << mode << ": erase " << eraseSeconds * 1e9 / entryCount << " ns per entry, "
+                << static_cast< double >(allocationCount() - countBefore) / entryCount << " allocations and "
+                << static_cast< double >(allocatedBytes() - bytesBefore) / entryCount << " bytes per entry"
+                << (values.size() == 0 ? "" : ", tree not empty") << "\n";
+    }
+  }
+
+  // Usage: erase [entries = 100000] [value bytes = 4096] [nested entries = 64]
+  int runEraseBenchmark(int argc, char* argv[])
+  {
+    size_t entryCount = std::max< size_t >(argumentOr(argc, argv, 1, 100000), 1);
+    size_t valueBytes = argumentOr(argc, argv, 2, 4096);
+    size_t nestedCount = argumentOr(argc, argv, 3, 64);
+
+    dictionary< int, std::string > nested("nested");
+    for (size_t i = 0; i < nestedCount; i++)
+    {
+      nested.insert(static_cast< int >(i), std::string(valueBytes / std::max< size_t >(nestedCount, 1), 'n'));
+    }
+
+    std::cout << "entries: " << entryCount << ", value bytes: " << valueBytes << ", nested entries: " << nestedCount
+              << "\n";
+    measure< std::string >("std::string", entryCount, std::string(valueBytes, 'v'));
+    measure< dictionary< int, std::string > >("dictionary", entryCount, nested);
+
+    return 0;
+  }
+}
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "BinarySearchTree.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    // Draws lookupCount keys whose ranks follow a Zipf distribution of the given skew, the rank r key taking a share
+    // proportional to 1 / r^skew; skew 0 is uniform. Ranks are shuffled over the keys, so hot keys are scattered
+    // through the tree rather than sharing a path.
+    std::vector< int > zipfKeys(const std::vector< int >& keys, size_t lookupCount, double skew)
+    {
+      std::vector< double > cumulative(keys.size());
+      double sum = 0.0;
+      for (size_t rank = 0; rank < keys.size(); rank++)
+      {
+        sum += 1.0 / std::pow(static_cast< double >(rank + 1), skew);
+        cumulative[rank] = sum;
+      }
+
+      std::mt19937 random(29);
+      std::uniform_real_distribution< double > pick(0.0, sum);
+      std::vector< int > lookups(lookupCount);
+      for (int& key : lookups)
+      {
+        size_t rank = static_cast< size_t >(std::lower_bound(cumulative.cbegin(), cumulative.cend(), pick(random)) -
+          cumulative.cbegin());
+        key = keys[std::min(rank, keys.size() - 1)];
+      }
+
+      return lookups;
+    }
+
+    double nanosecondsPerFind(const BST< int, int >& tree, const std::vector< int >& lookups)
+    {
+      size_t hits = 0;
+      Stopwatch stopwatch;
+      for (int key : lookups)
+      {
+        hits += tree.find(key) != nullptr;
+      }
+      double nanoseconds = static_cast< double >(stopwatch.elapsedNanoseconds());
+      doNotOptimize(hits);
+
+      return nanoseconds / lookups.size();
+    }
+  }
+
+  // Usage: hotkeys [entries = 1000000] [lookups = 4000000] [slots = 4096]
+  // Looks up Zipf-distributed keys of growing skew in one tree without and with a lookup cache of the given slots,
+  // and reports nanoseconds per find and the cache's hit rate. Every looked up key is present.
+  int runHotKeyBenchmark(int argc, char* argv[])
+  {
+    size_t entryCount = std::max< size_t >(argumentOr(argc, argv, 1, 1000000), 1);
+    size_t lookupCount = std::max< size_t >(argumentOr(argc, argv, 2, 4000000), 1);
+    size_t slotCount = std::max< size_t >(argumentOr(argc, argv, 3, 4096), 1);
+
+    std::vector< int > keys(entryCount);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(23));
+    BST< int, int > tree;
+    for (int key : keys)
+    {
+      tree.insert(std::make_pair(key, key));
+    }
+    tree.resizeLookupCache(slotCount);
+
+    std::cout << "entries: " << entryCount << ", lookups: " << lookupCount << ", slots: "
+              << tree.lookupStatistics().m_Slots << ", ns per find\n";
+    std::cout << std::setw(6) << "skew" << std::setw(10) << "no cache" << std::setw(10) << "cache" << std::setw(10)
+              << "hit rate" << "\n";
+
+    const double skews[] = { 0.0, 0.6, 0.8, 0.99, 1.2 };
+    for (double skew : skews)
+    {
+      std::vector< int > lookups = zipfKeys(keys, lookupCount, skew);
+      tree.resizeLookupCache(0);
+      double withoutCache = nanosecondsPerFind(tree, lookups);
+      tree.resizeLookupCache(slotCount);
+      double withCache = nanosecondsPerFind(tree, lookups);
+      BST< int, int >::LookupStatistics statistics = tree.lookupStatistics();
+      double hitRate = static_cast< double >(statistics.m_Hits) / (statistics.m_Hits + statistics.m_Misses);
+
+      std::cout << std::setw(6) << skew << std::setw(10) << withoutCache << std::setw(10) << withCache << std::setw(9)
+                << hitRate * 100.0 << "%\n";
+    }
+
+    return 0;
+  }
+}
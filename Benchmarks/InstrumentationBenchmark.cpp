@@ -0,0 +1,94 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "BinarySearchTree.h"
+#include "CommandExecutor.h"
+
+namespace bavykin
+{
+  // Usage: instrumentation [lookups = 10000000] [commands = 1000000]
+  // Times the instrumented hot paths, tree lookups and command dispatch; build with and without
+  // BAVYKIN_INSTRUMENTATION and compare the two runs.
+  int runInstrumentationBenchmark(int argc, char* argv[])
+  {
+    size_t lookupCount = argumentOr(argc, argv, 1, 10000000);
+    size_t commandCount = argumentOr(argc, argv, 2, 1000000);
+    const int keyCount = 1 << 16;
+
+#ifdef BAVYKIN_INSTRUMENTATION
+    std::cout << "instrumentation: compiled in\n";
+#else
+    std::cout << "instrumentation: compiled out\n";
+#endif
+
+    std::vector< std::pair< int, int > > entries;
+    for (int key = 0; key < keyCount; key++)
+    {
+      entries.emplace_back(key * 2, key);
+    }
+    BST< int, int > tree;
+    tree.assignSorted(entries.cbegin(), entries.cend());
+
+    std::mt19937 random(5);
+    std::uniform_int_distribution< int > keys(0, keyCount * 2);
+    std::vector< int > lookups(1 << 16);
+    for (int& key : lookups)
+    {
+      key = keys(random);
+    }
+
+    size_t found = 0;
+    Stopwatch stopwatch;
+    for (size_t i = 0; i < lookupCount; i++)
+    {
+      found += tree.find(lookups[i & (lookups.size() - 1)]) != tree.end();
+    }
+    double findNanoseconds = static_cast< double >(stopwatch.elapsedNanoseconds()) / std::max< size_t >(lookupCount, 1);
+    doNotOptimize(found);
+
+    std::ostringstream dataSet;
+    for (int name = 0; name < 8; name++)
+    {
+      dataSet << "d" << name;
+      for (int key = 0; key < 64; key++)
+      {
+        dataSet << " " << key * (name + 1) << " v" << key;
+      }
+      dataSet << "\n";
+    }
+
+    const char* const operations[] = { "union", "intersect", "complement" };
+    std::vector< std::string > commands;
+    for (size_t i = 0; i < 4096; i++)
+    {
+      commands.push_back(i % 4 == 3 ? "print d" + std::to_string(i % 8)
+                                    : std::string(operations[i % 4]) + " d" + std::to_string(i % 8) + " d" +
+                                        std::to_string((i + 1) % 8) + " d" + std::to_string((i + 3) % 8));
+    }
+
+    NullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+    CommandExecutor executor(nullStream);
+    std::istringstream dataSetStream(dataSet.str());
+    executor.readFile(dataSetStream);
+
+    stopwatch.restart();
+    for (size_t i = 0; i < commandCount; i++)
+    {
+      executor.execute(commands[i % commands.size()]);
+    }
+    executor.flushOutput();
+    double commandNanoseconds =
+      static_cast< double >(stopwatch.elapsedNanoseconds()) / std::max< size_t >(commandCount, 1);
+
+    std::cout << "find ns/op: " << findNanoseconds << "\n";
+    std::cout << "command ns/op: " << commandNanoseconds << "\n";
+
+    return 0;
+  }
+}
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "BinarySearchTree.h"
+
+namespace bavykin
+{
+  // Usage: lookups [entries = 4000000] [lookups = 4000000]
+  // Compares one find per key with findBatch over batches of growing size. The default tree of int pairs takes
+  // a few hundred megabytes, well past any last-level cache, and half of the looked up keys are missing.
+  int runLookupBenchmark(int argc, char* argv[])
+  {
+    size_t entryCount = std::max< size_t >(argumentOr(argc, argv, 1, 4000000), 1);
+    size_t lookupCount = std::max< size_t >(argumentOr(argc, argv, 2, 4000000), 1);
+
+    std::vector< int > keys(entryCount);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(13));
+    BST< int, int > tree;
+    for (int key : keys)
+    {
+      tree.insert(std::make_pair(key * 2, key));
+    }
+
+    std::mt19937 random(17);
+    std::uniform_int_distribution< int > pick(0, static_cast< int >(entryCount) * 2 - 1);
+    std::vector< int > lookups(lookupCount);
+    for (int& key : lookups)
+    {
+      key = pick(random);
+    }
+
+    std::cout << "entries: " << entryCount << ", lookups: " << lookupCount << "\n";
+
+    size_t expected = 0;
+    Stopwatch sequential;
+    for (int key : lookups)
+    {
+      expected += tree.find(key) != tree.end();
+    }
+    double sequentialSeconds = sequential.elapsedSeconds();
+    std::cout << "find: " << lookupCount / sequentialSeconds / 1e6 << " M lookups/s\n";
+
+    const size_t batchSizes[] = { 16, 64, 256, 1024, 4096, 65536 };
+    std::vector< int > batch;
+    std::vector< bool > found;
+    for (size_t batchSize : batchSizes)
+    {
+      size_t hits = 0;
+      Stopwatch batched;
+      for (size_t first = 0; first < lookupCount; first += batchSize)
+      {
+        size_t last = std::min(first + batchSize, lookupCount);
+        batch.assign(lookups.cbegin() + first, lookups.cbegin() + last);
+        tree.containsBatch(batch, found);
+        hits += static_cast< size_t >(std::count(found.cbegin(), found.cend(), true));
+      }
+      double batchedSeconds = batched.elapsedSeconds();
+
+      std::cout << "containsBatch of " << batchSize << ": " << lookupCount / batchedSeconds / 1e6 << " M lookups/s, "
+                << sequentialSeconds / batchedSeconds << "x" << (hits == expected ? "" : ", results differ") << "\n";
+    }
+
+    return 0;
+  }
+}
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "Dictionary.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    using Dict = Dictionary< int, int >;
+    using Operation = Dict (Dict::*)(const Dict&) const;
+
+    double millisecondsFor(const Dict& left, const Dict& right, Operation operation)
+    {
+      Stopwatch stopwatch;
+      Dict result = (left.*operation)(right);
+      double milliseconds = static_cast< double >(stopwatch.elapsedNanoseconds()) / 1e6;
+      doNotOptimize(result.size());
+
+      return milliseconds;
+    }
+  }
+
+  // Usage: filters [large = 1000000] [small = 10000]
+  // Intersects and complements a large and a small dictionary, in both directions, with and without membership
+  // filters. A tenth of the small dictionary's keys are in the large one, so most probes miss, and the set operations
+  // probe the right operand once per entry of the left one.
+  int runMembershipFilterBenchmark(int argc, char* argv[])
+  {
+    size_t largeCount = std::max< size_t >(argumentOr(argc, argv, 1, 1000000), 1);
+    size_t smallCount = std::max< size_t >(argumentOr(argc, argv, 2, 10000), 1);
+
+    std::mt19937 random(41);
+    std::uniform_int_distribution< int > pick(0, static_cast< int >(std::min< size_t >(largeCount * 8, 1 << 30)));
+    std::unordered_set< int > largeKeys;
+    while (largeKeys.size() < largeCount)
+    {
+      largeKeys.insert(pick(random));
+    }
+    std::vector< int > shared(largeKeys.cbegin(), largeKeys.cend());
+    std::shuffle(shared.begin(), shared.end(), random);
+
+    Dict large("large");
+    for (int key : largeKeys)
+    {
+      large.insert(key, key);
+    }
+    Dict small("small");
+    for (size_t i = 0; small.size() < smallCount; i++)
+    {
+      int key = i % 10 == 0 ? shared[i / 10 % shared.size()] : pick(random);
+      if (i % 10 == 0 || largeKeys.count(key) == 0)
+      {
+        small.insert(key, key);
+      }
+    }
+
+    std::cout << "large: " << large.size() << " entries, small: " << small.size() << " entries, ms per operation\n";
+    std::cout << std::setw(22) << "" << std::setw(10) << "no filter" << std::setw(10) << "filter" << "\n";
+
+    struct Case
+    {
+      std::string m_Name;
+      const Dict& m_Left;
+      const Dict& m_Right;
+      Operation m_Operation;
+    };
+    const Case cases[] = { { "small intersect large", small, large, &Dict::getIntersect },
+      { "large intersect small", large, small, &Dict::getIntersect },
+      { "small complement large", small, large, &Dict::getComplement },
+      { "large complement small", large, small, &Dict::getComplement } };
+
+    for (const Case& current : cases)
+    {
+      large.useMembershipFilter(false);
+      small.useMembershipFilter(false);
+      double withoutFilter = millisecondsFor(current.m_Left, current.m_Right, current.m_Operation);
+      large.useMembershipFilter(true);
+      small.useMembershipFilter(true);
+      double withFilter = millisecondsFor(current.m_Left, current.m_Right, current.m_Operation);
+
+      std::cout << std::setw(22) << current.m_Name << std::setw(10) << withoutFilter << std::setw(10) << withFilter
+                << "\n";
+    }
+
+    return 0;
+  }
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "BinarySearchTree.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    enum class Operation
+    {
+      Insert,
+      Erase,
+      Find
+    };
+
+    struct Step
+    {
+      Operation m_Operation;
+      int m_Key;
+    };
+
+    struct Mix
+    {
+      const char* m_Name;
+      int m_InsertPercent;
+      int m_ErasePercent;
+    };
+
+    std::vector< Step > makeSteps(const Mix& mix, size_t operationCount, int keyRange)
+    {
+      std::mt19937 random(23);
+      std::uniform_int_distribution< int > percent(0, 99);
+      std::uniform_int_distribution< int > key(0, keyRange - 1);
+
+      std::vector< Step > steps(operationCount);
+      for (Step& step : steps)
+      {
+        int roll = percent(random);
+        step.m_Operation = roll < mix.m_InsertPercent ? Operation::Insert
+          : roll < mix.m_InsertPercent + mix.m_ErasePercent ? Operation::Erase
+                                                             : Operation::Find;
+        step.m_Key = key(random);
+      }
+
+      return steps;
+    }
+
+    struct Result
+    {
+      double m_Nanoseconds;
+      size_t m_Height;
+      bool m_Valid;
+    };
+
+    // Fills the tree with every other key of the range in random order, then replays the steps.
+    template < class Balance >
+    Result replay(const std::vector< Step >& steps, int keyRange)
+    {
+      std::vector< int > keys;
+      for (int key = 0; key < keyRange; key += 2)
+      {
+        keys.push_back(key);
+      }
+      std::shuffle(keys.begin(), keys.end(), std::mt19937(29));
+
+      BST< int, int, std::less< int >, Balance > tree;
+      for (int key : keys)
+      {
+        tree.insert(std::make_pair(key, key));
+      }
+
+      size_t hits = 0;
+      Stopwatch stopwatch;
+      for (const Step& step : steps)
+      {
+        switch (step.m_Operation)
+        {
+        case Operation::Insert:
+          tree.insert(std::make_pair(step.m_Key, step.m_Key));
+          break;
+        case Operation::Erase:
+          tree.erase(step.m_Key);
+          break;
+        case Operation::Find:
+          hits += tree.find(step.m_Key) != tree.end();
+          break;
+        }
+      }
+      uint64_t elapsed = stopwatch.elapsedNanoseconds();
+      doNotOptimize(hits);
+
+      typename BST< int, int, std::less< int >, Balance >::ShapeStatistics shape = tree.shapeStats();
+      return { static_cast< double >(elapsed) / steps.size(), shape.m_Height, shape.isValid() };
+    }
+  }
+
+  // Usage: policies [operations = 2000000] [key range = 400000]
+  // Replays the same insert-heavy, erase-heavy and lookup-heavy operation streams on a tree under each balance
+  // policy, starting half full, and reports nanoseconds per operation and the final height.
+  int runPolicyBenchmark(int argc, char* argv[])
+  {
+    size_t operationCount = std::max< size_t >(argumentOr(argc, argv, 1, 2000000), 1);
+    int keyRange = static_cast< int >(std::max< size_t >(argumentOr(argc, argv, 2, 400000), 2));
+    const Mix mixes[] = { { "insert-heavy", 70, 20 }, { "erase-heavy", 20, 70 }, { "lookup-heavy", 5, 5 } };
+
+    std::cout << "operations: " << operationCount << ", key range: " << keyRange << ", ns per operation (height)\n";
+    std::cout << std::setw(14) << "mix" << std::setw(18) << "avl" << std::setw(18) << "red-black" << "\n";
+    for (const Mix& mix : mixes)
+    {
+      std::vector< Step > steps = makeSteps(mix, operationCount, keyRange);
+      Result avl = replay< AvlBalance >(steps, keyRange);
+      Result redBlack = replay< RedBlackBalance >(steps, keyRange);
+
+      std::cout << std::setw(14) << mix.m_Name;
+      for (const Result& result : { avl, redBlack })
+      {
+        std::cout << std::setw(10) << std::fixed << std::setprecision(1) << result.m_Nanoseconds << " ("
+                  << std::setw(3) << result.m_Height << ")" << (result.m_Valid ? "  " : "!!");
+      }
+      std::cout << "\n";
+    }
+
+    return 0;
+  }
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "BinarySearchTree.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    // Walks the whole tree forwards and then backwards the given number of times and reports nanoseconds per
+    // visited entry for each direction.
+    void measure(const char* layout, const BST< int, int >& tree, size_t passCount)
+    {
+      using const_iterator = BST< int, int >::const_iterator;
+
+      const_iterator last(tree.find(static_cast< int >(tree.size()) - 1).m_Current);
+      uint64_t sum = 0;
+
+      Stopwatch forward;
+      for (size_t pass = 0; pass < passCount; pass++)
+      {
+        for (const_iterator i = tree.cbegin(); i != tree.cend(); ++i)
+        {
+          sum += static_cast< uint64_t >(i->second);
+        }
+      }
+      double forwardNanoseconds = static_cast< double >(forward.elapsedNanoseconds()) / (passCount * tree.size());
+
+      Stopwatch backward;
+      for (size_t pass = 0; pass < passCount; pass++)
+      {
+        for (const_iterator i = last; i != tree.cend(); --i)
+        {
+          sum += static_cast< uint64_t >(i->second);
+        }
+      }
+      double backwardNanoseconds = static_cast< double >(backward.elapsedNanoseconds()) / (passCount * tree.size());
+      doNotOptimize(sum);
+
+      std::cout << layout << ": forward " << forwardNanoseconds << " ns per entry, backward " << backwardNanoseconds
+                << " ns per entry\n";
+    }
+  }
+
+  // Usage: scan [entries = 1000000] [passes = 10]
+  // Times full in-order scans; build with and without BAVYKIN_THREADED_TREE and compare the two runs.
+  int runScanBenchmark(int argc, char* argv[])
+  {
+    size_t entryCount = std::max< size_t >(argumentOr(argc, argv, 1, 1000000), 1);
+    size_t passCount = std::max< size_t >(argumentOr(argc, argv, 2, 10), 1);
+
+#ifdef BAVYKIN_THREADED_TREE
+    std::cout << "threaded links: compiled in\n";
+#else
+    std::cout << "threaded links: compiled out\n";
+#endif
+    std::cout << "entries: " << entryCount << ", passes: " << passCount << "\n";
+
+    std::vector< std::pair< int, int > > entries;
+    entries.reserve(entryCount);
+    for (size_t i = 0; i < entryCount; i++)
+    {
+      entries.emplace_back(static_cast< int >(i), static_cast< int >(i));
+    }
+
+    BST< int, int > sorted;
+    sorted.assignSorted(entries.cbegin(), entries.cend());
+    measure("built from sorted", sorted, passCount);
+
+    // Inserting in random order scatters the nodes over the heap the way a long-lived dataset ends up.
+    std::shuffle(entries.begin(), entries.end(), std::mt19937(11));
+    BST< int, int > scattered;
+    for (const std::pair< int, int >& entry : entries)
+    {
+      scattered.insert(entry);
+    }
+    measure("random inserts", scattered, passCount);
+
+    return 0;
+  }
+}
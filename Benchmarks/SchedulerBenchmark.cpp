@@ -0,0 +1,108 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "CommandExecutor.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    const char* const OPERATIONS[] = { "union", "intersect", "complement" };
+
+    std::string makeBaseDataSets(size_t dataSets, size_t entries, std::mt19937& random)
+    {
+      std::uniform_int_distribution< int > keys(0, static_cast< int >(entries * 2));
+      std::ostringstream out;
+
+      for (size_t i = 0; i < dataSets; i++)
+      {
+        out << "d" << i;
+        for (size_t j = 0; j < entries; j++)
+        {
+          out << " " << keys(random) << " v" << j % 16;
+        }
+        out << "\n";
+      }
+
+      return out.str();
+    }
+
+    // Mostly independent set operations into fresh targets, every tenth command reuses an earlier result and every
+    // twentieth prints one, so the scheduler has both wide parallelism and real dependency chains to respect.
+    std::string makeScript(size_t commands, size_t dataSets, std::mt19937& random)
+    {
+      std::uniform_int_distribution< size_t > names(0, dataSets - 1);
+      std::uniform_int_distribution< size_t > operations(0, 2);
+      std::ostringstream out;
+
+      for (size_t i = 0; i < commands; i++)
+      {
+        std::string left = "d" + std::to_string(names(random));
+        if (i % 10 == 9)
+        {
+          left = "r" + std::to_string(i - 9);
+        }
+
+        if (i % 20 == 19)
+        {
+          out << "print r" << i - 1 << "\n";
+        }
+        else
+        {
+          out << OPERATIONS[operations(random)] << " r" << i << " " << left << " d" << names(random) << "\n";
+        }
+      }
+
+      return out.str();
+    }
+  }
+
+  // Usage: schedule [commands = 5000] [datasets = 64] [entries per dataset = 64] [threads = hardware]
+  int runSchedulerBenchmark(int argc, char* argv[])
+  {
+    size_t commandCount = argumentOr(argc, argv, 1, 5000);
+    size_t dataSetCount = std::max< size_t >(argumentOr(argc, argv, 2, 64), 1);
+    size_t entryCount = argumentOr(argc, argv, 3, 64);
+    size_t threadCount = argumentOr(argc, argv, 4, std::thread::hardware_concurrency());
+
+    std::mt19937 random(7);
+    std::string dataSet = makeBaseDataSets(dataSetCount, entryCount, random);
+    std::string script = makeScript(commandCount, dataSetCount, random);
+
+    std::string outputs[2];
+    double seconds[2] = {};
+    for (int parallel = 0; parallel < 2; parallel++)
+    {
+      std::istringstream dataSetStream(dataSet);
+      std::istringstream commands(script);
+      std::ostringstream output;
+      CommandExecutor executor(output);
+      executor.readFile(dataSetStream);
+
+      Stopwatch total;
+      if (parallel)
+      {
+        executor.executeParallel(commands, threadCount);
+      }
+      else
+      {
+        executor.execute(commands);
+      }
+      seconds[parallel] = total.elapsedSeconds();
+      outputs[parallel] = output.str();
+    }
+
+    std::cout << "commands: " << commandCount << "\n";
+    std::cout << "threads: " << threadCount << "\n";
+    std::cout << "serial seconds: " << seconds[0] << "\n";
+    std::cout << "parallel seconds: " << seconds[1] << "\n";
+    std::cout << "speedup: " << seconds[0] / seconds[1] << "\n";
+    std::cout << "outputs match: " << (outputs[0] == outputs[1] ? "yes" : "no") << "\n";
+
+    return outputs[0] == outputs[1] ? 0 : 3;
+  }
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "BinarySearchTree.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    // Same order as std::less< std::string >, but the tree only sees a less-than operator, so every search step
+    // asks it twice, the way all descents did before three-way comparison.
+    struct LessThanOnly
+    {
+      bool operator()(const std::string& left, const std::string& right) const
+      {
+        return left < right;
+      }
+    };
+
+    struct Timings
+    {
+      double m_Insert;
+      double m_Find;
+      double m_Erase;
+    };
+
+    template < class Compare >
+    Timings measure(const std::vector< std::string >& keys, const std::vector< std::string >& lookups)
+    {
+      BST< std::string, int, Compare > tree;
+      Timings timings = {};
+
+      Stopwatch insert;
+      for (size_t i = 0; i < keys.size(); i++)
+      {
+        tree.insert(std::make_pair(keys[i], static_cast< int >(i)));
+      }
+      timings.m_Insert = static_cast< double >(insert.elapsedNanoseconds()) / keys.size();
+
+      size_t hits = 0;
+      Stopwatch find;
+      for (const std::string& key : lookups)
+      {
+        hits += tree.find(key) != tree.end();
+      }
+      timings.m_Find = static_cast< double >(find.elapsedNanoseconds()) / lookups.size();
+      doNotOptimize(hits);
+
+      Stopwatch erase;
+      for (size_t i = 0; i < keys.size(); i += 2)
+      {
+        tree.erase(keys[i]);
+      }
+      timings.m_Erase = static_cast< double >(erase.elapsedNanoseconds()) / ((keys.size() + 1) / 2);
+
+      return timings;
+    }
+  }
+
+  // Usage: strings [entries = 200000] [lookups = 1000000] [prefix length = 16]
+  // Keys share a long common prefix, as dataset and command names do, so each comparison scans most of it. Compares
+  // std::less< std::string >, which the tree asks three-way through std::string::compare, with a less-than-only
+  // comparator of the same order.
+  int runStringKeyBenchmark(int argc, char* argv[])
+  {
+    size_t entryCount = std::max< size_t >(argumentOr(argc, argv, 1, 200000), 1);
+    size_t lookupCount = std::max< size_t >(argumentOr(argc, argv, 2, 1000000), 1);
+    size_t prefixLength = argumentOr(argc, argv, 3, 16);
+
+    std::string prefix(prefixLength, 'd');
+    std::vector< std::string > keys;
+    keys.reserve(entryCount);
+    for (size_t i = 0; i < entryCount; i++)
+    {
+      keys.push_back(prefix + std::to_string(i * 2));
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(31));
+
+    std::mt19937 random(37);
+    std::uniform_int_distribution< size_t > pick(0, entryCount * 2 - 1);
+    std::vector< std::string > lookups;
+    lookups.reserve(lookupCount);
+    for (size_t i = 0; i < lookupCount; i++)
+    {
+      lookups.push_back(prefix + std::to_string(pick(random)));
+    }
+
+    Timings threeWay = measure< std::less< std::string > >(keys, lookups);
+    Timings lessThan = measure< LessThanOnly >(keys, lookups);
+
+    std::cout << "entries: " << entryCount << ", lookups: " << lookupCount << ", key prefix: " << prefixLength
+              << " characters, ns per operation\n";
+    std::cout << std::setw(10) << "" << std::setw(12) << "three-way" << std::setw(12) << "less-than" << "\n";
+    std::cout << std::setw(10) << "insert" << std::setw(12) << threeWay.m_Insert << std::setw(12) << lessThan.m_Insert
+              << "\n";
+    std::cout << std::setw(10) << "find" << std::setw(12) << threeWay.m_Find << std::setw(12) << lessThan.m_Find
+              << "\n";
+    std::cout << std::setw(10) << "erase" << std::setw(12) << threeWay.m_Erase << std::setw(12) << lessThan.m_Erase
+              << "\n";
+
+    return 0;
+  }
+}
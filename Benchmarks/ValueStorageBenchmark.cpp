@@ -0,0 +1,89 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "AllocationCounter.h"
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+#include "Dictionary.h"
+#include "StringPool.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    std::vector< std::string > makeVocabulary(size_t size, size_t minimumLength)
+    {
+      std::vector< std::string > words = { "name", "surname", "mouse", "keyboard" };
+      for (size_t i = words.size(); i < size; i++)
+      {
+        words.push_back("word" + std::to_string(i));
+      }
+
+      words.resize(size);
+      for (std::string& word : words)
+      {
+        if (word.size() < minimumLength)
+        {
+          word.append(minimumLength - word.size(), '_');
+        }
+      }
+
+      return words;
+    }
+
+    // Builds one dataset of the given value type from sorted entries and reports the bytes its nodes (and, for plain
+    // strings, their out-of-line buffers) requested, then times copying every value out as a set operation does.
+    template < typename V >
+    void measure(const char* mode, size_t entryCount, const std::vector< std::string >& words)
+    {
+      std::mt19937 random(7);
+      std::uniform_int_distribution< size_t > pick(0, words.size() - 1);
+      std::vector< std::pair< int, V > > source;
+      source.reserve(entryCount);
+      for (size_t i = 0; i < entryCount; i++)
+      {
+        source.emplace_back(static_cast< int >(i), V(words[pick(random)]));
+      }
+
+      dictionary< int, V > values;
+      size_t bytesBefore = allocatedBytes();
+      Stopwatch build;
+      values.assignSorted(source.cbegin(), source.cend());
+      double buildSeconds = build.elapsedSeconds();
+      size_t treeBytes = allocatedBytes() - bytesBefore;
+
+      std::vector< std::pair< int, V > > copied;
+      copied.reserve(entryCount);
+      Stopwatch copy;
+      for (auto i = values.cbegin(); i != values.cend(); ++i)
+      {
+        copied.push_back(i.m_Current->m_Content);
+      }
+      double copySeconds = copy.elapsedSeconds();
+
+      std::cout << mode << ": " << static_cast< double >(treeBytes) / entryCount << " bytes per entry, build "
+                << buildSeconds << " s, copy values " << copySeconds << " s\n";
+    }
+  }
+
+  // Usage: values [entries = 10000000] [distinct values = 1000] [minimum value length = 0]
+  int runValueStorageBenchmark(int argc, char* argv[])
+  {
+    size_t entryCount = std::max< size_t >(argumentOr(argc, argv, 1, 10000000), 1);
+    size_t vocabularySize = std::max< size_t >(argumentOr(argc, argv, 2, 1000), 1);
+    size_t minimumLength = argumentOr(argc, argv, 3, 0);
+    std::vector< std::string > words = makeVocabulary(vocabularySize, minimumLength);
+
+    std::cout << "entries: " << entryCount << ", distinct values: " << vocabularySize << "\n";
+    measure< std::string >("std::string", entryCount, words);
+    measure< InternedString >("interned", entryCount, words);
+
+    const StringPool& pool = StringPool::instance();
+    std::cout << "string pool: " << pool.size() << " ids, " << pool.memoryUsage() << " bytes ("
+              << static_cast< double >(pool.memoryUsage()) / entryCount << " bytes per entry)\n";
+
+    return 0;
+  }
+}
@@ -0,0 +1,65 @@
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include "Benchmarks.h"
+
+using namespace bavykin;
+
+struct BenchmarkEntry
+{
+  const char* m_Name;
+  int (*m_Function)(int argc, char* argv[]);
+};
+
+const BenchmarkEntry BENCHMARKS[] = {
+  { "replay", &runCommandReplayBenchmark },
+  { "pipeline", &runPipelineBenchmark },
+  { "schedule", &runSchedulerBenchmark },
+  { "allocations", &runAllocationBenchmark },
+  { "values", &runValueStorageBenchmark },
+  { "density", &runDensityBenchmark },
+  { "containers", &runContainerBenchmark },
+  { "instrumentation", &runInstrumentationBenchmark },
+  { "erase", &runEraseBenchmark },
+  { "scan", &runScanBenchmark },
+  { "lookups", &runLookupBenchmark },
+  { "batches", &runBatchInsertBenchmark },
+  { "policies", &runPolicyBenchmark },
+  { "concurrent", &runConcurrentMapBenchmark },
+  { "strings", &runStringKeyBenchmark },
+  { "hotkeys", &runHotKeyBenchmark },
+  { "filters", &runMembershipFilterBenchmark },
+};
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: Benchmarks <name> [arguments...]\nAvailable:";
+    for (const BenchmarkEntry& entry : BENCHMARKS)
+    {
+      std::cerr << " " << entry.m_Name;
+    }
+    std::cerr << std::endl;
+    return 1;
+  }
+
+  try
+  {
+    for (const BenchmarkEntry& entry : BENCHMARKS)
+    {
+      if (std::strcmp(entry.m_Name, argv[1]) == 0)
+      {
+        return entry.m_Function(argc - 1, argv + 1);
+      }
+    }
+  }
+  catch (const std::exception& exception)
+  {
+    std::cerr << exception.what() << std::endl;
+    return 2;
+  }
+
+  std::cerr << "Unknown benchmark '" << argv[1] << "'." << std::endl;
+  return 1;
+}
@@ -0,0 +1,401 @@
+#ifndef BALANCE_POLICY_H
+#define BALANCE_POLICY_H
+#include "Instrumentation.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace bavykin
+{
+  // A balance policy keeps a BinarySearchTree balanced through the m_Balance field of its nodes, which only the
+  // policy interprets. The tree links and unlinks nodes itself and then calls:
+  //   initializeBuilt(value, depth, height) on every node of a perfectly balanced tree, children first;
+  //   afterInsert(root, value) once value is linked in as a new leaf;
+  //   afterErase(root, child, parent, removed) once a node is unlinked, where child now fills the vacated position
+  //     under parent and removed is the m_Balance that position held;
+  //   countViolations(root) to check the invariant for shapeStats.
+  // Policies rotate through TreeRotations, which keeps parent links and the root pointer in step.
+  class TreeRotations
+  {
+  protected:
+    template < class Node >
+    static void replaceChild(Node*& root, Node* parent, Node* child, Node* replacement) noexcept;
+    template < class Node >
+    static Node* rotateLeft(Node*& root, Node* value) noexcept;
+    template < class Node >
+    static Node* rotateRight(Node*& root, Node* value) noexcept;
+  };
+
+  // Height-balanced trees: m_Balance is the height of the node's subtree and sibling subtrees differ in height by
+  // at most one. Lookups are the fastest of the policies; updates rotate more often than red-black ones.
+  class AvlBalance: private TreeRotations
+  {
+  public:
+    template < class Node >
+    static void initializeBuilt(Node* value, size_t depth, size_t height) noexcept;
+    template < class Node >
+    static void afterInsert(Node*& root, Node* value) noexcept;
+    template < class Node >
+    static void afterErase(Node*& root, Node* child, Node* parent, int removed) noexcept;
+    template < class Node >
+    static size_t countViolations(const Node* root) noexcept;
+
+  private:
+    template < class Node >
+    static int heightOf(const Node* value) noexcept;
+    template < class Node >
+    static void updateHeight(Node* value) noexcept;
+    template < class Node >
+    static Node* rotate(Node*& root, Node* value, bool toLeft) noexcept;
+    template < class Node >
+    static Node* rebalance(Node*& root, Node* value) noexcept;
+    template < class Node >
+    static void retrace(Node*& root, Node* value) noexcept;
+    template < class Node >
+    static int inspect(const Node* value, size_t& violations) noexcept;
+  };
+
+  // Red-black trees: m_Balance is the colour, every path down to a leaf has the same number of black nodes and no
+  // red node has a red child. Any update needs at most three rotations, at the price of trees up to twice as deep
+  // as the perfectly balanced one.
+  class RedBlackBalance: private TreeRotations
+  {
+  public:
+    template < class Node >
+    static void initializeBuilt(Node* value, size_t depth, size_t height) noexcept;
+    template < class Node >
+    static void afterInsert(Node*& root, Node* value) noexcept;
+    template < class Node >
+    static void afterErase(Node*& root, Node* child, Node* parent, int removed) noexcept;
+    template < class Node >
+    static size_t countViolations(const Node* root) noexcept;
+
+  private:
+    static constexpr int BLACK = 0;
+    static constexpr int RED = 1;
+
+    template < class Node >
+    static bool isRed(const Node* value) noexcept;
+    template < class Node >
+    static int inspect(const Node* value, size_t& violations) noexcept;
+  };
+
+  template < class Node >
+  void TreeRotations::replaceChild(Node*& root, Node* parent, Node* child, Node* replacement) noexcept
+  {
+    if (parent == nullptr)
+    {
+      root = replacement;
+    }
+    else if (parent->m_Left == child)
+    {
+      parent->m_Left = replacement;
+    }
+    else
+    {
+      parent->m_Right = replacement;
+    }
+  }
+
+  template < class Node >
+  Node* TreeRotations::rotateLeft(Node*& root, Node* value) noexcept
+  {
+    BAVYKIN_COUNT(Rotations, 1);
+    Node* pivot = value->m_Right;
+    value->m_Right = pivot->m_Left;
+    if (value->m_Right != nullptr)
+    {
+      value->m_Right->m_Parent = value;
+    }
+    pivot->m_Parent = value->m_Parent;
+    replaceChild(root, value->m_Parent, value, pivot);
+    pivot->m_Left = value;
+    value->m_Parent = pivot;
+
+    return pivot;
+  }
+
+  template < class Node >
+  Node* TreeRotations::rotateRight(Node*& root, Node* value) noexcept
+  {
+    BAVYKIN_COUNT(Rotations, 1);
+    Node* pivot = value->m_Left;
+    value->m_Left = pivot->m_Right;
+    if (value->m_Left != nullptr)
+    {
+      value->m_Left->m_Parent = value;
+    }
+    pivot->m_Parent = value->m_Parent;
+    replaceChild(root, value->m_Parent, value, pivot);
+    pivot->m_Right = value;
+    value->m_Parent = pivot;
+
+    return pivot;
+  }
+
+  template < class Node >
+  void AvlBalance::initializeBuilt(Node* value, size_t, size_t) noexcept
+  {
+    updateHeight(value);
+  }
+
+  template < class Node >
+  void AvlBalance::afterInsert(Node*& root, Node* value) noexcept
+  {
+    retrace(root, value->m_Parent);
+  }
+
+  template < class Node >
+  void AvlBalance::afterErase(Node*& root, Node*, Node* parent, int) noexcept
+  {
+    retrace(root, parent);
+  }
+
+  template < class Node >
+  size_t AvlBalance::countViolations(const Node* root) noexcept
+  {
+    size_t violations = 0;
+    inspect(root, violations);
+
+    return violations;
+  }
+
+  template < class Node >
+  int AvlBalance::heightOf(const Node* value) noexcept
+  {
+    return value == nullptr ? 0 : value->m_Balance;
+  }
+
+  template < class Node >
+  void AvlBalance::updateHeight(Node* value) noexcept
+  {
+    value->m_Balance = std::max(heightOf(value->m_Left), heightOf(value->m_Right)) + 1;
+  }
+
+  template < class Node >
+  Node* AvlBalance::rotate(Node*& root, Node* value, bool toLeft) noexcept
+  {
+    Node* pivot = toLeft ? rotateLeft(root, value) : rotateRight(root, value);
+    updateHeight(value);
+    updateHeight(pivot);
+
+    return pivot;
+  }
+
+  // Restores the balance of value's subtree, whose children are balanced and differ in height by at most two, and
+  // returns the node now at its top. A child leaning the other way calls for a double rotation.
+  template < class Node >
+  Node* AvlBalance::rebalance(Node*& root, Node* value) noexcept
+  {
+    updateHeight(value);
+    int balance = heightOf(value->m_Left) - heightOf(value->m_Right);
+
+    if (balance > 1)
+    {
+      if (heightOf(value->m_Left->m_Left) < heightOf(value->m_Left->m_Right))
+      {
+        rotate(root, value->m_Left, true);
+      }
+      return rotate(root, value, false);
+    }
+
+    if (balance < -1)
+    {
+      if (heightOf(value->m_Right->m_Right) < heightOf(value->m_Right->m_Left))
+      {
+        rotate(root, value->m_Right, false);
+      }
+      return rotate(root, value, true);
+    }
+
+    return value;
+  }
+
+  // Walks from value towards the root and stops at the first subtree that kept its height, which after an insertion
+  // is a couple of levels up on average.
+  template < class Node >
+  void AvlBalance::retrace(Node*& root, Node* value) noexcept
+  {
+    while (value != nullptr)
+    {
+      Node* parent = value->m_Parent;
+      int height = value->m_Balance;
+      if (rebalance(root, value)->m_Balance == height)
+      {
+        return;
+      }
+      value = parent;
+    }
+  }
+
+  template < class Node >
+  int AvlBalance::inspect(const Node* value, size_t& violations) noexcept
+  {
+    if (value == nullptr)
+    {
+      return 0;
+    }
+
+    int left = inspect(value->m_Left, violations);
+    int right = inspect(value->m_Right, violations);
+    int height = std::max(left, right) + 1;
+    if (left - right > 1 || right - left > 1 || value->m_Balance != height)
+    {
+      violations++;
+    }
+
+    return height;
+  }
+
+  // Colours the lowest level of a perfectly balanced tree red and everything above it black, so every path holds
+  // height - 1 black nodes whether or not it reaches the lowest level.
+  template < class Node >
+  void RedBlackBalance::initializeBuilt(Node* value, size_t depth, size_t height) noexcept
+  {
+    value->m_Balance = depth != 0 && depth + 1 == height ? RED : BLACK;
+  }
+
+  template < class Node >
+  void RedBlackBalance::afterInsert(Node*& root, Node* value) noexcept
+  {
+    value->m_Balance = RED;
+    while (isRed(value->m_Parent))
+    {
+      Node* parent = value->m_Parent;
+      Node* grandparent = parent->m_Parent;
+      bool parentIsLeft = parent == grandparent->m_Left;
+      Node* uncle = parentIsLeft ? grandparent->m_Right : grandparent->m_Left;
+
+      if (isRed(uncle))
+      {
+        parent->m_Balance = BLACK;
+        uncle->m_Balance = BLACK;
+        grandparent->m_Balance = RED;
+        value = grandparent;
+        continue;
+      }
+
+      if (value == (parentIsLeft ? parent->m_Right : parent->m_Left))
+      {
+        value = parent;
+        parent = parentIsLeft ? rotateLeft(root, value) : rotateRight(root, value);
+      }
+      parent->m_Balance = BLACK;
+      grandparent->m_Balance = RED;
+      if (parentIsLeft)
+      {
+        rotateRight(root, grandparent);
+      }
+      else
+      {
+        rotateLeft(root, grandparent);
+      }
+    }
+    root->m_Balance = BLACK;
+  }
+
+  // Removing a black node leaves the paths through child one black node short. The loop moves that deficit up
+  // until child is red, where recolouring it black settles it, or a rotation around the sibling absorbs it.
+  template < class Node >
+  void RedBlackBalance::afterErase(Node*& root, Node* child, Node* parent, int removed) noexcept
+  {
+    if (removed != BLACK)
+    {
+      return;
+    }
+
+    while (child != root && !isRed(child))
+    {
+      bool childIsLeft = child == parent->m_Left;
+      Node* sibling = childIsLeft ? parent->m_Right : parent->m_Left;
+
+      if (isRed(sibling))
+      {
+        sibling->m_Balance = BLACK;
+        parent->m_Balance = RED;
+        if (childIsLeft)
+        {
+          rotateLeft(root, parent);
+        }
+        else
+        {
+          rotateRight(root, parent);
+        }
+        sibling = childIsLeft ? parent->m_Right : parent->m_Left;
+      }
+
+      Node* nearNephew = childIsLeft ? sibling->m_Left : sibling->m_Right;
+      Node* farNephew = childIsLeft ? sibling->m_Right : sibling->m_Left;
+      if (!isRed(nearNephew) && !isRed(farNephew))
+      {
+        sibling->m_Balance = RED;
+        child = parent;
+        parent = child->m_Parent;
+        continue;
+      }
+
+      if (!isRed(farNephew))
+      {
+        nearNephew->m_Balance = BLACK;
+        sibling->m_Balance = RED;
+        sibling = childIsLeft ? rotateRight(root, sibling) : rotateLeft(root, sibling);
+        farNephew = childIsLeft ? sibling->m_Right : sibling->m_Left;
+      }
+      sibling->m_Balance = parent->m_Balance;
+      parent->m_Balance = BLACK;
+      farNephew->m_Balance = BLACK;
+      if (childIsLeft)
+      {
+        rotateLeft(root, parent);
+      }
+      else
+      {
+        rotateRight(root, parent);
+      }
+      child = root;
+    }
+
+    if (child != nullptr)
+    {
+      child->m_Balance = BLACK;
+    }
+  }
+
+  template < class Node >
+  size_t RedBlackBalance::countViolations(const Node* root) noexcept
+  {
+    size_t violations = isRed(root) ? 1 : 0;
+    inspect(root, violations);
+
+    return violations;
+  }
+
+  template < class Node >
+  bool RedBlackBalance::isRed(const Node* value) noexcept
+  {
+    return value != nullptr && value->m_Balance == RED;
+  }
+
+  // Returns the number of black nodes on the paths below value, counting the empty leaves as one.
+  template < class Node >
+  int RedBlackBalance::inspect(const Node* value, size_t& violations) noexcept
+  {
+    if (value == nullptr)
+    {
+      return 1;
+    }
+
+    int left = inspect(value->m_Left, violations);
+    int right = inspect(value->m_Right, violations);
+    if (left != right || (value->m_Balance != RED && value->m_Balance != BLACK))
+    {
+      violations++;
+    }
+    if (isRed(value) && (isRed(value->m_Left) || isRed(value->m_Right)))
+    {
+      violations++;
+    }
+
+    return std::max(left, right) + (isRed(value) ? 0 : 1);
+  }
+}
+#endif
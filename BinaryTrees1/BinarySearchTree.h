@@ -1,37 +1,96 @@
 #ifndef BINARY_SEARCH_TREE_H
 #define BINARY_SEARCH_TREE_H
+#include "BalancePolicy.h"
 #include "BinarySearchTreeIterator.h"
 #include "BinarySearchTreeNode.h"
+#include "BloomFilter.h"
+#include "Instrumentation.h"
+#include "LookupCache.h"
+#include "Prefetch.h"
+#include "ThreeWayCompare.h"
+#include <algorithm>
+#include <cmath>
 #include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace bavykin
 {
-  template < class Key, class Value, class Compare = std::less< Key > >
+  // Balance is the balance policy, AvlBalance or RedBlackBalance; see BalancePolicy.h for what a policy provides.
+  template < class Key, class Value, class Compare = std::less< Key >, class Balance = AvlBalance >
   class BinarySearchTree
   {
   public:
     using content_type = std::pair< Key, Value >;
-    using Node = typename BinarySearchTreeNode< content_type >;
+    using Node = BinarySearchTreeNode< content_type >;
     using iterator = BinarySearchTreeIterator< content_type, false >;
     using const_iterator = BinarySearchTreeIterator< content_type, true >;
+    using LookupStatistics = typename LookupCache< Key, Node >::Statistics;
+
+    // How insertBatch merges: by hinted inserts in key order, by rebuilding the tree from the merged sequence, or by
+    // whichever of the two the cost model expects to be cheaper.
+    enum class BatchStrategy
+    {
+      Automatic,
+      Incremental,
+      Rebuild
+    };
+
+    // Shape of the tree as measured by one pass over every node. Depths count edges from the root; the height
+    // counts levels, so it is the maximum depth plus one for a non-empty tree.
+    struct ShapeStatistics
+    {
+      size_t m_Size;
+      size_t m_Nodes;
+      size_t m_Height;
+      size_t m_MaximumDepth;
+      double m_AverageDepth;
+      size_t m_BalanceViolations;
+      size_t m_ParentMismatches;
+      size_t m_OrderViolations;
+
+      bool isValid() const noexcept;
+    };
 
     BinarySearchTree();
     BinarySearchTree(Compare comp);
-    BinarySearchTree(const BinarySearchTree< Key, Value, Compare >& right);
+    BinarySearchTree(const BinarySearchTree< Key, Value, Compare, Balance >& right);
+    BinarySearchTree(BinarySearchTree< Key, Value, Compare, Balance >&& right) noexcept;
     ~BinarySearchTree();
 
-    BinarySearchTree< Key, Value, Compare >& operator=(const BinarySearchTree< Key, Value, Compare >& right);
+    BinarySearchTree< Key, Value, Compare, Balance >& operator=(
+      const BinarySearchTree< Key, Value, Compare, Balance >& right);
+    BinarySearchTree< Key, Value, Compare, Balance >& operator=(
+      BinarySearchTree< Key, Value, Compare, Balance >&& right) noexcept;
     Value& operator[](const Key& value);
 
     void insert(const content_type& value);
     void insert(const iterator& value);
     void insert(const Key& value);
+    iterator insert(const iterator& hint, const content_type& value);
+    template < class... Args >
+    iterator emplace_hint(const iterator& hint, Args&&... args);
     void erase(const iterator& value);
     void erase(const Key& value);
     void clear();
     bool empty() const;
     size_t size() const;
     iterator find(const Key& value) const;
+    void findBatch(const std::vector< Key >& keys, std::vector< iterator >& found) const;
+    void containsBatch(const std::vector< Key >& keys, std::vector< bool >& found) const;
+    template < class RandomIt >
+    void assignSorted(RandomIt first, RandomIt last);
+    template < class InputIt >
+    void insertBatch(InputIt first, InputIt last, BatchStrategy strategy = BatchStrategy::Automatic,
+      size_t threadCount = 1);
+    ShapeStatistics shapeStats() const;
+    bool validate() const;
+    void resizeLookupCache(size_t slots);
+    LookupStatistics lookupStatistics() const noexcept;
+    void useMembershipFilter(bool enabled);
 
     iterator begin();
     iterator end();
@@ -39,59 +98,113 @@ namespace bavykin
     const_iterator cend() const;
 
   private:
+    static constexpr size_t BATCH_WIDTH = 16;
+    static constexpr size_t PARALLEL_SORT_MINIMUM = size_t(1) << 15;
+    static constexpr double REBUILD_COST_PER_NODE = 1.0;
+    static constexpr double INSERT_COST_PER_ENTRY = 1.0;
+    static constexpr double INSERT_COST_PER_LEVEL = 1.0;
+    static constexpr size_t FILTER_MINIMUM_CAPACITY = 64;
+
+    using ThreeWay = ThreeWayCompare< Compare, Key >;
+
+    // The membership filter hashes keys, so it only answers for comparators under which equivalent keys are equal.
+    static constexpr bool IS_FILTERABLE = BloomFilter< Key >::IS_AVAILABLE &&
+      (std::is_same< Compare, std::less< Key > >::value || std::is_same< Compare, std::less<> >::value ||
+        std::is_same< Compare, std::greater< Key > >::value || std::is_same< Compare, std::greater<> >::value);
+
     Node* m_Root;
+    size_t m_Size;
     Compare m_Comp;
+    LookupCache< Key, Node > m_Cache;
+    BloomFilter< Key > m_Filter;
 
-    void addNode(Node* value);
     void deleteNode(Node* value);
-    void linkNodes(Node* value);
-    void linkNodesFromBottom(Node* linkedNode, Node* parent);
+    void transplant(Node* value, Node* replacement);
     void makeEmpty(Node* deleteFrom);
+#ifdef BAVYKIN_THREADED_TREE
+    void threadLeaf(Node* value);
+    void linkNeighbours(Node* value);
+    void unthread(Node* value);
+    void threadSubtree(Node* value, Node*& previous);
+#endif
     Node* findTheLeftmost();
     Node* findTheLeftmost() const;
-    size_t getHeight(Node* value) const;
-    Node* rotateLeft(Node* value);
-    Node* rotateRight(Node* value);
-    Node* insert(Node* parentNode, Node* insertedNode);
-    Node* erase(Node* parentNode, Node* erasedNode);
-    Node* balanceByNode(Node* value);
+    Node* findTheRightmost() const;
+    bool isLess(const Key& left, const Key& right) const;
+    int compareKeys(const Key& left, const Key& right) const;
+    Node* locate(Node* finger, const Key& value, Node*& parent, bool& isLeft) const;
+    Node* descend(Node* from, const Key& value, Node*& parent, bool& isLeft) const;
+    void attach(Node* parent, bool isLeft, Node* value);
+    void rebuildFilter();
+    size_t inspect(const Node* value, const Node* parent, size_t depth, const Node*& previous,
+      ShapeStatistics& statistics, size_t& depthSum) const;
+    static size_t builtHeight(size_t nodeCount) noexcept;
+    template < class RandomIt >
+    Node* buildFromSorted(RandomIt first, RandomIt last, Node* parent, size_t depth, size_t height);
+    Node* relinkSorted(Node** first, Node** last, Node* parent, size_t depth, size_t height);
+    void sortBatch(std::vector< content_type >& batch, size_t threadCount) const;
+    bool prefersRebuild(size_t batchSize) const;
+    void mergeByInsertion(std::vector< content_type >& batch);
+    void mergeByRebuild(std::vector< content_type >& batch);
   };
 
-  template < class Key, class Value, class Compare = std::less< Key > >
-  using BST = BinarySearchTree< Key, Value, Compare >;
+  template < class Key, class Value, class Compare = std::less< Key >, class Balance = AvlBalance >
+  using BST = BinarySearchTree< Key, Value, Compare, Balance >;
 
-  template < class Key, class Value, class Compare >
-  BinarySearchTree< Key, Value, Compare >::BinarySearchTree(): m_Root(nullptr), m_Comp(Compare())
+  template < class Key, class Value, class Compare, class Balance >
+  BinarySearchTree< Key, Value, Compare, Balance >::BinarySearchTree(): m_Root(nullptr), m_Size(0), m_Comp(Compare())
   {
   }
 
-  template < class Key, class Value, class Compare >
-  BinarySearchTree< Key, Value, Compare >::BinarySearchTree(Compare comp): m_Root(nullptr), m_Comp(comp)
+  template < class Key, class Value, class Compare, class Balance >
+  BinarySearchTree< Key, Value, Compare, Balance >::BinarySearchTree(Compare comp):
+    m_Root(nullptr),
+    m_Size(0),
+    m_Comp(comp)
   {
   }
 
-  template < class Key, class Value, class Compare >
-  BinarySearchTree< Key, Value, Compare >::BinarySearchTree(const BinarySearchTree< Key, Value, Compare >& right):
+  template < class Key, class Value, class Compare, class Balance >
+  BinarySearchTree< Key, Value, Compare, Balance >::BinarySearchTree(
+    const BinarySearchTree< Key, Value, Compare, Balance >& right):
     m_Root(nullptr),
-    m_Comp(right.m_Comp)
+    m_Size(0),
+    m_Comp(right.m_Comp),
+    m_Cache(right.m_Cache),
+    m_Filter()
   {
     for (const_iterator i = right.cbegin(); i != right.cend(); ++i)
     {
       insert(i.m_Current->m_Content);
     }
+    useMembershipFilter(right.m_Filter.enabled());
   }
 
-  template < class Key, class Value, class Compare >
-  BinarySearchTree< Key, Value, Compare >::~BinarySearchTree()
+  template < class Key, class Value, class Compare, class Balance >
+  BinarySearchTree< Key, Value, Compare, Balance >::BinarySearchTree(
+    BinarySearchTree< Key, Value, Compare, Balance >&& right) noexcept:
+    m_Root(right.m_Root),
+    m_Size(right.m_Size),
+    m_Comp(right.m_Comp),
+    m_Cache(std::move(right.m_Cache)),
+    m_Filter(std::move(right.m_Filter))
+  {
+    right.m_Root = nullptr;
+    right.m_Size = 0;
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  BinarySearchTree< Key, Value, Compare, Balance >::~BinarySearchTree()
   {
     makeEmpty(m_Root);
   }
 
-  template < class Key, class Value, class Compare >
-  BinarySearchTree< Key, Value, Compare >& BinarySearchTree< Key, Value, Compare >::operator=(
-    const BinarySearchTree< Key, Value, Compare >& right)
+  template < class Key, class Value, class Compare, class Balance >
+  BinarySearchTree< Key, Value, Compare, Balance >& BinarySearchTree< Key, Value, Compare, Balance >::operator=(
+    const BinarySearchTree< Key, Value, Compare, Balance >& right)
   {
     clear();
+    m_Filter.disable();
 
     for (const_iterator i = right.cbegin(); i != right.cend(); ++i)
     {
@@ -99,12 +212,34 @@ namespace bavykin
     }
 
     m_Comp = right.m_Comp;
+    m_Cache = right.m_Cache;
+    useMembershipFilter(right.m_Filter.enabled());
 
     return *this;
   }
 
-  template < class Key, class Value, class Compare >
-  Value& BinarySearchTree< Key, Value, Compare >::operator[](const Key& value)
+  template < class Key, class Value, class Compare, class Balance >
+  BinarySearchTree< Key, Value, Compare, Balance >& BinarySearchTree< Key, Value, Compare, Balance >::operator=(
+    BinarySearchTree< Key, Value, Compare, Balance >&& right) noexcept
+  {
+    if (this != &right)
+    {
+      makeEmpty(m_Root);
+
+      m_Root = right.m_Root;
+      m_Size = right.m_Size;
+      m_Comp = right.m_Comp;
+      m_Cache = std::move(right.m_Cache);
+      m_Filter = std::move(right.m_Filter);
+      right.m_Root = nullptr;
+      right.m_Size = 0;
+    }
+
+    return *this;
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  Value& BinarySearchTree< Key, Value, Compare, Balance >::operator[](const Key& value)
   {
     iterator foundedElement = find(value);
 
@@ -117,31 +252,31 @@ namespace bavykin
     return foundedElement->second;
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::insert(const iterator& value)
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::insert(const iterator& value)
   {
     insert(value.m_Current->m_Content);
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::insert(const content_type& value)
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::insert(const content_type& value)
   {
-    iterator searched = find(value.first);
+    Node* parent = nullptr;
+    bool isLeft = false;
+    Node* searched = descend(m_Root, value.first, parent, isLeft);
     if (searched != nullptr)
     {
-      searched.m_Current->m_Content.second = value.second;
+      searched->m_Content.second = value.second;
     }
     else
     {
-      addNode(new Node(value));
-
-      linkNodes(m_Root->m_Left);
-      linkNodes(m_Root->m_Right);
+      BAVYKIN_COUNT(Allocations, 1);
+      attach(parent, isLeft, new Node(value));
     }
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::insert(const Key& value)
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::insert(const Key& value)
   {
     if (find(value) != nullptr)
     {
@@ -151,14 +286,61 @@ namespace bavykin
     insert({ value, Value() });
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::erase(const iterator& value)
+  // The hint is a finger: any iterator near the key, end() standing for the largest key. A key landing next to the
+  // hint, as in an ascending or descending stream, takes two or three comparisons; otherwise the search climbs from the
+  // hint only until its subtree spans the key, which is O(log d) for a key d entries away unless the two sit on either
+  // side of a high ancestor. Returns the inserted or updated entry, which makes a good hint for the next key.
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::iterator
+  BinarySearchTree< Key, Value, Compare, Balance >::insert(const iterator& hint, const content_type& value)
+  {
+    Node* parent = nullptr;
+    bool isLeft = false;
+    Node* searched = locate(hint.m_Current, value.first, parent, isLeft);
+    if (searched != nullptr)
+    {
+      searched->m_Content.second = value.second;
+      return iterator(searched);
+    }
+
+    BAVYKIN_COUNT(Allocations, 1);
+    Node* inserted = new Node(value);
+    attach(parent, isLeft, inserted);
+
+    return iterator(inserted);
+  }
+
+  // Like insert with a hint, but the entry is constructed in place and an existing entry keeps its value.
+  template < class Key, class Value, class Compare, class Balance >
+  template < class... Args >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::iterator
+  BinarySearchTree< Key, Value, Compare, Balance >::emplace_hint(const iterator& hint, Args&&... args)
+  {
+    BAVYKIN_COUNT(Allocations, 1);
+    Node* inserted = new Node(content_type(std::forward< Args >(args)...));
+
+    Node* parent = nullptr;
+    bool isLeft = false;
+    Node* searched = locate(hint.m_Current, inserted->m_Content.first, parent, isLeft);
+    if (searched != nullptr)
+    {
+      delete inserted;
+      return iterator(searched);
+    }
+
+    attach(parent, isLeft, inserted);
+
+    return iterator(inserted);
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::erase(const iterator& value)
   {
     deleteNode(value.m_Current);
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::erase(const Key& value)
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::erase(const Key& value)
   {
     iterator searched = find(value);
 
@@ -168,139 +350,474 @@ namespace bavykin
     }
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::clear()
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::clear()
   {
     makeEmpty(m_Root);
 
     m_Root = nullptr;
+    m_Size = 0;
+    m_Cache.reset();
+    if (m_Filter.enabled())
+    {
+      m_Filter.reset(FILTER_MINIMUM_CAPACITY);
+    }
   }
 
-  template < class Key, class Value, class Compare >
-  bool BinarySearchTree< Key, Value, Compare >::empty() const
+  template < class Key, class Value, class Compare, class Balance >
+  bool BinarySearchTree< Key, Value, Compare, Balance >::empty() const
   {
     return m_Root == nullptr;
   }
 
-  template < class Key, class Value, class Compare >
-  size_t BinarySearchTree< Key, Value, Compare >::size() const
+  template < class Key, class Value, class Compare, class Balance >
+  size_t BinarySearchTree< Key, Value, Compare, Balance >::size() const
   {
-    return getHeight(m_Root);
+    return m_Size;
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::iterator BinarySearchTree< Key, Value, Compare >::find(
-    const Key& value) const
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::iterator
+  BinarySearchTree< Key, Value, Compare, Balance >::find(const Key& value) const
   {
+    if (!m_Filter.mayContain(value))
+    {
+      return iterator(nullptr);
+    }
+
+    size_t slot = 0;
+    Node* cached = m_Cache.find(value, slot, [this, &value](const Node* candidate)
+      {
+        BAVYKIN_COUNT(Comparisons, ThreeWay::CALLS);
+        return compareKeys(value, candidate->m_Content.first) == 0;
+      });
+    if (cached != nullptr)
+    {
+      return iterator(cached);
+    }
+
     Node* iterable = m_Root;
 
-    while (iterable != nullptr && iterable->m_Content.first != value)
+    size_t passed = 0;
+
+    while (iterable != nullptr)
     {
-      iterable = m_Comp(iterable->m_Content.first, value) ? iterable->m_Right : iterable->m_Left;
+      passed++;
+      int order = compareKeys(value, iterable->m_Content.first);
+      if (order == 0)
+      {
+        break;
+      }
+      iterable = order < 0 ? iterable->m_Left : iterable->m_Right;
     }
+    BAVYKIN_COUNT(NodeVisits, passed);
+    BAVYKIN_COUNT(Comparisons, passed * ThreeWay::CALLS);
+    m_Cache.remember(slot, iterable);
 
     return iterator(iterable);
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::iterator BinarySearchTree< Key, Value, Compare >::begin()
+  // Descends for BATCH_WIDTH keys in lockstep, prefetching each lane's next node, so the cache misses of different
+  // lanes overlap instead of following one another. Keys are visited in sorted order, so the lanes of a group share
+  // the top of their paths and neighbouring groups find those nodes still cached. A lane that finds its key records
+  // it and drops out, and keys the membership filter rejects never take a lane.
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::findBatch(const std::vector< Key >& keys,
+    std::vector< iterator >& found) const
+  {
+    std::vector< size_t > order;
+    order.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+      if (m_Filter.mayContain(keys[i]))
+      {
+        order.push_back(i);
+      }
+    }
+    std::sort(order.begin(), order.end(), [this, &keys](size_t left, size_t right)
+      {
+        return isLess(keys[left], keys[right]);
+      });
+
+    found.assign(keys.size(), iterator(nullptr));
+    Node* lanes[BATCH_WIDTH];
+    size_t passed = 0;
+
+    for (size_t group = 0; group < order.size(); group += BATCH_WIDTH)
+    {
+      size_t width = std::min(BATCH_WIDTH, order.size() - group);
+      std::fill(lanes, lanes + width, m_Root);
+
+      bool descending = true;
+      while (descending)
+      {
+        descending = false;
+        for (size_t lane = 0; lane < width; lane++)
+        {
+          Node* iterable = lanes[lane];
+          if (iterable == nullptr)
+          {
+            continue;
+          }
+
+          passed++;
+          int comparison = compareKeys(keys[order[group + lane]], iterable->m_Content.first);
+          if (comparison == 0)
+          {
+            found[order[group + lane]] = iterator(iterable);
+            lanes[lane] = nullptr;
+            continue;
+          }
+
+          iterable = comparison < 0 ? iterable->m_Left : iterable->m_Right;
+          if (iterable != nullptr)
+          {
+            prefetch(iterable);
+            descending = true;
+          }
+          lanes[lane] = iterable;
+        }
+      }
+    }
+    BAVYKIN_COUNT(NodeVisits, passed);
+    BAVYKIN_COUNT(Comparisons, passed * ThreeWay::CALLS);
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::containsBatch(const std::vector< Key >& keys,
+    std::vector< bool >& found) const
+  {
+    std::vector< iterator > nodes;
+    findBatch(keys, nodes);
+
+    found.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+      found[i] = nodes[i] != nullptr;
+    }
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  template < class RandomIt >
+  void BinarySearchTree< Key, Value, Compare, Balance >::assignSorted(RandomIt first, RandomIt last)
+  {
+    clear();
+
+    m_Size = static_cast< size_t >(last - first);
+    m_Root = buildFromSorted(first, last, nullptr, 0, builtHeight(m_Size));
+#ifdef BAVYKIN_THREADED_TREE
+    Node* previous = nullptr;
+    threadSubtree(m_Root, previous);
+#endif
+    if (m_Filter.enabled())
+    {
+      rebuildFilter();
+    }
+  }
+
+  // Sorts the batch, using up to threadCount threads, and keeps the last entry of every key, as inserting the entries
+  // one by one would. Then merges it in with the strategy given, the automatic one asking the cost model.
+  template < class Key, class Value, class Compare, class Balance >
+  template < class InputIt >
+  void BinarySearchTree< Key, Value, Compare, Balance >::insertBatch(InputIt first, InputIt last,
+    BatchStrategy strategy, size_t threadCount)
+  {
+    std::vector< content_type > batch(first, last);
+    sortBatch(batch, threadCount);
+
+    typename std::vector< content_type >::iterator kept = batch.begin();
+    for (typename std::vector< content_type >::iterator i = batch.begin(); i != batch.end(); ++i)
+    {
+      if (i + 1 != batch.end() && !isLess(i->first, (i + 1)->first))
+      {
+        continue;
+      }
+      if (kept != i)
+      {
+        *kept = std::move(*i);
+      }
+      ++kept;
+    }
+    batch.erase(kept, batch.end());
+
+    if (strategy == BatchStrategy::Rebuild || (strategy == BatchStrategy::Automatic && prefersRebuild(batch.size())))
+    {
+      mergeByRebuild(batch);
+    }
+    else
+    {
+      mergeByInsertion(batch);
+    }
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::ShapeStatistics
+  BinarySearchTree< Key, Value, Compare, Balance >::shapeStats() const
+  {
+    ShapeStatistics statistics = { m_Size, 0, 0, 0, 0.0, 0, 0, 0 };
+    const Node* previous = nullptr;
+    size_t depthSum = 0;
+
+    statistics.m_Height = inspect(m_Root, nullptr, 0, previous, statistics, depthSum);
+    statistics.m_BalanceViolations = Balance::countViolations(m_Root);
+#ifdef BAVYKIN_THREADED_TREE
+    if (previous != nullptr && previous->m_Next != nullptr)
+    {
+      statistics.m_OrderViolations++;
+    }
+#endif
+    if (statistics.m_Nodes != 0)
+    {
+      statistics.m_AverageDepth = static_cast< double >(depthSum) / statistics.m_Nodes;
+    }
+
+    return statistics;
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  bool BinarySearchTree< Key, Value, Compare, Balance >::validate() const
+  {
+    return shapeStats().isValid();
+  }
+
+  // Puts a direct-mapped cache of the given number of slots in front of find, for workloads where a few keys take
+  // most lookups; zero, the default, removes it. Needs a std::hash specialization for Key. See LookupCache.h.
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::resizeLookupCache(size_t slots)
+  {
+    m_Cache.resize(slots);
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::LookupStatistics
+  BinarySearchTree< Key, Value, Compare, Balance >::lookupStatistics() const noexcept
+  {
+    return m_Cache.statistics();
+  }
+
+  // Keeps a Bloom filter of the keys beside the tree, so that find, and everything built on it, rejects most absent
+  // keys with one cache line read instead of a descent. It costs about BloomFilter::BITS_PER_KEY bits per entry,
+  // a hash per insert and a rebuild each time the tree doubles or is built anew. Erased keys stay in the filter
+  // until the next rebuild, so they only cost the descent the filter would have saved. Needs a std::hash
+  // specialization for Key and std::less or std::greater as Compare.
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::useMembershipFilter(bool enabled)
+  {
+    if (!enabled)
+    {
+      m_Filter.disable();
+      return;
+    }
+
+    if constexpr (!IS_FILTERABLE)
+    {
+      throw std::logic_error("Membership filter needs a hashable key ordered by std::less or std::greater.");
+    }
+
+    rebuildFilter();
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  bool BinarySearchTree< Key, Value, Compare, Balance >::ShapeStatistics::isValid() const noexcept
+  {
+    return m_Nodes == m_Size && m_BalanceViolations == 0 && m_ParentMismatches == 0 && m_OrderViolations == 0;
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::iterator
+  BinarySearchTree< Key, Value, Compare, Balance >::begin()
   {
     return iterator(findTheLeftmost());
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::iterator BinarySearchTree< Key, Value, Compare >::end()
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::iterator
+  BinarySearchTree< Key, Value, Compare, Balance >::end()
   {
     return iterator(nullptr);
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::const_iterator BinarySearchTree< Key, Value, Compare >::cbegin()
-    const
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::const_iterator
+  BinarySearchTree< Key, Value, Compare, Balance >::cbegin() const
   {
     return const_iterator(findTheLeftmost());
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::const_iterator BinarySearchTree< Key, Value, Compare >::cend() const
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::const_iterator
+  BinarySearchTree< Key, Value, Compare, Balance >::cend() const
   {
     return const_iterator(nullptr);
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::addNode(Node* value)
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::deleteNode(Node* value)
   {
-    m_Root = insert(m_Root, value);
-    m_Root->m_Parent = nullptr;
-    linkNodesFromBottom(value, m_Root);
+    if (value == nullptr)
+    {
+      throw std::logic_error("Node was nullptr");
+    }
+
+#ifdef BAVYKIN_THREADED_TREE
+    unthread(value);
+#endif
+    m_Cache.forget(value->m_Content.first, value);
+    Node* child = nullptr;
+    Node* parent = nullptr;
+    int removed = 0;
+
+    if (value->m_Left == nullptr || value->m_Right == nullptr)
+    {
+      child = value->m_Left != nullptr ? value->m_Left : value->m_Right;
+      parent = value->m_Parent;
+      removed = value->m_Balance;
+      transplant(value, child);
+    }
+    else
+    {
+      // The successor node itself takes the erased node's place, balance data included, so no content is copied or
+      // moved and iterators to every other entry stay valid. The position it leaves is the one that lost a node.
+      Node* successor = value->m_Right;
+      while (successor->m_Left != nullptr)
+      {
+        BAVYKIN_COUNT(NodeVisits, 1);
+        successor = successor->m_Left;
+      }
+
+      child = successor->m_Right;
+      removed = successor->m_Balance;
+      if (successor->m_Parent == value)
+      {
+        parent = successor;
+      }
+      else
+      {
+        parent = successor->m_Parent;
+        transplant(successor, child);
+        successor->m_Right = value->m_Right;
+        successor->m_Right->m_Parent = successor;
+      }
+
+      transplant(value, successor);
+      successor->m_Left = value->m_Left;
+      successor->m_Left->m_Parent = successor;
+      successor->m_Balance = value->m_Balance;
+    }
+
+    delete value;
+    m_Size--;
+    Balance::afterErase(m_Root, child, parent, removed);
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::deleteNode(Node* value)
+  // Puts replacement, which may be empty, where value hangs under its parent.
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::transplant(Node* value, Node* replacement)
   {
-    m_Root = erase(m_Root, value);
+    if (value->m_Parent == nullptr)
+    {
+      m_Root = replacement;
+    }
+    else if (value->m_Parent->m_Left == value)
+    {
+      value->m_Parent->m_Left = replacement;
+    }
+    else
+    {
+      value->m_Parent->m_Right = replacement;
+    }
 
-    if (m_Root != nullptr)
+    if (replacement != nullptr)
     {
-      m_Root->m_Parent = nullptr;
+      replacement->m_Parent = value->m_Parent;
     }
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::linkNodes(Node* value)
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::makeEmpty(Node* deleteFrom)
   {
-    if (value == nullptr)
+    if (deleteFrom == nullptr)
     {
       return;
     }
 
-    linkNodes(value->m_Left);
-    linkNodes(value->m_Right);
-    linkNodesFromBottom(value, m_Root);
+    makeEmpty(deleteFrom->m_Left);
+    makeEmpty(deleteFrom->m_Right);
+    delete deleteFrom;
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::linkNodesFromBottom(Node* linkedNode, Node* parent)
+#ifdef BAVYKIN_THREADED_TREE
+  // A node just attached as a leaf sits right next to its parent in key order.
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::threadLeaf(Node* value)
   {
-    if (linkedNode == nullptr)
+    Node* parent = value->m_Parent;
+    if (parent->m_Left == value)
     {
-      return;
+      value->m_Next = parent;
+      value->m_Previous = parent->m_Previous;
+    }
+    else
+    {
+      value->m_Previous = parent;
+      value->m_Next = parent->m_Next;
     }
 
-    if (parent == nullptr)
+    linkNeighbours(value);
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::linkNeighbours(Node* value)
+  {
+    if (value->m_Previous != nullptr)
     {
-      linkedNode->m_Parent = nullptr;
+      value->m_Previous->m_Next = value;
     }
-    else if (parent->m_Left == linkedNode || parent->m_Right == linkedNode)
+    if (value->m_Next != nullptr)
     {
-      linkedNode->m_Parent = parent;
+      value->m_Next->m_Previous = value;
     }
-    else
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::unthread(Node* value)
+  {
+    if (value->m_Previous != nullptr)
+    {
+      value->m_Previous->m_Next = value->m_Next;
+    }
+    if (value->m_Next != nullptr)
     {
-      linkNodesFromBottom(linkedNode, parent->m_Left);
-      linkNodesFromBottom(linkedNode, parent->m_Right);
+      value->m_Next->m_Previous = value->m_Previous;
     }
   }
 
-  template < class Key, class Value, class Compare >
-  void BinarySearchTree< Key, Value, Compare >::makeEmpty(Node* deleteFrom)
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::threadSubtree(Node* value, Node*& previous)
   {
-    if (deleteFrom == nullptr)
+    if (value == nullptr)
     {
       return;
     }
 
-    makeEmpty(deleteFrom->m_Left);
-    makeEmpty(deleteFrom->m_Right);
-    delete deleteFrom;
+    threadSubtree(value->m_Left, previous);
+    value->m_Previous = previous;
+    if (previous != nullptr)
+    {
+      previous->m_Next = value;
+    }
+    previous = value;
+    threadSubtree(value->m_Right, previous);
   }
+#endif
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::Node* BinarySearchTree< Key, Value, Compare >::findTheLeftmost()
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::Node*
+  BinarySearchTree< Key, Value, Compare, Balance >::findTheLeftmost()
   {
     Node* founded = m_Root;
 
-    while (founded->m_Left != nullptr && founded != nullptr)
+    while (founded != nullptr && founded->m_Left != nullptr)
     {
       founded = founded->m_Left;
     }
@@ -308,9 +825,9 @@ namespace bavykin
     return founded;
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::Node* BinarySearchTree< Key, Value, Compare >::findTheLeftmost()
-    const
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::Node*
+  BinarySearchTree< Key, Value, Compare, Balance >::findTheLeftmost() const
   {
     Node* founded = m_Root;
 
@@ -322,147 +839,429 @@ namespace bavykin
     return founded;
   }
 
-  template < class Key, class Value, class Compare >
-  size_t BinarySearchTree< Key, Value, Compare >::getHeight(Node* value) const
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::Node*
+  BinarySearchTree< Key, Value, Compare, Balance >::findTheRightmost() const
   {
-    if (value == nullptr)
+    Node* founded = m_Root;
+
+    while (founded != nullptr && founded->m_Right != nullptr)
     {
-      return 0;
+      founded = founded->m_Right;
     }
 
-    return std::max(getHeight(value->m_Left), getHeight(value->m_Right)) + 1;
+    return founded;
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::Node* BinarySearchTree< Key, Value, Compare >::rotateRight(
-    Node* value)
+  template < class Key, class Value, class Compare, class Balance >
+  bool BinarySearchTree< Key, Value, Compare, Balance >::isLess(const Key& left, const Key& right) const
   {
-    Node* newNode = value->m_Left;
-    value->m_Left = newNode->m_Right;
-    newNode->m_Right = value;
+    return ThreeWay::isLess(m_Comp, left, right);
+  }
 
-    return newNode;
+  // Searches call this once per node: one comparator call where the comparator answers three-way, two otherwise.
+  template < class Key, class Value, class Compare, class Balance >
+  int BinarySearchTree< Key, Value, Compare, Balance >::compareKeys(const Key& left, const Key& right) const
+  {
+    return ThreeWay::compare(m_Comp, left, right);
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::Node* BinarySearchTree< Key, Value, Compare >::rotateLeft(
-    Node* value)
+  // Returns the node holding value, or nullptr and the free slot value belongs in. From the finger the search first
+  // checks the gap to the finger's neighbour, then climbs until an ancestor on the far side of value bounds the climb
+  // or the root is reached. Only ancestors on the far side cost a comparison. The descent then starts from the last
+  // ancestor passed on the near side, the lowest node whose subtree is known to span value.
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::Node*
+  BinarySearchTree< Key, Value, Compare, Balance >::locate(
+    Node* finger, const Key& value, Node*& parent, bool& isLeft) const
   {
-    Node* newNode = value->m_Right;
-    value->m_Right = newNode->m_Left;
-    newNode->m_Left = value;
+    Node* iterable = finger == nullptr ? findTheRightmost() : finger;
+    size_t passed = 0;
+    size_t compared = 0;
 
-    return newNode;
+    int order = 0;
+    if (iterable != nullptr)
+    {
+      BAVYKIN_COUNT(Comparisons, ThreeWay::CALLS);
+      order = compareKeys(value, iterable->m_Content.first);
+    }
+
+    if (order > 0)
+    {
+      iterator next(iterable);
+      ++next;
+      BAVYKIN_COUNT(Comparisons, 1);
+      if (next == nullptr || isLess(value, next.m_Current->m_Content.first))
+      {
+        isLeft = iterable->m_Right != nullptr;
+        parent = isLeft ? next.m_Current : iterable;
+        return nullptr;
+      }
+
+      iterable = next.m_Current;
+      Node* spanning = iterable;
+      while (iterable->m_Parent != nullptr)
+      {
+        Node* ancestor = iterable->m_Parent;
+        if (iterable == ancestor->m_Left)
+        {
+          compared++;
+          int comparison = compareKeys(value, ancestor->m_Content.first);
+          if (comparison <= 0)
+          {
+            if (comparison == 0)
+            {
+              BAVYKIN_COUNT(Comparisons, compared * ThreeWay::CALLS);
+              return ancestor;
+            }
+            break;
+          }
+          spanning = ancestor;
+        }
+        passed++;
+        iterable = ancestor;
+      }
+      iterable = spanning;
+    }
+    else if (order < 0)
+    {
+      iterator previous(iterable);
+      --previous;
+      BAVYKIN_COUNT(Comparisons, 1);
+      if (previous == nullptr || isLess(previous.m_Current->m_Content.first, value))
+      {
+        isLeft = iterable->m_Left == nullptr;
+        parent = isLeft ? iterable : previous.m_Current;
+        return nullptr;
+      }
+
+      iterable = previous.m_Current;
+      Node* spanning = iterable;
+      while (iterable->m_Parent != nullptr)
+      {
+        Node* ancestor = iterable->m_Parent;
+        if (iterable == ancestor->m_Right)
+        {
+          compared++;
+          int comparison = compareKeys(value, ancestor->m_Content.first);
+          if (comparison >= 0)
+          {
+            if (comparison == 0)
+            {
+              BAVYKIN_COUNT(Comparisons, compared * ThreeWay::CALLS);
+              return ancestor;
+            }
+            break;
+          }
+          spanning = ancestor;
+        }
+        passed++;
+        iterable = ancestor;
+      }
+      iterable = spanning;
+    }
+    else if (iterable != nullptr)
+    {
+      return iterable;
+    }
+    BAVYKIN_COUNT(NodeVisits, passed);
+    BAVYKIN_COUNT(Comparisons, compared * ThreeWay::CALLS);
+
+    return descend(iterable, value, parent, isLeft);
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::Node* BinarySearchTree< Key, Value, Compare >::insert(
-    Node* parentNode, Node* insertedNode)
+  // Plain descent from the given node: returns the node holding value, or nullptr and the free slot below parent
+  // that value belongs in, parent being nullptr when the tree is empty.
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::Node*
+  BinarySearchTree< Key, Value, Compare, Balance >::descend(
+    Node* from, const Key& value, Node*& parent, bool& isLeft) const
   {
-    if (parentNode == nullptr)
+    Node* iterable = from;
+    size_t passed = 0;
+
+    parent = nullptr;
+    while (iterable != nullptr)
     {
-      return insertedNode;
+      passed++;
+      int order = compareKeys(value, iterable->m_Content.first);
+      if (order == 0)
+      {
+        break;
+      }
+
+      parent = iterable;
+      isLeft = order < 0;
+      iterable = isLeft ? iterable->m_Left : iterable->m_Right;
     }
+    BAVYKIN_COUNT(NodeVisits, passed);
+    BAVYKIN_COUNT(Comparisons, passed * ThreeWay::CALLS);
 
-    if (m_Comp(insertedNode->m_Content.first, parentNode->m_Content.first))
+    return iterable;
+  }
+
+  // Hangs value in the free slot found by locate or descend and lets the balance policy restore balance.
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::attach(Node* parent, bool isLeft, Node* value)
+  {
+    value->m_Parent = parent;
+    if (parent == nullptr)
     {
-      parentNode->m_Left = insert(parentNode->m_Left, insertedNode);
+      m_Root = value;
     }
     else
     {
-      parentNode->m_Right = insert(parentNode->m_Right, insertedNode);
+      (isLeft ? parent->m_Left : parent->m_Right) = value;
+#ifdef BAVYKIN_THREADED_TREE
+      threadLeaf(value);
+#endif
+    }
+    m_Size++;
+    Balance::afterInsert(m_Root, value);
+    if (!m_Filter.add(value->m_Content.first))
+    {
+      rebuildFilter();
+    }
+  }
+
+  // Sizes the filter for twice the entries, so the tree can double before add asks for the next rebuild.
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::rebuildFilter()
+  {
+    m_Filter.reset(std::max(m_Size * 2, FILTER_MINIMUM_CAPACITY));
+    for (const_iterator i = cbegin(); i != cend(); ++i)
+    {
+      m_Filter.add(i->first);
+    }
+  }
+
+  // In-order walk that returns the height of the subtree, so one pass checks the parent link of every node and the
+  // key order against the node visited before it. Threaded links that disagree with that order count as order
+  // violations too; the balance invariant is left to the policy.
+  template < class Key, class Value, class Compare, class Balance >
+  size_t BinarySearchTree< Key, Value, Compare, Balance >::inspect(const Node* value, const Node* parent, size_t depth,
+    const Node*& previous, ShapeStatistics& statistics, size_t& depthSum) const
+  {
+    if (value == nullptr)
+    {
+      return 0;
     }
 
-    return balanceByNode(parentNode);
+    size_t leftHeight = inspect(value->m_Left, value, depth + 1, previous, statistics, depthSum);
+
+    statistics.m_Nodes++;
+    statistics.m_MaximumDepth = std::max(statistics.m_MaximumDepth, depth);
+    depthSum += depth;
+    if (value->m_Parent != parent)
+    {
+      statistics.m_ParentMismatches++;
+    }
+    if (previous != nullptr && !isLess(previous->m_Content.first, value->m_Content.first))
+    {
+      statistics.m_OrderViolations++;
+    }
+#ifdef BAVYKIN_THREADED_TREE
+    if (value->m_Previous != previous || (previous != nullptr && previous->m_Next != value))
+    {
+      statistics.m_OrderViolations++;
+    }
+#endif
+    previous = value;
+
+    size_t rightHeight = inspect(value->m_Right, value, depth + 1, previous, statistics, depthSum);
+
+    return std::max(leftHeight, rightHeight) + 1;
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::Node* BinarySearchTree< Key, Value, Compare >::erase(
-    Node* parentNode, Node* erasedNode)
+  // Levels of the tree buildFromSorted and relinkSorted make of nodeCount nodes: floor(log2(nodeCount)) + 1.
+  template < class Key, class Value, class Compare, class Balance >
+  size_t BinarySearchTree< Key, Value, Compare, Balance >::builtHeight(size_t nodeCount) noexcept
   {
-    if (erasedNode == nullptr)
+    size_t height = 0;
+    for (; nodeCount != 0; nodeCount /= 2)
     {
-      throw std::logic_error("Node was nullptr");
+      height++;
     }
 
-    if (parentNode == nullptr)
+    return height;
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  template < class RandomIt >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::Node*
+  BinarySearchTree< Key, Value, Compare, Balance >::buildFromSorted(
+    RandomIt first, RandomIt last, Node* parent, size_t depth, size_t height)
+  {
+    if (first == last)
     {
       return nullptr;
     }
 
-    if (m_Comp(erasedNode->m_Content.first, parentNode->m_Content.first))
+    RandomIt middle = first + (last - first) / 2;
+    BAVYKIN_COUNT(Allocations, 1);
+    Node* value = new Node(*middle);
+    value->m_Parent = parent;
+    value->m_Left = buildFromSorted(first, middle, value, depth + 1, height);
+    value->m_Right = buildFromSorted(middle + 1, last, value, depth + 1, height);
+    Balance::initializeBuilt(value, depth, height);
+
+    return value;
+  }
+
+  template < class Key, class Value, class Compare, class Balance >
+  typename BinarySearchTree< Key, Value, Compare, Balance >::Node*
+  BinarySearchTree< Key, Value, Compare, Balance >::relinkSorted(
+    Node** first, Node** last, Node* parent, size_t depth, size_t height)
+  {
+    if (first == last)
     {
-      parentNode->m_Left = erase(parentNode->m_Left, erasedNode);
+      return nullptr;
     }
 
-    else if (m_Comp(parentNode->m_Content.first, erasedNode->m_Content.first))
+    Node** middle = first + (last - first) / 2;
+    Node* value = *middle;
+    value->m_Parent = parent;
+    value->m_Left = relinkSorted(first, middle, value, depth + 1, height);
+    value->m_Right = relinkSorted(middle + 1, last, value, depth + 1, height);
+    Balance::initializeBuilt(value, depth, height);
+
+    return value;
+  }
+
+  // Stable, so equal keys keep their input order. Large batches are cut into one chunk per thread, the chunks sorted
+  // concurrently and then merged pairwise on this thread.
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::sortBatch(std::vector< content_type >& batch,
+    size_t threadCount) const
+  {
+    auto byKey = [this](const content_type& left, const content_type& right)
     {
-      parentNode->m_Right = erase(parentNode->m_Right, erasedNode);
+      return isLess(left.first, right.first);
+    };
+
+    size_t chunkCount = std::min(threadCount, batch.size() / PARALLEL_SORT_MINIMUM);
+    if (chunkCount < 2)
+    {
+      std::stable_sort(batch.begin(), batch.end(), byKey);
+      return;
     }
-    else
+
+    std::vector< typename std::vector< content_type >::iterator > bounds;
+    for (size_t chunk = 0; chunk <= chunkCount; chunk++)
     {
-      Node* right = parentNode->m_Right;
+      bounds.push_back(batch.begin() + batch.size() * chunk / chunkCount);
+    }
 
-      if (parentNode->m_Right == nullptr)
-      {
-        Node* left = parentNode->m_Left;
-        delete parentNode;
-        parentNode = left;
-      }
-      else if (parentNode->m_Left == nullptr)
-      {
-        delete parentNode;
-        parentNode = right;
-      }
-      else
-      {
-        while (right->m_Left != nullptr)
+    std::vector< std::thread > workers;
+    for (size_t chunk = 1; chunk < chunkCount; chunk++)
+    {
+      workers.emplace_back([&bounds, byKey, chunk]
         {
-          right = right->m_Left;
-        }
+          std::stable_sort(bounds[chunk], bounds[chunk + 1], byKey);
+        });
+    }
+    std::stable_sort(bounds[0], bounds[1], byKey);
+    for (std::thread& worker : workers)
+    {
+      worker.join();
+    }
 
-        parentNode->m_Content = right->m_Content;
-        parentNode->m_Right = erase(parentNode->m_Right, right);
+    for (size_t width = 1; width < chunkCount; width *= 2)
+    {
+      for (size_t chunk = 0; chunk + width < chunkCount; chunk += 2 * width)
+      {
+        size_t end = std::min(chunk + 2 * width, chunkCount);
+        std::inplace_merge(bounds[chunk], bounds[chunk + width], bounds[end], byKey);
       }
     }
-
-    return balanceByNode(parentNode);
   }
 
-  template < class Key, class Value, class Compare >
-  typename BinarySearchTree< Key, Value, Compare >::Node* BinarySearchTree< Key, Value, Compare >::balanceByNode(
-    Node* value)
+  // Hinted inserts in key order cost about log2(n / m) levels of finger search per entry, plus a constant for
+  // allocating and retracing; a rebuild touches every node of the merged tree once. The weights put the break-even
+  // point where `Benchmarks batches` measures it, at batches about the size of the tree.
+  template < class Key, class Value, class Compare, class Balance >
+  bool BinarySearchTree< Key, Value, Compare, Balance >::prefersRebuild(size_t batchSize) const
   {
-    if (value == nullptr)
+    if (batchSize == 0)
     {
-      return value;
+      return false;
     }
 
-    int height = getHeight(value->m_Left) - getHeight(value->m_Right);
+    double distance = static_cast< double >(m_Size) / batchSize + 1.0;
+    double insertCost = batchSize * (INSERT_COST_PER_ENTRY + INSERT_COST_PER_LEVEL * std::log2(distance));
+    double rebuildCost = (m_Size + batchSize) * REBUILD_COST_PER_NODE;
+
+    return rebuildCost < insertCost;
+  }
 
-    if (height > 1)
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::mergeByInsertion(std::vector< content_type >& batch)
+  {
+    Node* position = nullptr;
+    for (content_type& entry : batch)
     {
-      if (getHeight(value->m_Left) >= getHeight(value->m_Right))
+      Node* parent = nullptr;
+      bool isLeft = false;
+      Node* searched = locate(position, entry.first, parent, isLeft);
+      if (searched != nullptr)
       {
-        return rotateRight(value);
+        searched->m_Content.second = std::move(entry.second);
+        position = searched;
+      }
+      else
+      {
+        BAVYKIN_COUNT(Allocations, 1);
+        position = new Node(std::move(entry));
+        attach(parent, isLeft, position);
       }
-
-      value->m_Left = rotateLeft(value->m_Left);
-      return rotateRight(value);
     }
+  }
+
+  // Merges the existing nodes with the batch into one sorted sequence and relinks it as a perfectly balanced tree.
+  // Existing nodes are reused, so no stored entry is copied and iterators to them stay valid.
+  template < class Key, class Value, class Compare, class Balance >
+  void BinarySearchTree< Key, Value, Compare, Balance >::mergeByRebuild(std::vector< content_type >& batch)
+  {
+    std::vector< Node* > nodes;
+    nodes.reserve(m_Size + batch.size());
 
-    if (height < -1)
+    iterator existing(findTheLeftmost());
+    for (content_type& entry : batch)
     {
-      if (getHeight(value->m_Right) >= getHeight(value->m_Left))
+      int order = 0;
+      while (existing != end() && (order = compareKeys(entry.first, existing->first)) > 0)
       {
-        return rotateLeft(value);
+        nodes.push_back(existing.m_Current);
+        ++existing;
       }
 
-      value->m_Right = rotateRight(value->m_Right);
-      return rotateLeft(value);
+      if (existing != end() && order == 0)
+      {
+        existing->second = std::move(entry.second);
+        nodes.push_back(existing.m_Current);
+        ++existing;
+      }
+      else
+      {
+        BAVYKIN_COUNT(Allocations, 1);
+        nodes.push_back(new Node(std::move(entry)));
+      }
+    }
+    for (; existing != end(); ++existing)
+    {
+      nodes.push_back(existing.m_Current);
     }
 
-    return value;
+    m_Size = nodes.size();
+    m_Root = relinkSorted(nodes.data(), nodes.data() + nodes.size(), nullptr, 0, builtHeight(m_Size));
+#ifdef BAVYKIN_THREADED_TREE
+    Node* previous = nullptr;
+    threadSubtree(m_Root, previous);
+#endif
+    if (m_Filter.enabled())
+    {
+      rebuildFilter();
+    }
   }
 }
 #endif
@@ -1,18 +1,25 @@
 #ifndef BINARY_SEARCH_TREE_ITERATOR_H
 #define BINARY_SEARCH_TREE_ITERATOR_H
 #include "BinarySearchTreeNode.h"
+#include <cstddef>
 #include <iterator>
+#include <type_traits>
 
 namespace bavykin
 {
   template < class T, bool isConst = false >
-  class BinarySearchTreeIterator: public std::iterator< std::bidirectional_iterator_tag, T >
+  class BinarySearchTreeIterator
   {
   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t< isConst, const T*, T* >;
+    using reference = std::conditional_t< isConst, const T&, T& >;
     using Node = BinarySearchTreeNode< T >;
     using iterator = BinarySearchTreeIterator< T, isConst >;
     using returntypePtr_t = std::conditional_t< isConst, const T*, T* >;
-    using returntype_t = std::conditional< isConst, const T, T >;
+    using returntype_t = std::conditional_t< isConst, const T, T >;
 
     BinarySearchTreeIterator();
     BinarySearchTreeIterator(const BinarySearchTreeIterator& right);
@@ -79,12 +86,15 @@ namespace bavykin
   typename BinarySearchTreeIterator< T, isConst >::returntypePtr_t BinarySearchTreeIterator< T, isConst >::operator->()
     const
   {
-    return new T(m_Current->m_Content);
+    return &m_Current->m_Content;
   }
 
   template < class T, bool isConst >
-  typename BinarySearchTreeIterator< T, isConst >& BinarySearchTreeIterator< T, isConst >::operator++()
+  BinarySearchTreeIterator< T, isConst >& BinarySearchTreeIterator< T, isConst >::operator++()
   {
+#ifdef BAVYKIN_THREADED_TREE
+    m_Current = m_Current->m_Next;
+#else
     Node* right = m_Current->m_Right;
 
     if (right == nullptr)
@@ -107,12 +117,13 @@ namespace bavykin
     }
 
     m_Current = right;
+#endif
 
     return *this;
   }
 
   template < class T, bool isConst >
-  const typename BinarySearchTreeIterator< T, isConst > BinarySearchTreeIterator< T, isConst >::operator++(int)
+  const BinarySearchTreeIterator< T, isConst > BinarySearchTreeIterator< T, isConst >::operator++(int)
   {
     iterator copy(*this);
     ++(*this);
@@ -120,8 +131,11 @@ namespace bavykin
   }
 
   template < class T, bool isConst >
-  typename BinarySearchTreeIterator< T, isConst >& BinarySearchTreeIterator< T, isConst >::operator--()
+  BinarySearchTreeIterator< T, isConst >& BinarySearchTreeIterator< T, isConst >::operator--()
   {
+#ifdef BAVYKIN_THREADED_TREE
+    m_Current = m_Current->m_Previous;
+#else
     Node* left = m_Current->m_Left;
 
     if (left == nullptr)
@@ -144,12 +158,13 @@ namespace bavykin
     }
 
     m_Current = left;
+#endif
 
     return *this;
   }
 
   template < class T, bool isConst >
-  const typename BinarySearchTreeIterator< T, isConst > BinarySearchTreeIterator< T, isConst >::operator--(int)
+  const BinarySearchTreeIterator< T, isConst > BinarySearchTreeIterator< T, isConst >::operator--(int)
   {
     iterator copy(*this);
     --(*this);
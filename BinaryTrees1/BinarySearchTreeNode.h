@@ -1,5 +1,6 @@
 #ifndef BINARY_SEARCH_TREE_NODE_H
 #define BINARY_SEARCH_TREE_NODE_H
+#include <utility>
 
 namespace bavykin
 {
@@ -11,15 +12,24 @@ namespace bavykin
 
     BinarySearchTreeNode();
     BinarySearchTreeNode(const T& right);
+    BinarySearchTreeNode(T&& right);
 
     T m_Content;
     Node* m_Left;
     Node* m_Right;
     Node* m_Parent;
+    // Owned by the tree's balance policy: the subtree height for AVL trees, the colour for red-black ones.
+    int m_Balance;
+#ifdef BAVYKIN_THREADED_TREE
+    // In-order neighbours, so iterators step through one pointer instead of climbing parent links. Rotations and
+    // successor relinking keep the in-order sequence, so only inserting and erasing a node touch them.
+    Node* m_Next = nullptr;
+    Node* m_Previous = nullptr;
+#endif
   };
 
   template < class T >
-  BinarySearchTreeNode< T >::BinarySearchTreeNode(): m_Left(nullptr), m_Right(nullptr), m_Parent(nullptr)
+  BinarySearchTreeNode< T >::BinarySearchTreeNode(): m_Left(nullptr), m_Right(nullptr), m_Parent(nullptr), m_Balance(1)
   {
   }
 
@@ -28,7 +38,18 @@ namespace bavykin
     m_Content(right),
     m_Left(nullptr),
     m_Right(nullptr),
-    m_Parent(nullptr)
+    m_Parent(nullptr),
+    m_Balance(1)
+  {
+  }
+
+  template < class T >
+  BinarySearchTreeNode< T >::BinarySearchTreeNode(T&& right):
+    m_Content(std::move(right)),
+    m_Left(nullptr),
+    m_Right(nullptr),
+    m_Parent(nullptr),
+    m_Balance(1)
   {
   }
 }
@@ -0,0 +1,160 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace bavykin
+{
+  // Split-block Bloom filter, the layout of Parquet's filters: a key hashes to one 32-byte block and sets one bit in
+  // each of the block's eight words, so a query reads a single cache line and a key that was never added is
+  // rejected, barring a false positive, without touching anything else. With BITS_PER_KEY bits per key it was sized
+  // for, about 1% of absent keys pass.
+  //
+  // Keys cannot be removed, so a filter only ever grows conservative; its owner rebuilds it once add reports that
+  // more keys went in than it was sized for. Disabled, accepting every key, until reset.
+  template < class Key >
+  class BloomFilter
+  {
+  public:
+    static constexpr size_t BITS_PER_KEY = 12;
+    // Keys without a std::hash specialization cannot be filtered; resetting such a filter throws.
+    static constexpr bool IS_AVAILABLE = std::is_default_constructible< std::hash< Key > >::value;
+
+    BloomFilter();
+
+    bool enabled() const noexcept;
+    void reset(size_t capacity);
+    void disable() noexcept;
+    bool add(const Key& key) noexcept;
+    bool mayContain(const Key& key) const noexcept;
+
+  private:
+    static constexpr size_t WORDS = 8;
+
+    struct alignas(32) Block
+    {
+      uint32_t m_Words[WORDS];
+    };
+
+    std::vector< Block > m_Blocks;
+    size_t m_Capacity;
+    size_t m_Load;
+
+    static uint64_t hashOf(const Key& key) noexcept;
+    size_t blockOf(uint64_t hash) const noexcept;
+    static uint32_t bitOf(uint64_t hash, size_t word) noexcept;
+  };
+
+  template < class Key >
+  BloomFilter< Key >::BloomFilter(): m_Blocks(), m_Capacity(0), m_Load(0)
+  {
+  }
+
+  template < class Key >
+  bool BloomFilter< Key >::enabled() const noexcept
+  {
+    return !m_Blocks.empty();
+  }
+
+  // Empties the filter and sizes it for capacity keys.
+  template < class Key >
+  void BloomFilter< Key >::reset(size_t capacity)
+  {
+    if constexpr (!IS_AVAILABLE)
+    {
+      throw std::logic_error("Bloom filter needs a std::hash specialization for the key type.");
+    }
+
+    size_t blockBits = WORDS * 32;
+    size_t blockCount = (capacity * BITS_PER_KEY + blockBits - 1) / blockBits;
+    m_Blocks.assign(blockCount != 0 ? blockCount : 1, Block{});
+    m_Capacity = capacity;
+    m_Load = 0;
+  }
+
+  template < class Key >
+  void BloomFilter< Key >::disable() noexcept
+  {
+    m_Blocks.clear();
+    m_Blocks.shrink_to_fit();
+    m_Capacity = 0;
+    m_Load = 0;
+  }
+
+  // Returns false once the filter holds more keys than it was sized for, when its false positive rate climbs.
+  template < class Key >
+  bool BloomFilter< Key >::add(const Key& key) noexcept
+  {
+    if (m_Blocks.empty())
+    {
+      return true;
+    }
+
+    uint64_t hash = hashOf(key);
+    Block& block = m_Blocks[blockOf(hash)];
+    for (size_t word = 0; word < WORDS; word++)
+    {
+      block.m_Words[word] |= bitOf(hash, word);
+    }
+
+    return ++m_Load <= m_Capacity;
+  }
+
+  template < class Key >
+  bool BloomFilter< Key >::mayContain(const Key& key) const noexcept
+  {
+    if (m_Blocks.empty())
+    {
+      return true;
+    }
+
+    uint64_t hash = hashOf(key);
+    const Block& block = m_Blocks[blockOf(hash)];
+    bool present = true;
+    for (size_t word = 0; word < WORDS; word++)
+    {
+      present &= (block.m_Words[word] & bitOf(hash, word)) != 0;
+    }
+
+    return present;
+  }
+
+  // std::hash of integers is the identity in common standard libraries, so the hash is put through the splitmix64
+  // finalizer before its halves choose the block and the bits.
+  template < class Key >
+  uint64_t BloomFilter< Key >::hashOf(const Key& key) noexcept
+  {
+    if constexpr (IS_AVAILABLE)
+    {
+      uint64_t hash = static_cast< uint64_t >(std::hash< Key >()(key));
+      hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+      hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+      return hash ^ (hash >> 31);
+    }
+    else
+    {
+      return 0;
+    }
+  }
+
+  // Lemire's multiply-shift maps the high half of the hash onto the blocks without a division.
+  template < class Key >
+  size_t BloomFilter< Key >::blockOf(uint64_t hash) const noexcept
+  {
+    return static_cast< size_t >(((hash >> 32) * m_Blocks.size()) >> 32);
+  }
+
+  template < class Key >
+  uint32_t BloomFilter< Key >::bitOf(uint64_t hash, size_t word) noexcept
+  {
+    static constexpr uint32_t SALTS[WORDS] = { 0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du, 0x705495C7u,
+      0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u };
+
+    return uint32_t(1) << ((static_cast< uint32_t >(hash) * SALTS[word]) >> 27);
+  }
+}
+#endif
@@ -6,7 +6,7 @@ namespace bavykin
   {
     forward_list< std::string > entries = splitString(raw_command, " ");
 
-    if (entries.size() < 2)
+    if (entries[0].empty())
     {
       throw std::invalid_argument("String '" + raw_command + "' cannot be used as a command.");
     }
@@ -16,7 +16,7 @@ namespace bavykin
     m_Args = entries;
   }
 
-  std::string Command::getOperation() const
+  const std::string& Command::getOperation() const
   {
     return m_Operation;
   }
@@ -9,7 +9,7 @@ namespace bavykin
   public:
     Command(const std::string& raw_command);
 
-    std::string getOperation() const;
+    const std::string& getOperation() const;
     forward_list< std::string > getArgs() const;
 
   private:
@@ -1,13 +1,137 @@
 #include "CommandExecutor.h"
 
+#include <atomic>
+#include <charconv>
+#include <exception>
+#include <iomanip>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "SpscQueue.h"
+#include "ThreadPool.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace bavykin
 {
-  CommandExecutor::CommandExecutor()
+  namespace
+  {
+    const size_t OUTPUT_FLUSH_THRESHOLD = 1 << 16;
+    const size_t INPUT_CHUNK_SIZE = 1 << 16;
+    const size_t PIPELINE_QUEUE_CAPACITY = 1024;
+    // A stage that finds its queue full or empty yields this many times before it sleeps, so a short stall costs no
+    // wake-up while one waiting on I/O does not keep a core busy.
+    const size_t PIPELINE_SPIN_ATTEMPTS = 64;
+    // print traffic is skewed towards a few datasets, which the dataset dictionary's lookup cache answers without a
+    // descent; a few hundred slots keep the hot names without colliding.
+    const size_t DATASET_LOOKUP_CACHE_SLOTS = 256;
+
+    thread_local std::string* t_CommandOutput = nullptr;
+
+    struct ParsedCommand
+    {
+      const CommandExecutor::RegisteredCommand* m_Command;
+      forward_list< std::string > m_Args;
+      bool m_Last;
+    };
+
+    struct FormattedOutput
+    {
+      std::string m_Text;
+      bool m_Last;
+    };
+
+    struct ScheduledCommand
+    {
+      const CommandExecutor::RegisteredCommand* m_Command;
+      forward_list< std::string > m_Args;
+      std::string m_Output;
+      std::vector< size_t > m_Dependents;
+      size_t m_Blockers;
+    };
+
+    void addDependency(std::vector< ScheduledCommand >& commands, size_t from, size_t to)
+    {
+      std::vector< size_t >& dependents = commands[from].m_Dependents;
+      if (dependents.empty() || dependents.back() != to)
+      {
+        dependents.push_back(to);
+        commands[to].m_Blockers++;
+      }
+    }
+
+    template < typename T >
+    bool pushOrAbort(SpscQueue< T >& queue, T&& value, const std::atomic< bool >& aborted)
+    {
+      for (size_t attempt = 1; !queue.tryPush(std::move(value)); attempt++)
+      {
+        if (aborted.load(std::memory_order_relaxed))
+        {
+          return false;
+        }
+
+        if (attempt < PIPELINE_SPIN_ATTEMPTS)
+        {
+          std::this_thread::yield();
+        }
+        else
+        {
+          queue.waitForSpace(aborted);
+        }
+      }
+
+      return true;
+    }
+
+    template < typename T >
+    bool popOrAbort(SpscQueue< T >& queue, T& value, const std::atomic< bool >& aborted)
+    {
+      for (size_t attempt = 1; !queue.tryPop(value); attempt++)
+      {
+        if (aborted.load(std::memory_order_relaxed))
+        {
+          return false;
+        }
+
+        if (attempt < PIPELINE_SPIN_ATTEMPTS)
+        {
+          std::this_thread::yield();
+        }
+        else
+        {
+          queue.waitForItems(aborted);
+        }
+      }
+
+      return true;
+    }
+  }
+
+  CommandExecutor::CommandExecutor(std::ostream& output, size_t resultCacheCapacity):
+    m_ResultCache(resultCacheCapacity),
+    m_NextVersion(0),
+    m_Output(output),
+    m_DeferFlush(false)
   {
-    reg_command("print", &CommandExecutor::print);
-    reg_command("complement", &CommandExecutor::complement);
-    reg_command("intersect", &CommandExecutor::intersect);
-    reg_command("union", &CommandExecutor::myUnion);
+    m_OutputBuffer.reserve(OUTPUT_FLUSH_THRESHOLD * 2);
+    m_Dictionaries.resizeLookupCache(DATASET_LOOKUP_CACHE_SLOTS);
+
+    reg_command("print", &CommandExecutor::print, CommandKind::Query);
+    reg_command("check", &CommandExecutor::check, CommandKind::Query);
+    reg_command("complement", &CommandExecutor::complement, CommandKind::Derive);
+    reg_command("intersect", &CommandExecutor::intersect, CommandKind::Derive);
+    reg_command("union", &CommandExecutor::myUnion, CommandKind::Derive);
+    reg_command("save", &CommandExecutor::save, CommandKind::Exclusive);
+    reg_command("load", &CommandExecutor::load, CommandKind::Exclusive);
+    reg_command("stats", &CommandExecutor::stats, CommandKind::Exclusive);
   }
 
   void CommandExecutor::readFile(std::istream& input)
@@ -19,140 +143,726 @@ namespace bavykin
       {
         forward_list< std::string > splittedCommandLine = splitString(line, " ");
         const std::string dictionaryName = splittedCommandLine[0];
-        dictionary< int, std::string > fillingDictionary(dictionaryName);
+        std::shared_ptr< DataSet > fillingDictionary = std::make_shared< DataSet >(dictionaryName);
         splittedCommandLine.popFront();
+        DataSet::iterator position = fillingDictionary->end();
         while (splittedCommandLine.size() > 0)
         {
-          fillingDictionary.insert(std::stoi(splittedCommandLine[0]), splittedCommandLine[1]);
+          position = fillingDictionary->insert(position, std::stoi(splittedCommandLine[0]),
+            DataSetValue(splittedCommandLine[1]));
           splittedCommandLine.popFront();
           splittedCommandLine.popFront();
         }
-        m_Dictionaries.insert(dictionaryName, fillingDictionary);
+        m_Dictionaries.insert(dictionaryName, bind(SetExpression::fromDataSet(fillingDictionary)));
       }
     }
   }
 
+  CommandExecutor::~CommandExecutor()
+  {
+    flushOutput();
+  }
+
   void CommandExecutor::run(std::istream& input)
+  {
+    run(input, std::cin);
+  }
+
+  void CommandExecutor::run(std::istream& input, std::istream& commands)
   {
     readFile(input);
+    execute(commands);
+  }
 
+  void CommandExecutor::execute(std::istream& commands)
+  {
     std::string line = "";
-    while (getline(std::cin, line))
+    while (getline(commands, line))
     {
-      if (!line.empty())
+      execute(line);
+    }
+
+    flushOutput();
+  }
+
+  void CommandExecutor::execute(int fileDescriptor)
+  {
+    std::string pending = "";
+    std::string chunk(INPUT_CHUNK_SIZE, '\0');
+
+    while (true)
+    {
+#ifdef _WIN32
+      int received = _read(fileDescriptor, &chunk[0], static_cast< unsigned int >(chunk.size()));
+#else
+      ssize_t received = read(fileDescriptor, &chunk[0], chunk.size());
+#endif
+      if (received <= 0)
       {
-        try
+        break;
+      }
+
+      pending.append(chunk, 0, static_cast< size_t >(received));
+
+      size_t lineStart = 0;
+      size_t lineEnd = 0;
+      while ((lineEnd = pending.find('\n', lineStart)) != std::string::npos)
+      {
+        execute(pending.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+      }
+      pending.erase(0, lineStart);
+    }
+
+    execute(pending);
+    flushOutput();
+  }
+
+  void CommandExecutor::execute(const std::string& line)
+  {
+    if (line.empty())
+    {
+      return;
+    }
+
+    try
+    {
+      Command currentCommand(line);
+      const RegisteredCommand* registered = m_RegisteredCommands.find(currentCommand.getOperation());
+      if (registered != nullptr)
+      {
+        forward_list< std::string > args = currentCommand.getArgs();
+        invoke(*registered, args);
+      }
+      else
+      {
+        throw std::invalid_argument("The command is not registered.");
+      }
+    }
+    catch (const std::invalid_argument&)
+    {
+      writeLine("<INVALID COMMAND>");
+    }
+  }
+
+  void CommandExecutor::executePipelined(std::istream& commands)
+  {
+    flushOutput();
+
+    SpscQueue< ParsedCommand > parsed(PIPELINE_QUEUE_CAPACITY);
+    SpscQueue< FormattedOutput > formatted(PIPELINE_QUEUE_CAPACITY);
+    std::atomic< bool > aborted(false);
+    std::exception_ptr readerFailure = nullptr;
+    std::exception_ptr executorFailure = nullptr;
+    std::exception_ptr writerFailure = nullptr;
+    // A failing stage wakes the others, which may be asleep on either queue.
+    auto abort = [&]() {
+      aborted = true;
+      parsed.wake();
+      formatted.wake();
+    };
+
+    std::thread reader([&]() {
+      try
+      {
+        std::string line = "";
+        while (getline(commands, line))
         {
-          Command currentCommand(line);
-          if (m_RegisteredCommands.contains(currentCommand.getOperation()))
+          if (line.empty())
           {
-            void (CommandExecutor:: * operation)(forward_list< std::string >);
-            operation = m_RegisteredCommands[currentCommand.getOperation()];
-            forward_list< std::string > args = currentCommand.getArgs();
-            (this->*operation)(args);
+            continue;
           }
-          else
+
+          ParsedCommand current = { nullptr, forward_list< std::string >(), false };
+          try
+          {
+            Command command(line);
+            const RegisteredCommand* registered = m_RegisteredCommands.find(command.getOperation());
+            if (registered != nullptr)
+            {
+              current.m_Command = registered;
+              current.m_Args = command.getArgs();
+            }
+          }
+          catch (const std::invalid_argument&)
+          {
+          }
+
+          if (!pushOrAbort(parsed, std::move(current), aborted))
+          {
+            return;
+          }
+        }
+
+        pushOrAbort(parsed, ParsedCommand{ nullptr, forward_list< std::string >(), true }, aborted);
+      }
+      catch (...)
+      {
+        readerFailure = std::current_exception();
+        abort();
+      }
+    });
+
+    std::thread writer([&]() {
+      try
+      {
+        std::string pending = "";
+        FormattedOutput current = { "", false };
+        while (popOrAbort(formatted, current, aborted) && !current.m_Last)
+        {
+          pending += current.m_Text;
+          if (pending.size() >= OUTPUT_FLUSH_THRESHOLD)
+          {
+            m_Output.write(pending.data(), static_cast< std::streamsize >(pending.size()));
+            pending.clear();
+          }
+        }
+
+        m_Output.write(pending.data(), static_cast< std::streamsize >(pending.size()));
+        m_Output.flush();
+      }
+      catch (...)
+      {
+        writerFailure = std::current_exception();
+        abort();
+      }
+    });
+
+    m_DeferFlush = true;
+    try
+    {
+      ParsedCommand current = { nullptr, forward_list< std::string >(), false };
+      while (popOrAbort(parsed, current, aborted) && !current.m_Last)
+      {
+        try
+        {
+          if (current.m_Command == nullptr)
           {
             throw std::invalid_argument("The command is not registered.");
           }
+          invoke(*current.m_Command, current.m_Args);
         }
         catch (const std::invalid_argument&)
         {
-          std::cout << "<INVALID COMMAND>" << std::endl;
+          writeLine("<INVALID COMMAND>");
+        }
+
+        if (!m_OutputBuffer.empty())
+        {
+          FormattedOutput output = { std::move(m_OutputBuffer), false };
+          m_OutputBuffer.clear();
+          if (!pushOrAbort(formatted, std::move(output), aborted))
+          {
+            break;
+          }
         }
       }
+
+      pushOrAbort(formatted, FormattedOutput{ "", true }, aborted);
+    }
+    catch (...)
+    {
+      executorFailure = std::current_exception();
+      abort();
+    }
+    m_DeferFlush = false;
+
+    reader.join();
+    writer.join();
+
+    for (const std::exception_ptr& failure : { executorFailure, readerFailure, writerFailure })
+    {
+      if (failure != nullptr)
+      {
+        std::rethrow_exception(failure);
+      }
     }
   }
 
-  void CommandExecutor::checkDictNames(forward_list< std::string > args)
+  void CommandExecutor::executeParallel(std::istream& commands, size_t threadCount)
   {
-    for (size_t i = 1; i < args.size(); i++)
+    flushOutput();
+
+    ThreadPool pool(threadCount);
+    std::vector< ScheduledCommand > segment;
+    std::unordered_set< std::string > defined;
+    std::unordered_map< std::string, size_t > lastWriter;
+    std::unordered_map< std::string, std::vector< size_t > > readers;
+
+    auto resetState = [&]() {
+      segment.clear();
+      lastWriter.clear();
+      readers.clear();
+      defined.clear();
+      for (auto i = m_Dictionaries.cbegin(); i != m_Dictionaries.cend(); ++i)
+      {
+        defined.insert(i.m_Current->m_Content.first);
+      }
+    };
+
+    auto addRead = [&](const std::string& name, size_t index) {
+      auto writer = lastWriter.find(name);
+      if (writer != lastWriter.end())
+      {
+        addDependency(segment, writer->second, index);
+      }
+      readers[name].push_back(index);
+    };
+
+    auto addWrite = [&](const std::string& name, size_t index) {
+      auto writer = lastWriter.find(name);
+      if (writer != lastWriter.end())
+      {
+        addDependency(segment, writer->second, index);
+      }
+      for (size_t reader : readers[name])
+      {
+        if (reader != index)
+        {
+          addDependency(segment, reader, index);
+        }
+      }
+      readers[name].clear();
+      lastWriter[name] = index;
+    };
+
+    auto runSegment = [&]() {
+      std::unique_ptr< std::atomic< size_t >[] > blockers(new std::atomic< size_t >[segment.size()]);
+      std::mutex failureMutex;
+      std::exception_ptr failure = nullptr;
+
+      std::function< void(size_t) > launch = [&](size_t index) {
+        pool.submit([&, index]() {
+          ScheduledCommand& current = segment[index];
+          t_CommandOutput = &current.m_Output;
+          try
+          {
+            invoke(*current.m_Command, current.m_Args);
+          }
+          catch (const std::invalid_argument&)
+          {
+            current.m_Output += "<INVALID COMMAND>\n";
+          }
+          catch (...)
+          {
+            std::lock_guard< std::mutex > lock(failureMutex);
+            if (failure == nullptr)
+            {
+              failure = std::current_exception();
+            }
+          }
+          t_CommandOutput = nullptr;
+
+          for (size_t dependent : current.m_Dependents)
+          {
+            if (--blockers[dependent] == 0)
+            {
+              launch(dependent);
+            }
+          }
+        });
+      };
+
+      for (size_t i = 0; i < segment.size(); i++)
+      {
+        blockers[i] = segment[i].m_Blockers;
+      }
+      for (size_t i = 0; i < segment.size(); i++)
+      {
+        if (segment[i].m_Command != nullptr && segment[i].m_Blockers == 0)
+        {
+          launch(i);
+        }
+      }
+      pool.wait();
+
+      if (failure != nullptr)
+      {
+        std::rethrow_exception(failure);
+      }
+
+      for (ScheduledCommand& current : segment)
+      {
+        m_OutputBuffer += current.m_Output;
+        flushIfFull();
+      }
+    };
+
+    resetState();
+
+    std::string line = "";
+    while (getline(commands, line))
     {
-      if (!m_Dictionaries.contains(args[i]))
+      if (line.empty())
+      {
+        continue;
+      }
+
+      ScheduledCommand current = { nullptr, forward_list< std::string >(), "", std::vector< size_t >(), 0 };
+      CommandKind kind = CommandKind::Query;
+      try
+      {
+        Command command(line);
+        const RegisteredCommand* registered = m_RegisteredCommands.find(command.getOperation());
+        if (registered != nullptr)
+        {
+          current.m_Command = registered;
+          current.m_Args = command.getArgs();
+          kind = registered->m_Kind;
+        }
+      }
+      catch (const std::invalid_argument&)
+      {
+      }
+
+      if (current.m_Command != nullptr && kind == CommandKind::Exclusive)
+      {
+        runSegment();
+        execute(line);
+        resetState();
+        continue;
+      }
+
+      size_t index = segment.size();
+      const forward_list< std::string >& args = current.m_Args;
+      bool valid = false;
+      if (current.m_Command != nullptr && kind == CommandKind::Query)
+      {
+        valid = args.size() == 1 && defined.count(args[0]) != 0;
+      }
+      else if (current.m_Command != nullptr && kind == CommandKind::Derive)
+      {
+        valid = args.size() >= 3;
+        if (valid)
+        {
+          for (auto i = std::next(args.cbegin()); valid && i != args.cend(); ++i)
+          {
+            valid = defined.count(*i) != 0;
+          }
+        }
+      }
+
+      if (!valid)
+      {
+        current.m_Command = nullptr;
+        current.m_Output = "<INVALID COMMAND>\n";
+        segment.push_back(std::move(current));
+        continue;
+      }
+
+      segment.push_back(std::move(current));
+      for (auto i = kind == CommandKind::Derive ? ++args.cbegin() : args.cbegin(); i != args.cend(); ++i)
       {
-        throw std::invalid_argument("Invalid argument.");
+        addRead(*i, index);
+      }
+      if (kind == CommandKind::Derive)
+      {
+        addWrite(args[0], index);
+        if (defined.insert(args[0]).second && !m_Dictionaries.contains(args[0]))
+        {
+          m_Dictionaries.insert(args[0],
+            bind(std::make_shared< const SetExpression >(std::make_shared< const DataSet >(args[0]))));
+        }
       }
     }
+
+    runSegment();
+    flushOutput();
   }
 
-  void CommandExecutor::print(forward_list< std::string > args)
+  void CommandExecutor::flushOutput()
   {
-    if (args.size() != 1)
+    if (!m_OutputBuffer.empty())
     {
-      throw std::invalid_argument("Invalid number of command arguments.");
+      m_Output.write(m_OutputBuffer.data(), static_cast< std::streamsize >(m_OutputBuffer.size()));
+      m_OutputBuffer.clear();
     }
 
-    if (!m_Dictionaries.contains(args[0]))
+    m_Output.flush();
+  }
+
+  std::string& CommandExecutor::outputBuffer()
+  {
+    return t_CommandOutput != nullptr ? *t_CommandOutput : m_OutputBuffer;
+  }
+
+  void CommandExecutor::writeLine(const std::string& line)
+  {
+    std::string& buffer = outputBuffer();
+    buffer += line;
+    buffer += '\n';
+
+    flushIfFull();
+  }
+
+  void CommandExecutor::flushIfFull()
+  {
+    if (!m_DeferFlush && t_CommandOutput == nullptr && m_OutputBuffer.size() >= OUTPUT_FLUSH_THRESHOLD)
+    {
+      m_Output.write(m_OutputBuffer.data(), static_cast< std::streamsize >(m_OutputBuffer.size()));
+      m_OutputBuffer.clear();
+    }
+  }
+
+  void CommandExecutor::writeDictionary(const std::string& name, const SetExpression& value)
+  {
+    if (value.size() == 0)
+    {
+      writeLine("<EMPTY>");
+      return;
+    }
+
+    std::string& buffer = outputBuffer();
+    buffer += name;
+    value.forEach([&buffer](int key, const DataSetValue& entry) {
+      char keyText[16];
+      char* keyEnd = std::to_chars(keyText, keyText + sizeof(keyText), key).ptr;
+
+      buffer += ' ';
+      buffer.append(keyText, keyEnd);
+      buffer += ' ';
+      buffer += std::string_view(entry);
+    });
+
+    writeLine("");
+  }
+
+  void CommandExecutor::saveState(const std::string& path) const
+  {
+    DataSets materialized;
+    for (auto i = m_Dictionaries.cbegin(); i != m_Dictionaries.cend(); ++i)
+    {
+      materialized.insert(i.m_Current->m_Content.first, i.m_Current->m_Content.second.m_Value->materialize());
+    }
+
+    saveSnapshot(path, materialized);
+  }
+
+  void CommandExecutor::restoreState(const std::string& path)
+  {
+    DataSets loaded = loadSnapshot(path);
+    std::vector< std::pair< std::string, NamedDataSet > > restored;
+    for (auto i = loaded.cbegin(); i != loaded.cend(); ++i)
+    {
+      restored.emplace_back(i.m_Current->m_Content.first,
+        bind(SetExpression::fromDataSet(i.m_Current->m_Content.second)));
+    }
+
+    m_Dictionaries.assignSorted(restored.begin(), restored.end());
+    m_ResultCache.clear();
+  }
+
+  CommandExecutor::NamedDataSet CommandExecutor::dataSet(const std::string& name) const
+  {
+    try
+    {
+      return m_Dictionaries.find(name).m_Current->m_Content.second;
+    }
+    catch (const std::runtime_error&)
     {
       throw std::invalid_argument("Invalid argument.");
     }
+  }
 
-    dictionary < int, std::string > toPrint = m_Dictionaries[args[0]];
-    std::cout << toPrint << std::endl;
+  CommandExecutor::NamedDataSet CommandExecutor::bind(ExpressionHandle value)
+  {
+    return NamedDataSet{ std::move(value), ++m_NextVersion };
   }
 
-  void CommandExecutor::complement(forward_list< std::string > args)
+  void CommandExecutor::derive(forward_list< std::string > args, SetExpression::Operation operation)
   {
-    if (args.size() != 3)
+    if (args.size() < 3)
     {
       throw std::invalid_argument("Invalid number of command arguments.");
     }
 
-    checkDictNames(args);
+    std::vector< ExpressionHandle > operands;
+    std::vector< uint64_t > inputs;
+    for (auto i = ++args.cbegin(); i != args.cend(); ++i)
+    {
+      NamedDataSet operand = dataSet(*i);
+      operands.push_back(std::move(operand.m_Value));
+      inputs.push_back(operand.m_Version);
+    }
 
-    std::string newDataSet = args[0];
-    std::string dataSetOne = args[1];
-    std::string dataSetTwo = args[2];
+    ResultCache::Result cached = { nullptr, 0 };
+    if (m_ResultCache.find(operation, inputs, cached))
+    {
+      m_Dictionaries[args[0]] = NamedDataSet{ cached.m_Value, cached.m_Version };
+      return;
+    }
 
-    dictionary< int, std::string > newDict(newDataSet);
-    newDict = m_Dictionaries[dataSetOne];
-    newDict.changeName(newDataSet);
+    NamedDataSet result = bind(SetExpression::combine(operation, args[0], std::move(operands)));
+    m_ResultCache.insert(operation, inputs, ResultCache::Result{ result.m_Value, result.m_Version });
+    m_Dictionaries[args[0]] = result;
+  }
 
-    m_Dictionaries.insert(newDataSet, newDict.getComplement(m_Dictionaries[dataSetTwo]));
+  void CommandExecutor::print(forward_list< std::string > args)
+  {
+    if (args.size() != 1)
+    {
+      throw std::invalid_argument("Invalid number of command arguments.");
+    }
+
+    writeDictionary(args[0], *dataSet(args[0]).m_Value);
+  }
+
+  void CommandExecutor::complement(forward_list< std::string > args)
+  {
+    derive(args, SetExpression::Operation::Complement);
   }
 
   void CommandExecutor::intersect(forward_list< std::string > args)
   {
-    if (args.size() != 3)
+    derive(args, SetExpression::Operation::Intersect);
+  }
+
+  void CommandExecutor::myUnion(forward_list< std::string > args)
+  {
+    derive(args, SetExpression::Operation::Union);
+  }
+
+  void CommandExecutor::save(forward_list< std::string > args)
+  {
+    if (args.size() != 1)
     {
       throw std::invalid_argument("Invalid number of command arguments.");
     }
 
-    checkDictNames(args);
+    try
+    {
+      saveState(args[0]);
+    }
+    catch (const std::runtime_error&)
+    {
+      throw std::invalid_argument("The snapshot cannot be saved.");
+    }
+  }
 
-    std::string newDataSet = args[0];
-    std::string dataSetOne = args[1];
-    std::string dataSetTwo = args[2];
+  void CommandExecutor::load(forward_list< std::string > args)
+  {
+    if (args.size() != 1)
+    {
+      throw std::invalid_argument("Invalid number of command arguments.");
+    }
 
-    dictionary< int, std::string > newDict(newDataSet);
-    newDict = m_Dictionaries[dataSetOne];
-    newDict.changeName(newDataSet);
+    try
+    {
+      restoreState(args[0]);
+    }
+    catch (const std::runtime_error&)
+    {
+      throw std::invalid_argument("The snapshot cannot be loaded.");
+    }
+  }
 
-    m_Dictionaries.insert(newDataSet, newDict.getIntersect(m_Dictionaries[dataSetTwo]));
+  void CommandExecutor::stats(forward_list< std::string > args)
+  {
+    if (args.size() != 0)
+    {
+      throw std::invalid_argument("Invalid number of command arguments.");
+    }
+
+    for (const std::string& line : statisticsLines())
+    {
+      writeLine(line);
+    }
   }
 
-  void CommandExecutor::myUnion(forward_list< std::string > args)
+  // Reports the tree shape of a dataset and whether its invariants hold. Dense datasets are checked in the tree form
+  // they are materialized into.
+  void CommandExecutor::check(forward_list< std::string > args)
   {
-    if (args.size() != 3)
+    if (args.size() != 1)
     {
       throw std::invalid_argument("Invalid number of command arguments.");
     }
 
-    checkDictNames(args);
+    const SetExpression& value = *dataSet(args[0]).m_Value;
+    std::ostringstream line;
+    line << args[0];
 
-    std::string newDataSet = args[0];
-    std::string dataSetOne = args[1];
-    std::string dataSetTwo = args[2];
+    // A dense dataset is checked as it is stored, not through the tree it would materialize into.
+    DenseHandle dense = value.dense();
+    if (dense != nullptr)
+    {
+      KeyBitmap::ShapeStatistics shape = dense->keys().shapeStats();
+      line << " storage dense keys " << shape.m_Keys << " values " << dense->values().size() << " containers "
+           << shape.m_Containers << " bitmap-containers " << shape.m_BitmapContainers << " count-mismatches "
+           << shape.m_CountMismatches << " order-violations " << shape.m_OrderViolations
+           << (shape.isValid() && shape.m_Keys == dense->values().size() ? " valid" : " invalid");
+      writeLine(line.str());
+      return;
+    }
+
+    DataSet::ShapeStatistics shape = value.materialize()->shapeStats();
+    line << " storage tree nodes " << shape.m_Nodes << " height " << shape.m_Height << " average-depth " << std::fixed
+         << std::setprecision(2) << shape.m_AverageDepth << " maximum-depth " << shape.m_MaximumDepth
+         << " balance-violations " << shape.m_BalanceViolations << " parent-mismatches " << shape.m_ParentMismatches
+         << " order-violations " << shape.m_OrderViolations << (shape.isValid() ? " valid" : " invalid");
+    writeLine(line.str());
+  }
 
-    dictionary< int, std::string > newDict(newDataSet);
-    newDict = m_Dictionaries[dataSetOne];
-    newDict.changeName(newDataSet);
+  void CommandExecutor::writeStatistics(std::ostream& out) const
+  {
+    for (const std::string& line : statisticsLines())
+    {
+      out << line << "\n";
+    }
+    out.flush();
+  }
 
-    m_Dictionaries.insert(newDataSet, newDict.getUnion(m_Dictionaries[dataSetTwo]));
+  // The result cache and lookup cache lines are always present; latency histograms (in nanoseconds, per command) and
+  // tree counters follow when the build has instrumentation compiled in.
+  std::vector< std::string > CommandExecutor::statisticsLines() const
+  {
+    std::vector< std::string > lines;
+
+    ResultCache::Statistics cache = m_ResultCache.statistics();
+    lines.push_back("result-cache hits " + std::to_string(cache.m_Hits) + " misses " + std::to_string(cache.m_Misses) +
+      " evictions " + std::to_string(cache.m_Evictions) + " entries " + std::to_string(cache.m_Entries));
+    dictionary< std::string, NamedDataSet >::LookupStatistics lookups = m_Dictionaries.lookupStatistics();
+    lines.push_back("lookup-cache hits " + std::to_string(lookups.m_Hits) + " misses " +
+      std::to_string(lookups.m_Misses) + " slots " + std::to_string(lookups.m_Slots));
+
+#ifdef BAVYKIN_INSTRUMENTATION
+    for (const CommandLatency& latency : m_Latencies)
+    {
+      const instrumentation::LatencyHistogram& histogram = *latency.m_Histogram;
+      lines.push_back("latency " + latency.m_Name + " count " + std::to_string(histogram.count()) + " mean " +
+        std::to_string(histogram.mean()) + " p50 " + std::to_string(histogram.percentile(0.5)) + " p90 " +
+        std::to_string(histogram.percentile(0.9)) + " p99 " + std::to_string(histogram.percentile(0.99)) + " max " +
+        std::to_string(histogram.maximum()));
+    }
+
+    instrumentation::CounterRegistry::Totals tree = instrumentation::CounterRegistry::instance().totals();
+    auto total = [&tree](instrumentation::TreeCounter counter) {
+      return std::to_string(tree[static_cast< size_t >(counter)]);
+    };
+    lines.push_back("tree comparisons " + total(instrumentation::TreeCounter::Comparisons) + " visits " +
+      total(instrumentation::TreeCounter::NodeVisits) + " rotations " +
+      total(instrumentation::TreeCounter::Rotations) + " allocations " +
+      total(instrumentation::TreeCounter::Allocations));
+#endif
+
+    return lines;
+  }
+
+  void CommandExecutor::invoke(const RegisteredCommand& command, forward_list< std::string > args)
+  {
+#ifdef BAVYKIN_INSTRUMENTATION
+    instrumentation::ScopedLatency latency(*command.m_Latency);
+#endif
+    (this->*command.m_Handler)(args);
   }
 
-  void CommandExecutor::reg_command(std::string command, void (CommandExecutor::* function)(forward_list< std::string >))
+  void CommandExecutor::reg_command(std::string command, Handler function, CommandKind kind)
   {
-    m_RegisteredCommands.insert(command, function);
+#ifdef BAVYKIN_INSTRUMENTATION
+    m_Latencies.push_back(CommandLatency{ command, std::make_unique< instrumentation::LatencyHistogram >() });
+    m_RegisteredCommands.insert(command, RegisteredCommand{ function, kind, m_Latencies.back().m_Histogram.get() });
+#else
+    m_RegisteredCommands.insert(command, RegisteredCommand{ function, kind });
+#endif
   }
 }
@@ -1,11 +1,21 @@
 #ifndef COMMANDEXECUTOR_H
 #define COMMANDEXECUTOR_H
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
 #include "Dictionary.h"
 #include "Command.h"
+#include "FlatStringMap.h"
 #include "ForwardList.h"
+#include "Instrumentation.h"
+#include "ResultCache.h"
+#include "SetExpression.h"
+#include "Snapshot.h"
 #include "StringUtils.h"
 
 namespace bavykin
@@ -13,21 +23,86 @@ namespace bavykin
   class CommandExecutor
   {
   public:
-    CommandExecutor();
+    using Handler = void (CommandExecutor::*)(forward_list< std::string >);
+
+    // How a command touches the datasets; the parallel scheduler derives dependencies from it.
+    enum class CommandKind
+    {
+      Query,     // reads args[0]
+      Derive,    // writes args[0] from args[1..n]
+      Exclusive  // may touch every dataset, runs alone
+    };
+
+    struct RegisteredCommand
+    {
+      Handler m_Handler;
+      CommandKind m_Kind;
+#ifdef BAVYKIN_INSTRUMENTATION
+      instrumentation::LatencyHistogram* m_Latency;
+#endif
+    };
+
+    CommandExecutor(std::ostream& output = std::cout, size_t resultCacheCapacity = 1024);
+    ~CommandExecutor();
 
     void readFile(std::istream& input);
     void run(std::istream& input);
+    void run(std::istream& input, std::istream& commands);
+    void execute(std::istream& commands);
+    void execute(int fileDescriptor);
+    void execute(const std::string& line);
+    void executePipelined(std::istream& commands);
+    void executeParallel(std::istream& commands, size_t threadCount = std::thread::hardware_concurrency());
+    void flushOutput();
+    void saveState(const std::string& path) const;
+    void restoreState(const std::string& path);
+    void writeStatistics(std::ostream& out) const;
 
   private:
-    dictionary < std::string, void (CommandExecutor::*)(forward_list< std::string >) > m_RegisteredCommands;
-    dictionary < std::string, dictionary < int, std::string > > m_Dictionaries;
+#ifdef BAVYKIN_INSTRUMENTATION
+    struct CommandLatency
+    {
+      std::string m_Name;
+      std::unique_ptr< instrumentation::LatencyHistogram > m_Histogram;
+    };
+
+#endif
+    // A bound dataset and the version it was bound with; the result cache keys derived datasets on input versions.
+    struct NamedDataSet
+    {
+      ExpressionHandle m_Value;
+      uint64_t m_Version;
+    };
+
+    FlatStringMap< RegisteredCommand > m_RegisteredCommands;
+    dictionary< std::string, NamedDataSet > m_Dictionaries;
+    ResultCache m_ResultCache;
+    std::atomic< uint64_t > m_NextVersion;
+    std::ostream& m_Output;
+    std::string m_OutputBuffer;
+    bool m_DeferFlush;
+#ifdef BAVYKIN_INSTRUMENTATION
+    std::vector< CommandLatency > m_Latencies;
+#endif
 
-    void checkDictNames(forward_list< std::string > args);
+    std::string& outputBuffer();
+    void flushIfFull();
+    void writeLine(const std::string& line);
+    std::vector< std::string > statisticsLines() const;
+    void invoke(const RegisteredCommand& command, forward_list< std::string > args);
+    void writeDictionary(const std::string& name, const SetExpression& value);
+    NamedDataSet dataSet(const std::string& name) const;
+    NamedDataSet bind(ExpressionHandle value);
+    void derive(forward_list< std::string > args, SetExpression::Operation operation);
     void print(forward_list< std::string > args);
     void complement(forward_list< std::string > args);
     void intersect(forward_list< std::string > args);
     void myUnion(forward_list< std::string > args);
-    void reg_command(std::string command, void (CommandExecutor::* function)(forward_list< std::string >));
+    void save(forward_list< std::string > args);
+    void load(forward_list< std::string > args);
+    void stats(forward_list< std::string > args);
+    void check(forward_list< std::string > args);
+    void reg_command(std::string command, Handler function, CommandKind kind);
   };
 }
 #endif
@@ -0,0 +1,507 @@
+#ifndef CONCURRENT_SKIP_LIST_H
+#define CONCURRENT_SKIP_LIST_H
+#include "ConcurrentSkipListIterator.h"
+#include "ConcurrentSkipListNode.h"
+#include "Instrumentation.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+
+namespace bavykin
+{
+  // Ordered map for many concurrent writers: a lazy skip list (Herlihy, Lev, Luchangco and Shavit). Lookups and
+  // iteration take no locks. insert and erase lock only the predecessors they relink and validate them once locked,
+  // so writers working on different parts of the key range do not contend.
+  //
+  // insert, erase, find, contains, lookup and iteration may be called from any number of threads at once. Iteration
+  // is weakly consistent: keys come in ascending order, every entry present for the whole walk is seen once, and
+  // entries inserted or erased during it may or may not be. Readers may still stand on a node being erased, so
+  // erased nodes are only retired; clear, reclaim and the destructor free them and need every other thread to be
+  // done with the list. Overwriting the value of an existing key happens under the node's lock, and lookup copies
+  // a value under the same lock, so use lookup for values that other threads may overwrite.
+  template < class Key, class Value, class Compare = std::less< Key > >
+  class ConcurrentSkipList
+  {
+  public:
+    using content_type = std::pair< Key, Value >;
+    using Node = ConcurrentSkipListNode< content_type >;
+    using iterator = ConcurrentSkipListIterator< content_type, false >;
+    using const_iterator = ConcurrentSkipListIterator< content_type, true >;
+
+    ConcurrentSkipList();
+    ConcurrentSkipList(Compare comp);
+    ConcurrentSkipList(const ConcurrentSkipList< Key, Value, Compare >& right) = delete;
+    ~ConcurrentSkipList();
+
+    ConcurrentSkipList< Key, Value, Compare >& operator=(
+      const ConcurrentSkipList< Key, Value, Compare >& right) = delete;
+
+    bool insert(const content_type& value);
+    bool insert(const Key& value);
+    bool erase(const Key& value);
+    void erase(const iterator& value);
+    void clear();
+    void reclaim();
+    bool empty() const;
+    size_t size() const;
+    iterator find(const Key& value) const;
+    bool contains(const Key& value) const;
+    bool lookup(const Key& value, Value& found) const;
+
+    iterator begin();
+    iterator end();
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+
+  private:
+    static constexpr int MAX_HEIGHT = 32;
+
+    Node* m_Head;
+    std::atomic< int > m_Height;
+    std::atomic< size_t > m_Size;
+    std::atomic< Node* > m_Retired;
+    Compare m_Comp;
+
+    static int randomHeight();
+    static bool lockPredecessors(Node** predecessors, Node** successors, int height, bool isInsert,
+      int& highestLocked);
+    static void unlockPredecessors(Node** predecessors, int highestLocked);
+    bool link(const content_type& value, bool overwrite);
+    int search(const Key& value, Node** predecessors, Node** successors) const;
+    Node* findLinked(const Key& value) const;
+    void retire(Node* value);
+    void deleteRetired();
+  };
+
+  template < class Key, class Value, class Compare >
+  ConcurrentSkipList< Key, Value, Compare >::ConcurrentSkipList():
+    m_Head(new Node(MAX_HEIGHT)),
+    m_Height(1),
+    m_Size(0),
+    m_Retired(nullptr),
+    m_Comp(Compare())
+  {
+  }
+
+  template < class Key, class Value, class Compare >
+  ConcurrentSkipList< Key, Value, Compare >::ConcurrentSkipList(Compare comp):
+    m_Head(new Node(MAX_HEIGHT)),
+    m_Height(1),
+    m_Size(0),
+    m_Retired(nullptr),
+    m_Comp(comp)
+  {
+  }
+
+  template < class Key, class Value, class Compare >
+  ConcurrentSkipList< Key, Value, Compare >::~ConcurrentSkipList()
+  {
+    clear();
+    delete m_Head;
+  }
+
+  // Inserts the entry, or overwrites the value if the key is present. Returns whether the key was new.
+  template < class Key, class Value, class Compare >
+  bool ConcurrentSkipList< Key, Value, Compare >::insert(const content_type& value)
+  {
+    return link(value, true);
+  }
+
+  // Inserts the key with a default value unless it is present. Returns whether the key was new.
+  template < class Key, class Value, class Compare >
+  bool ConcurrentSkipList< Key, Value, Compare >::insert(const Key& value)
+  {
+    return link({ value, Value() }, false);
+  }
+
+  // Marks the node first, which is the moment the key stops being present, then unlinks it from the top level down
+  // with its predecessors locked. Returns whether this call erased the key.
+  template < class Key, class Value, class Compare >
+  bool ConcurrentSkipList< Key, Value, Compare >::erase(const Key& value)
+  {
+    Node* predecessors[MAX_HEIGHT];
+    Node* successors[MAX_HEIGHT];
+    Node* victim = nullptr;
+    bool isMarked = false;
+
+    while (true)
+    {
+      int found = search(value, predecessors, successors);
+      if (!isMarked)
+      {
+        if (found == -1)
+        {
+          return false;
+        }
+
+        // A node still being linked is not inserted yet. A linked one found below its top level was reached from a
+        // stale height, and searching again sees the height its insertion published.
+        victim = successors[found];
+        if (!victim->m_FullyLinked.load(std::memory_order_acquire) || victim->m_Marked.load(std::memory_order_acquire))
+        {
+          return false;
+        }
+        if (victim->m_Height - 1 != found)
+        {
+          continue;
+        }
+
+        victim->m_Lock.lock();
+        if (victim->m_Marked.load(std::memory_order_relaxed))
+        {
+          victim->m_Lock.unlock();
+          return false;
+        }
+        victim->m_Marked.store(true, std::memory_order_release);
+        isMarked = true;
+      }
+
+      int highestLocked = -1;
+      if (!lockPredecessors(predecessors, successors, victim->m_Height, false, highestLocked))
+      {
+        unlockPredecessors(predecessors, highestLocked);
+        continue;
+      }
+
+      for (int level = victim->m_Height - 1; level >= 0; level--)
+      {
+        predecessors[level]->m_Next[level].store(victim->m_Next[level].load(std::memory_order_relaxed),
+          std::memory_order_release);
+      }
+      victim->m_Lock.unlock();
+      unlockPredecessors(predecessors, highestLocked);
+
+      m_Size.fetch_sub(1, std::memory_order_relaxed);
+      retire(victim);
+      return true;
+    }
+  }
+
+  template < class Key, class Value, class Compare >
+  void ConcurrentSkipList< Key, Value, Compare >::erase(const iterator& value)
+  {
+    erase(value.m_Current->m_Content.first);
+  }
+
+  // Not safe to run concurrently with anything else.
+  template < class Key, class Value, class Compare >
+  void ConcurrentSkipList< Key, Value, Compare >::clear()
+  {
+    Node* iterable = m_Head->m_Next[0].load(std::memory_order_relaxed);
+    while (iterable != nullptr)
+    {
+      Node* next = iterable->m_Next[0].load(std::memory_order_relaxed);
+      delete iterable;
+      iterable = next;
+    }
+
+    for (int level = 0; level < MAX_HEIGHT; level++)
+    {
+      m_Head->m_Next[level].store(nullptr, std::memory_order_relaxed);
+    }
+    m_Height.store(1, std::memory_order_relaxed);
+    m_Size.store(0, std::memory_order_relaxed);
+    deleteRetired();
+  }
+
+  // Frees the erased nodes. Not safe to run while another thread uses the list or holds an iterator into it.
+  template < class Key, class Value, class Compare >
+  void ConcurrentSkipList< Key, Value, Compare >::reclaim()
+  {
+    deleteRetired();
+  }
+
+  template < class Key, class Value, class Compare >
+  bool ConcurrentSkipList< Key, Value, Compare >::empty() const
+  {
+    return size() == 0;
+  }
+
+  // Exact when no update is in flight, otherwise a value the size had at some recent point.
+  template < class Key, class Value, class Compare >
+  size_t ConcurrentSkipList< Key, Value, Compare >::size() const
+  {
+    return m_Size.load(std::memory_order_relaxed);
+  }
+
+  template < class Key, class Value, class Compare >
+  typename ConcurrentSkipList< Key, Value, Compare >::iterator ConcurrentSkipList< Key, Value, Compare >::find(
+    const Key& value) const
+  {
+    return iterator(findLinked(value));
+  }
+
+  template < class Key, class Value, class Compare >
+  bool ConcurrentSkipList< Key, Value, Compare >::contains(const Key& value) const
+  {
+    return findLinked(value) != nullptr;
+  }
+
+  // Copies the value of the key, if present, under the node's lock, so a concurrent overwrite is never seen halfway.
+  template < class Key, class Value, class Compare >
+  bool ConcurrentSkipList< Key, Value, Compare >::lookup(const Key& value, Value& found) const
+  {
+    Node* node = findLinked(value);
+    if (node == nullptr)
+    {
+      return false;
+    }
+
+    std::lock_guard< std::mutex > lock(node->m_Lock);
+    if (node->m_Marked.load(std::memory_order_relaxed))
+    {
+      return false;
+    }
+    found = node->m_Content.second;
+
+    return true;
+  }
+
+  template < class Key, class Value, class Compare >
+  typename ConcurrentSkipList< Key, Value, Compare >::iterator ConcurrentSkipList< Key, Value, Compare >::begin()
+  {
+    return ++iterator(m_Head);
+  }
+
+  template < class Key, class Value, class Compare >
+  typename ConcurrentSkipList< Key, Value, Compare >::iterator ConcurrentSkipList< Key, Value, Compare >::end()
+  {
+    return iterator(nullptr);
+  }
+
+  template < class Key, class Value, class Compare >
+  typename ConcurrentSkipList< Key, Value, Compare >::const_iterator ConcurrentSkipList< Key, Value, Compare >::cbegin()
+    const
+  {
+    return ++const_iterator(m_Head);
+  }
+
+  template < class Key, class Value, class Compare >
+  typename ConcurrentSkipList< Key, Value, Compare >::const_iterator ConcurrentSkipList< Key, Value, Compare >::cend()
+    const
+  {
+    return const_iterator(nullptr);
+  }
+
+  // Each level is kept with probability 1/2, so a node is two levels tall on average.
+  template < class Key, class Value, class Compare >
+  int ConcurrentSkipList< Key, Value, Compare >::randomHeight()
+  {
+    thread_local std::minstd_rand random(static_cast< uint32_t >(std::hash< std::thread::id >()(
+      std::this_thread::get_id())));
+
+    uint32_t bits = static_cast< uint32_t >(random());
+    int height = 1;
+    while ((bits & 1) != 0 && height < MAX_HEIGHT)
+    {
+      height++;
+      bits >>= 1;
+    }
+
+    return height;
+  }
+
+  // Locks the distinct predecessors of the lowest height levels bottom-up, recording the highest level locked, and
+  // checks that each is still live and still points to its successor. An insertion also needs the successors live.
+  template < class Key, class Value, class Compare >
+  bool ConcurrentSkipList< Key, Value, Compare >::lockPredecessors(Node** predecessors, Node** successors, int height,
+    bool isInsert, int& highestLocked)
+  {
+    Node* previous = nullptr;
+    for (int level = 0; level < height; level++)
+    {
+      Node* predecessor = predecessors[level];
+      Node* successor = successors[level];
+      if (predecessor != previous)
+      {
+        predecessor->m_Lock.lock();
+        highestLocked = level;
+        previous = predecessor;
+      }
+
+      if (predecessor->m_Marked.load(std::memory_order_acquire) ||
+        predecessor->m_Next[level].load(std::memory_order_acquire) != successor ||
+        (isInsert && successor != nullptr && successor->m_Marked.load(std::memory_order_acquire)))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  template < class Key, class Value, class Compare >
+  void ConcurrentSkipList< Key, Value, Compare >::unlockPredecessors(Node** predecessors, int highestLocked)
+  {
+    Node* previous = nullptr;
+    for (int level = 0; level <= highestLocked; level++)
+    {
+      if (predecessors[level] != previous)
+      {
+        predecessors[level]->m_Lock.unlock();
+        previous = predecessors[level];
+      }
+    }
+  }
+
+  // A new node becomes visible level by level from the bottom and counts as inserted once m_FullyLinked is set. A
+  // present key found while still being linked is waited for; one being erased is retried until it is gone.
+  template < class Key, class Value, class Compare >
+  bool ConcurrentSkipList< Key, Value, Compare >::link(const content_type& value, bool overwrite)
+  {
+    int height = randomHeight();
+    int top = m_Height.load(std::memory_order_relaxed);
+    while (top < height && !m_Height.compare_exchange_weak(top, height, std::memory_order_relaxed))
+    {
+    }
+
+    Node* predecessors[MAX_HEIGHT];
+    Node* successors[MAX_HEIGHT];
+    while (true)
+    {
+      int found = search(value.first, predecessors, successors);
+      if (found != -1)
+      {
+        Node* existing = successors[found];
+        if (existing->m_Marked.load(std::memory_order_acquire))
+        {
+          std::this_thread::yield();
+          continue;
+        }
+        while (!existing->m_FullyLinked.load(std::memory_order_acquire))
+        {
+          std::this_thread::yield();
+        }
+        if (overwrite)
+        {
+          std::lock_guard< std::mutex > lock(existing->m_Lock);
+          if (existing->m_Marked.load(std::memory_order_relaxed))
+          {
+            continue;
+          }
+          existing->m_Content.second = value.second;
+        }
+        return false;
+      }
+
+      int highestLocked = -1;
+      if (!lockPredecessors(predecessors, successors, height, true, highestLocked))
+      {
+        unlockPredecessors(predecessors, highestLocked);
+        continue;
+      }
+
+      BAVYKIN_COUNT(Allocations, 1);
+      Node* inserted = new Node(value, height);
+      for (int level = 0; level < height; level++)
+      {
+        inserted->m_Next[level].store(successors[level], std::memory_order_relaxed);
+      }
+      for (int level = 0; level < height; level++)
+      {
+        predecessors[level]->m_Next[level].store(inserted, std::memory_order_release);
+      }
+      inserted->m_FullyLinked.store(true, std::memory_order_release);
+      unlockPredecessors(predecessors, highestLocked);
+
+      m_Size.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  // Fills the last node before value and the first node not before it on every level up to the tallest node, and
+  // returns the highest level value was found on, or -1.
+  template < class Key, class Value, class Compare >
+  int ConcurrentSkipList< Key, Value, Compare >::search(const Key& value, Node** predecessors, Node** successors) const
+  {
+    int found = -1;
+    size_t passed = 0;
+    Node* predecessor = m_Head;
+
+    for (int level = m_Height.load(std::memory_order_relaxed) - 1; level >= 0; level--)
+    {
+      Node* current = predecessor->m_Next[level].load(std::memory_order_acquire);
+      while (current != nullptr && m_Comp(current->m_Content.first, value))
+      {
+        passed++;
+        predecessor = current;
+        current = predecessor->m_Next[level].load(std::memory_order_acquire);
+      }
+
+      if (found == -1 && current != nullptr && !m_Comp(value, current->m_Content.first))
+      {
+        found = level;
+      }
+      predecessors[level] = predecessor;
+      successors[level] = current;
+    }
+    BAVYKIN_COUNT(NodeVisits, passed);
+    BAVYKIN_COUNT(Comparisons, passed * 2);
+
+    return found;
+  }
+
+  // Wait-free lookup: the key is present if its node is fully linked and not yet marked.
+  template < class Key, class Value, class Compare >
+  typename ConcurrentSkipList< Key, Value, Compare >::Node* ConcurrentSkipList< Key, Value, Compare >::findLinked(
+    const Key& value) const
+  {
+    size_t passed = 0;
+    Node* predecessor = m_Head;
+    Node* found = nullptr;
+
+    for (int level = m_Height.load(std::memory_order_relaxed) - 1; level >= 0 && found == nullptr; level--)
+    {
+      Node* current = predecessor->m_Next[level].load(std::memory_order_acquire);
+      while (current != nullptr && m_Comp(current->m_Content.first, value))
+      {
+        passed++;
+        predecessor = current;
+        current = predecessor->m_Next[level].load(std::memory_order_acquire);
+      }
+
+      if (current != nullptr && !m_Comp(value, current->m_Content.first))
+      {
+        found = current;
+      }
+    }
+    BAVYKIN_COUNT(NodeVisits, passed);
+    BAVYKIN_COUNT(Comparisons, passed * 2);
+
+    if (found == nullptr || !found->m_FullyLinked.load(std::memory_order_acquire) ||
+      found->m_Marked.load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+
+    return found;
+  }
+
+  template < class Key, class Value, class Compare >
+  void ConcurrentSkipList< Key, Value, Compare >::retire(Node* value)
+  {
+    Node* head = m_Retired.load(std::memory_order_relaxed);
+    do
+    {
+      value->m_Retired = head;
+    }
+    while (!m_Retired.compare_exchange_weak(head, value, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  template < class Key, class Value, class Compare >
+  void ConcurrentSkipList< Key, Value, Compare >::deleteRetired()
+  {
+    Node* iterable = m_Retired.exchange(nullptr, std::memory_order_acquire);
+    while (iterable != nullptr)
+    {
+      Node* next = iterable->m_Retired;
+      delete iterable;
+      iterable = next;
+    }
+  }
+}
+#endif
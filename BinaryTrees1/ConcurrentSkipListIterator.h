@@ -0,0 +1,98 @@
+#ifndef CONCURRENT_SKIP_LIST_ITERATOR_H
+#define CONCURRENT_SKIP_LIST_ITERATOR_H
+#include "ConcurrentSkipListNode.h"
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace bavykin
+{
+  // Walks the bottom level of a ConcurrentSkipList, stepping over nodes that are erased or still being inserted. An
+  // iterator standing on a node erased meanwhile keeps working: the node stays allocated until the list reclaims it,
+  // and its links still lead forward to nodes with larger keys.
+  template < class T, bool isConst = false >
+  class ConcurrentSkipListIterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t< isConst, const T*, T* >;
+    using reference = std::conditional_t< isConst, const T&, T& >;
+    using Node = ConcurrentSkipListNode< T >;
+    using iterator = ConcurrentSkipListIterator< T, isConst >;
+    using returntypePtr_t = std::conditional_t< isConst, const T*, T* >;
+    using returntype_t = std::conditional_t< isConst, const T, T >;
+
+    ConcurrentSkipListIterator();
+    ConcurrentSkipListIterator(Node* value);
+    bool operator==(const iterator& right) const;
+    bool operator!=(const iterator& right) const;
+    returntype_t& operator*() const;
+    returntypePtr_t operator->() const;
+    ConcurrentSkipListIterator& operator++();
+    const ConcurrentSkipListIterator operator++(int);
+
+    Node* m_Current;
+  };
+
+  template < class T, bool isConst >
+  ConcurrentSkipListIterator< T, isConst >::ConcurrentSkipListIterator(): m_Current(nullptr)
+  {
+  }
+
+  template < class T, bool isConst >
+  ConcurrentSkipListIterator< T, isConst >::ConcurrentSkipListIterator(Node* value): m_Current(value)
+  {
+  }
+
+  template < class T, bool isConst >
+  bool ConcurrentSkipListIterator< T, isConst >::operator==(const iterator& right) const
+  {
+    return m_Current == right.m_Current;
+  }
+
+  template < class T, bool isConst >
+  bool ConcurrentSkipListIterator< T, isConst >::operator!=(const iterator& right) const
+  {
+    return !(*this == right);
+  }
+
+  template < class T, bool isConst >
+  typename ConcurrentSkipListIterator< T, isConst >::returntype_t& ConcurrentSkipListIterator< T, isConst >::operator*()
+    const
+  {
+    return m_Current->m_Content;
+  }
+
+  template < class T, bool isConst >
+  typename ConcurrentSkipListIterator< T, isConst >::returntypePtr_t
+  ConcurrentSkipListIterator< T, isConst >::operator->() const
+  {
+    return &m_Current->m_Content;
+  }
+
+  template < class T, bool isConst >
+  ConcurrentSkipListIterator< T, isConst >& ConcurrentSkipListIterator< T, isConst >::operator++()
+  {
+    do
+    {
+      m_Current = m_Current->m_Next[0].load(std::memory_order_acquire);
+    }
+    while (m_Current != nullptr &&
+      (m_Current->m_Marked.load(std::memory_order_acquire) ||
+        !m_Current->m_FullyLinked.load(std::memory_order_acquire)));
+
+    return *this;
+  }
+
+  template < class T, bool isConst >
+  const ConcurrentSkipListIterator< T, isConst > ConcurrentSkipListIterator< T, isConst >::operator++(int)
+  {
+    iterator copy(*this);
+    ++(*this);
+    return copy;
+  }
+}
+#endif
@@ -0,0 +1,82 @@
+#ifndef CONCURRENT_SKIP_LIST_NODE_H
+#define CONCURRENT_SKIP_LIST_NODE_H
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace bavykin
+{
+  template < class T >
+  class ConcurrentSkipListNode
+  {
+  public:
+    using Node = ConcurrentSkipListNode;
+
+    ConcurrentSkipListNode(int height);
+    ConcurrentSkipListNode(const T& right, int height);
+    ConcurrentSkipListNode(T&& right, int height);
+
+    T m_Content;
+    int m_Height;
+    // One successor per level below m_Height. The node is on a level's list once its predecessor there points to it.
+    std::unique_ptr< std::atomic< Node* >[] > m_Next;
+    // Held by writers while they relink the node's successors, mark it or overwrite its value.
+    std::mutex m_Lock;
+    // Set when the node is logically erased, before it is unlinked.
+    std::atomic< bool > m_Marked;
+    // Set once the node is linked on every level; until then it does not count as inserted.
+    std::atomic< bool > m_FullyLinked;
+    // Chains erased nodes until the list reclaims them.
+    Node* m_Retired;
+
+  private:
+    void initializeLinks();
+  };
+
+  template < class T >
+  ConcurrentSkipListNode< T >::ConcurrentSkipListNode(int height):
+    m_Content(),
+    m_Height(height),
+    m_Next(new std::atomic< Node* >[height]),
+    m_Marked(false),
+    m_FullyLinked(false),
+    m_Retired(nullptr)
+  {
+    initializeLinks();
+  }
+
+  template < class T >
+  ConcurrentSkipListNode< T >::ConcurrentSkipListNode(const T& right, int height):
+    m_Content(right),
+    m_Height(height),
+    m_Next(new std::atomic< Node* >[height]),
+    m_Marked(false),
+    m_FullyLinked(false),
+    m_Retired(nullptr)
+  {
+    initializeLinks();
+  }
+
+  template < class T >
+  ConcurrentSkipListNode< T >::ConcurrentSkipListNode(T&& right, int height):
+    m_Content(std::move(right)),
+    m_Height(height),
+    m_Next(new std::atomic< Node* >[height]),
+    m_Marked(false),
+    m_FullyLinked(false),
+    m_Retired(nullptr)
+  {
+    initializeLinks();
+  }
+
+  template < class T >
+  void ConcurrentSkipListNode< T >::initializeLinks()
+  {
+    for (int level = 0; level < m_Height; level++)
+    {
+      m_Next[level].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+}
+#endif
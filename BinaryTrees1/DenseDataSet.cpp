@@ -0,0 +1,79 @@
+#include "DenseDataSet.h"
+
+#include <cstdint>
+#include <utility>
+
+namespace bavykin
+{
+  namespace
+  {
+    // A tree pays three pointers per key while a bitmap container pays two bytes per key at most, but a container
+    // also carries fixed overhead; requiring one key in every 64 of the covered range keeps that overhead small.
+    const uint64_t DENSE_RANGE_PER_KEY = 64;
+    const size_t DENSE_MINIMUM_SIZE = 64;
+  }
+
+  DenseDataSet::DenseDataSet(KeyBitmap keys, std::vector< DataSetValue > values):
+    m_Keys(std::move(keys)),
+    m_Values(std::move(values))
+  {
+  }
+
+  bool DenseDataSet::suits(size_t size, int minimum, int maximum)
+  {
+    uint64_t range = static_cast< uint64_t >(static_cast< int64_t >(maximum) - minimum) + 1;
+
+    return size >= DENSE_MINIMUM_SIZE && size * DENSE_RANGE_PER_KEY >= range;
+  }
+
+  DenseHandle DenseDataSet::fromDataSet(const DataSet& value)
+  {
+    std::vector< int > keys;
+    std::vector< DataSetValue > values;
+    keys.reserve(value.size());
+    values.reserve(value.size());
+    for (auto i = value.cbegin(); i != value.cend(); ++i)
+    {
+      keys.push_back(i.m_Current->m_Content.first);
+      values.push_back(i.m_Current->m_Content.second);
+    }
+
+    return std::make_shared< const DenseDataSet >(KeyBitmap::fromSorted(keys.begin(), keys.end()), std::move(values));
+  }
+
+  const KeyBitmap& DenseDataSet::keys() const noexcept
+  {
+    return m_Keys;
+  }
+
+  const std::vector< DataSetValue >& DenseDataSet::values() const noexcept
+  {
+    return m_Values;
+  }
+
+  size_t DenseDataSet::size() const noexcept
+  {
+    return m_Values.size();
+  }
+
+  DataSetHandle DenseDataSet::toDataSet(const std::string& name) const
+  {
+    std::vector< std::pair< int, DataSetValue > > entries;
+    entries.reserve(m_Values.size());
+    size_t index = 0;
+    for (auto i = m_Keys.cbegin(); i != m_Keys.cend(); ++i)
+    {
+      entries.emplace_back(*i, m_Values[index++]);
+    }
+
+    std::shared_ptr< DataSet > result = std::make_shared< DataSet >(name);
+    result->assignSorted(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+
+    return result;
+  }
+
+  size_t DenseDataSet::memoryUsage() const
+  {
+    return m_Keys.memoryUsage() + m_Values.capacity() * sizeof(DataSetValue);
+  }
+}
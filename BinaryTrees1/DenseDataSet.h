@@ -0,0 +1,36 @@
+#ifndef DENSE_DATA_SET_H
+#define DENSE_DATA_SET_H
+#include <memory>
+#include <string>
+#include <vector>
+#include "KeyBitmap.h"
+#include "Snapshot.h"
+
+namespace bavykin
+{
+  class DenseDataSet;
+  using DenseHandle = std::shared_ptr< const DenseDataSet >;
+
+  // Immutable dataset stored as a KeyBitmap of its keys plus the values in key order; the value of a key sits at the
+  // key's rank. Chosen instead of a tree for datasets whose keys cover their range densely enough that the
+  // per-node pointers would dominate.
+  class DenseDataSet
+  {
+  public:
+    DenseDataSet(KeyBitmap keys, std::vector< DataSetValue > values);
+
+    static bool suits(size_t size, int minimum, int maximum);
+    static DenseHandle fromDataSet(const DataSet& value);
+
+    const KeyBitmap& keys() const noexcept;
+    const std::vector< DataSetValue >& values() const noexcept;
+    size_t size() const noexcept;
+    DataSetHandle toDataSet(const std::string& name) const;
+    size_t memoryUsage() const;
+
+  private:
+    KeyBitmap m_Keys;
+    std::vector< DataSetValue > m_Values;
+  };
+}
+#endif
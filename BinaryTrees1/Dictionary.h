@@ -2,8 +2,11 @@
 #define DICTIONARY_H
 #include "BinarySearchTree.h"
 
+#include <ostream>
 #include <stdexcept>
+#include <string>
 #include <utility>
+#include <vector>
 
 namespace bavykin
 {
@@ -13,27 +16,49 @@ namespace bavykin
   public:
     using iterator = typename BST< K, V, Cmp >::iterator;
     using const_iterator = typename BST< K, V, Cmp >::const_iterator;
+    using ShapeStatistics = typename BST< K, V, Cmp >::ShapeStatistics;
+    using BatchStrategy = typename BST< K, V, Cmp >::BatchStrategy;
+    using LookupStatistics = typename BST< K, V, Cmp >::LookupStatistics;
 
     Dictionary(const std::string& name = "dictionary");
     Dictionary(const Dictionary& right);
+    Dictionary(Dictionary&& right) noexcept;
 
     Dictionary& operator=(const Dictionary& right);
-    V operator[](const K& key);
+    Dictionary& operator=(Dictionary&& right) noexcept;
+    V& operator[](const K& key);
     template < typename Key, typename Val, typename Comp >
     friend std::ostream& operator<<(std::ostream& out, const Dictionary< Key, Val, Comp >& value);
 
     size_t size() const noexcept;
     void insert(const K& key, const V& value);
     void insert(const iterator&);
+    iterator insert(const iterator& hint, const K& key, const V& value);
+    template < typename... Args >
+    iterator emplace_hint(const iterator& hint, Args&&... args);
     iterator find(const K& key);
+    const_iterator find(const K& key) const;
     bool contains(const K& key) const;
+    void findBatch(const std::vector< K >& keys, std::vector< const_iterator >& found) const;
+    void containsBatch(const std::vector< K >& keys, std::vector< bool >& found) const;
     void erase(const K& key);
+    template < typename RandomIt >
+    void assignSorted(RandomIt first, RandomIt last);
+    template < typename InputIt >
+    void insertBatch(InputIt first, InputIt last, BatchStrategy strategy = BatchStrategy::Automatic,
+      size_t threadCount = 1);
+    ShapeStatistics shapeStats() const;
+    bool validate() const;
+    void resizeLookupCache(size_t slots);
+    LookupStatistics lookupStatistics() const noexcept;
+    void useMembershipFilter(bool enabled);
 
     void changeName(const std::string& name);
+    const std::string& getName() const noexcept;
 
-    Dictionary getUnion(const Dictionary& right);
-    Dictionary getIntersect(const Dictionary& right);
-    Dictionary getComplement(const Dictionary& right);
+    Dictionary getUnion(const Dictionary& right) const;
+    Dictionary getIntersect(const Dictionary& right) const;
+    Dictionary getComplement(const Dictionary& right) const;
 
     iterator begin();
     iterator end();
@@ -80,12 +105,25 @@ namespace bavykin
     m_Name = right.m_Name;
   }
 
+  template < typename K, typename V, typename Cmp >
+  Dictionary< K, V, Cmp >::Dictionary(Dictionary&& right) noexcept:
+    m_Data(std::move(right.m_Data)),
+    m_Name(std::move(right.m_Name))
+  {
+  }
+
   template < typename K, typename V, typename Cmp >
   void Dictionary< K, V, Cmp >::changeName(const std::string& name)
   {
     m_Name = name;
   }
 
+  template < typename K, typename V, typename Cmp >
+  const std::string& Dictionary< K, V, Cmp >::getName() const noexcept
+  {
+    return m_Name;
+  }
+
   template < typename K, typename V, typename Cmp >
   size_t Dictionary< K, V, Cmp >::size() const noexcept
   {
@@ -104,6 +142,21 @@ namespace bavykin
     m_Data.insert(iter);
   }
 
+  template < typename K, typename V, typename Cmp >
+  typename Dictionary< K, V, Cmp >::iterator Dictionary< K, V, Cmp >::insert(const iterator& hint, const K& key,
+    const V& value)
+  {
+    return m_Data.insert(hint, std::make_pair(key, value));
+  }
+
+  template < typename K, typename V, typename Cmp >
+  template < typename... Args >
+  typename Dictionary< K, V, Cmp >::iterator Dictionary< K, V, Cmp >::emplace_hint(const iterator& hint,
+    Args&&... args)
+  {
+    return m_Data.emplace_hint(hint, std::forward< Args >(args)...);
+  }
+
   template < typename K, typename V, typename Cmp >
   bool Dictionary< K, V, Cmp >::contains(const K& key) const
   {
@@ -128,6 +181,40 @@ namespace bavykin
     throw std::runtime_error("Trying to find value from dictionary by key, which is not present.");
   }
 
+  template < typename K, typename V, typename Cmp >
+  typename Dictionary< K, V, Cmp >::const_iterator Dictionary< K, V, Cmp >::find(const K& key) const
+  {
+    const_iterator searched(m_Data.find(key).m_Current);
+
+    if (searched != m_Data.cend())
+    {
+      return searched;
+    }
+
+    throw std::runtime_error("Trying to find value from dictionary by key, which is not present.");
+  }
+
+  // Unlike find, keys that are not present do not throw; their entries are cend().
+  template < typename K, typename V, typename Cmp >
+  void Dictionary< K, V, Cmp >::findBatch(const std::vector< K >& keys, std::vector< const_iterator >& found) const
+  {
+    std::vector< iterator > nodes;
+    m_Data.findBatch(keys, nodes);
+
+    found.clear();
+    found.reserve(nodes.size());
+    for (const iterator& node : nodes)
+    {
+      found.emplace_back(node.m_Current);
+    }
+  }
+
+  template < typename K, typename V, typename Cmp >
+  void Dictionary< K, V, Cmp >::containsBatch(const std::vector< K >& keys, std::vector< bool >& found) const
+  {
+    m_Data.containsBatch(keys, found);
+  }
+
   template < typename K, typename V, typename Cmp >
   void Dictionary< K, V, Cmp >::erase(const K& key)
   {
@@ -135,13 +222,57 @@ namespace bavykin
   }
 
   template < typename K, typename V, typename Cmp >
-  Dictionary< K, V, Cmp > Dictionary< K, V, Cmp >::getUnion(const Dictionary& right)
+  template < typename RandomIt >
+  void Dictionary< K, V, Cmp >::assignSorted(RandomIt first, RandomIt last)
+  {
+    m_Data.assignSorted(first, last);
+  }
+
+  template < typename K, typename V, typename Cmp >
+  template < typename InputIt >
+  void Dictionary< K, V, Cmp >::insertBatch(InputIt first, InputIt last, BatchStrategy strategy, size_t threadCount)
+  {
+    m_Data.insertBatch(first, last, strategy, threadCount);
+  }
+
+  template < typename K, typename V, typename Cmp >
+  typename Dictionary< K, V, Cmp >::ShapeStatistics Dictionary< K, V, Cmp >::shapeStats() const
+  {
+    return m_Data.shapeStats();
+  }
+
+  template < typename K, typename V, typename Cmp >
+  bool Dictionary< K, V, Cmp >::validate() const
+  {
+    return m_Data.validate();
+  }
+
+  template < typename K, typename V, typename Cmp >
+  void Dictionary< K, V, Cmp >::resizeLookupCache(size_t slots)
+  {
+    m_Data.resizeLookupCache(slots);
+  }
+
+  template < typename K, typename V, typename Cmp >
+  typename Dictionary< K, V, Cmp >::LookupStatistics Dictionary< K, V, Cmp >::lookupStatistics() const noexcept
+  {
+    return m_Data.lookupStatistics();
+  }
+
+  template < typename K, typename V, typename Cmp >
+  void Dictionary< K, V, Cmp >::useMembershipFilter(bool enabled)
+  {
+    m_Data.useMembershipFilter(enabled);
+  }
+
+  template < typename K, typename V, typename Cmp >
+  Dictionary< K, V, Cmp > Dictionary< K, V, Cmp >::getUnion(const Dictionary& right) const
   {
     Dictionary newDict(right);
 
-    for (iterator i = begin(); i != end(); i++)
+    for (const_iterator i = cbegin(); i != cend(); i++)
     {
-      newDict.insert(i);
+      newDict.m_Data.insert(i.m_Current->m_Content);
     }
 
     newDict.m_Name = m_Name;
@@ -150,16 +281,15 @@ namespace bavykin
   }
 
   template < typename K, typename V, typename Cmp >
-  Dictionary< K, V, Cmp > Dictionary< K, V, Cmp >::getIntersect(const Dictionary& right)
+  Dictionary< K, V, Cmp > Dictionary< K, V, Cmp >::getIntersect(const Dictionary& right) const
   {
     Dictionary newDict(m_Name);
-    Dictionary copiedRightDict(right);
 
-    for (iterator i = begin(); i != end(); i++)
+    for (const_iterator i = cbegin(); i != cend(); i++)
     {
-      if (copiedRightDict.contains(i.m_Current->m_Content.first))
+      if (right.contains(i.m_Current->m_Content.first))
       {
-        newDict.insert(i);
+        newDict.m_Data.insert(i.m_Current->m_Content);
       }
     }
 
@@ -167,16 +297,15 @@ namespace bavykin
   }
 
   template < typename K, typename V, typename Cmp >
-  Dictionary< K, V, Cmp > Dictionary< K, V, Cmp >::getComplement(const Dictionary& right)
+  Dictionary< K, V, Cmp > Dictionary< K, V, Cmp >::getComplement(const Dictionary& right) const
   {
     Dictionary newDict(m_Name);
-    Dictionary copiedRightDict(right);
 
-    for (iterator i = begin(); i != end(); i++)
+    for (const_iterator i = cbegin(); i != cend(); i++)
     {
-      if (!copiedRightDict.contains(i.m_Current->m_Content.first))
+      if (!right.contains(i.m_Current->m_Content.first))
       {
-        newDict.insert(i);
+        newDict.m_Data.insert(i.m_Current->m_Content);
       }
     }
 
@@ -217,7 +346,16 @@ namespace bavykin
   }
 
   template < typename K, typename V, typename Cmp >
-  V Dictionary< K, V, Cmp >::operator[](const K& key)
+  Dictionary< K, V, Cmp >& Dictionary< K, V, Cmp >::operator=(Dictionary&& right) noexcept
+  {
+    m_Data = std::move(right.m_Data);
+    m_Name = std::move(right.m_Name);
+
+    return *this;
+  }
+
+  template < typename K, typename V, typename Cmp >
+  V& Dictionary< K, V, Cmp >::operator[](const K& key)
   {
     return m_Data[key];
   }
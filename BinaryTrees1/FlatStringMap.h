@@ -0,0 +1,130 @@
+#ifndef FLAT_STRING_MAP_H
+#define FLAT_STRING_MAP_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bavykin
+{
+  // Open-addressing string map with linear probing for small, read-mostly tables such as the command registry.
+  // A lookup hashes the key once and compares full strings only against slots carrying the same hash.
+  template < typename V >
+  class FlatStringMap
+  {
+  public:
+    FlatStringMap();
+
+    void insert(const std::string& key, const V& value);
+    const V* find(const std::string& key) const;
+    size_t size() const noexcept;
+
+  private:
+    struct Slot
+    {
+      std::string m_Key;
+      V m_Value;
+      uint64_t m_Hash;
+      bool m_Used;
+    };
+
+    std::vector< Slot > m_Slots;
+    size_t m_Size;
+
+    static uint64_t hash(const std::string& key);
+    void grow();
+  };
+
+  template < typename V >
+  FlatStringMap< V >::FlatStringMap(): m_Slots(16), m_Size(0)
+  {
+  }
+
+  template < typename V >
+  void FlatStringMap< V >::insert(const std::string& key, const V& value)
+  {
+    if ((m_Size + 1) * 2 > m_Slots.size())
+    {
+      grow();
+    }
+
+    uint64_t keyHash = hash(key);
+    size_t mask = m_Slots.size() - 1;
+    size_t index = static_cast< size_t >(keyHash) & mask;
+
+    while (m_Slots[index].m_Used)
+    {
+      if (m_Slots[index].m_Hash == keyHash && m_Slots[index].m_Key == key)
+      {
+        m_Slots[index].m_Value = value;
+        return;
+      }
+      index = (index + 1) & mask;
+    }
+
+    m_Slots[index] = Slot{ key, value, keyHash, true };
+    m_Size++;
+  }
+
+  template < typename V >
+  const V* FlatStringMap< V >::find(const std::string& key) const
+  {
+    uint64_t keyHash = hash(key);
+    size_t mask = m_Slots.size() - 1;
+    size_t index = static_cast< size_t >(keyHash) & mask;
+
+    while (m_Slots[index].m_Used)
+    {
+      if (m_Slots[index].m_Hash == keyHash && m_Slots[index].m_Key == key)
+      {
+        return &m_Slots[index].m_Value;
+      }
+      index = (index + 1) & mask;
+    }
+
+    return nullptr;
+  }
+
+  template < typename V >
+  size_t FlatStringMap< V >::size() const noexcept
+  {
+    return m_Size;
+  }
+
+  template < typename V >
+  uint64_t FlatStringMap< V >::hash(const std::string& key)
+  {
+    uint64_t result = 14695981039346656037ull;
+
+    for (unsigned char symbol : key)
+    {
+      result ^= symbol;
+      result *= 1099511628211ull;
+    }
+
+    return result;
+  }
+
+  template < typename V >
+  void FlatStringMap< V >::grow()
+  {
+    std::vector< Slot > old(m_Slots.size() * 2);
+    old.swap(m_Slots);
+    size_t mask = m_Slots.size() - 1;
+
+    for (Slot& slot : old)
+    {
+      if (slot.m_Used)
+      {
+        size_t index = static_cast< size_t >(slot.m_Hash) & mask;
+        while (m_Slots[index].m_Used)
+        {
+          index = (index + 1) & mask;
+        }
+        m_Slots[index] = std::move(slot);
+      }
+    }
+  }
+}
+#endif
@@ -2,12 +2,20 @@
 #define FORWARD_LIST_ITERATOR_H
 #include "ForwardListNode.h"
 #include <cassert>
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <type_traits>
 
 template < class T, bool isConst = false >
-class ListIterator : public std::iterator< std::forward_iterator_tag, T >
+class ListIterator
 {
 public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t< isConst, const T*, T* >;
+  using reference = std::conditional_t< isConst, const T&, T& >;
   using Node = ListNode< T >;
   using Iterator = ListIterator< T, isConst >;
   using returntypePtr_t = std::conditional_t< isConst, std::shared_ptr< const T >, std::shared_ptr< T > >;
@@ -0,0 +1,255 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Hot-path instrumentation, compiled in only when BAVYKIN_INSTRUMENTATION is defined. Without it the macros expand to
+// nothing and neither the trees nor the executor carry any counter, timer or histogram.
+#ifdef BAVYKIN_INSTRUMENTATION
+#define BAVYKIN_COUNT(counter, amount) \
+  ::bavykin::instrumentation::count(::bavykin::instrumentation::TreeCounter::counter, amount)
+#else
+#define BAVYKIN_COUNT(counter, amount) static_cast< void >(sizeof(amount))
+#endif
+
+namespace bavykin
+{
+  namespace instrumentation
+  {
+    enum class TreeCounter
+    {
+      Comparisons,
+      NodeVisits,
+      Rotations,
+      Allocations,
+      Count
+    };
+
+    // Each thread bumps its own block with a plain load and store, so counting costs no atomic read-modify-write
+    // and no shared cache line; totals add the blocks of every thread that ever counted.
+    class CounterRegistry
+    {
+    public:
+      using Totals = std::vector< uint64_t >;
+
+      static constexpr size_t COUNTER_COUNT = static_cast< size_t >(TreeCounter::Count);
+
+      struct alignas(64) Block
+      {
+        std::atomic< uint64_t > m_Values[COUNTER_COUNT];
+      };
+
+      static CounterRegistry& instance();
+
+      Block* attach();
+      Totals totals() const;
+
+    private:
+      mutable std::mutex m_Mutex;
+      std::vector< std::unique_ptr< Block > > m_Blocks;
+
+      CounterRegistry() = default;
+    };
+
+    inline void count(TreeCounter counter, uint64_t amount) noexcept
+    {
+      thread_local CounterRegistry::Block* block = CounterRegistry::instance().attach();
+      std::atomic< uint64_t >& value = block->m_Values[static_cast< size_t >(counter)];
+      value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // Log-linear latency histogram in the manner of HdrHistogram: every power of two is split into 16 buckets, so
+    // a reported value is within 6.25% of the recorded one across the whole range of uint64_t nanoseconds.
+    class LatencyHistogram
+    {
+    public:
+      LatencyHistogram();
+
+      void record(uint64_t nanoseconds) noexcept;
+      uint64_t count() const noexcept;
+      uint64_t mean() const noexcept;
+      uint64_t maximum() const noexcept;
+      uint64_t percentile(double fraction) const noexcept;
+
+    private:
+      static constexpr size_t SUB_BUCKET_BITS = 4;
+      static constexpr size_t SUB_BUCKET_COUNT = size_t(1) << SUB_BUCKET_BITS;
+      static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+
+      std::atomic< uint64_t > m_Counts[BUCKET_COUNT];
+      std::atomic< uint64_t > m_Total;
+      std::atomic< uint64_t > m_Sum;
+      std::atomic< uint64_t > m_Maximum;
+
+      static size_t bucketOf(uint64_t value) noexcept;
+      static uint64_t highestValueIn(size_t bucket) noexcept;
+    };
+
+    // Records the lifetime of the scope into a histogram, including scopes left by an exception.
+    class ScopedLatency
+    {
+    public:
+      explicit ScopedLatency(LatencyHistogram& histogram);
+      ScopedLatency(const ScopedLatency&) = delete;
+      ScopedLatency& operator=(const ScopedLatency&) = delete;
+      ~ScopedLatency();
+
+    private:
+      LatencyHistogram& m_Histogram;
+      std::chrono::steady_clock::time_point m_Start;
+    };
+
+    inline CounterRegistry& CounterRegistry::instance()
+    {
+      static CounterRegistry* registry = new CounterRegistry();
+      return *registry;
+    }
+
+    inline CounterRegistry::Totals CounterRegistry::totals() const
+    {
+      std::lock_guard< std::mutex > lock(m_Mutex);
+
+      Totals result(COUNTER_COUNT, 0);
+      for (const std::unique_ptr< Block >& block : m_Blocks)
+      {
+        for (size_t i = 0; i < COUNTER_COUNT; i++)
+        {
+          result[i] += block->m_Values[i].load(std::memory_order_relaxed);
+        }
+      }
+
+      return result;
+    }
+
+    // Blocks outlive their threads: pool workers come and go, and their counts must stay in the totals.
+    inline CounterRegistry::Block* CounterRegistry::attach()
+    {
+      std::unique_ptr< Block > created(new Block());
+      for (std::atomic< uint64_t >& value : created->m_Values)
+      {
+        value.store(0, std::memory_order_relaxed);
+      }
+
+      std::lock_guard< std::mutex > lock(m_Mutex);
+      m_Blocks.push_back(std::move(created));
+
+      return m_Blocks.back().get();
+    }
+
+    inline LatencyHistogram::LatencyHistogram(): m_Total(0), m_Sum(0), m_Maximum(0)
+    {
+      for (std::atomic< uint64_t >& bucket : m_Counts)
+      {
+        bucket.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    inline void LatencyHistogram::record(uint64_t nanoseconds) noexcept
+    {
+      m_Counts[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+      m_Total.fetch_add(1, std::memory_order_relaxed);
+      m_Sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+      uint64_t maximum = m_Maximum.load(std::memory_order_relaxed);
+      while (nanoseconds > maximum && !m_Maximum.compare_exchange_weak(maximum, nanoseconds, std::memory_order_relaxed))
+      {
+      }
+    }
+
+    inline uint64_t LatencyHistogram::count() const noexcept
+    {
+      return m_Total.load(std::memory_order_relaxed);
+    }
+
+    inline uint64_t LatencyHistogram::mean() const noexcept
+    {
+      uint64_t total = count();
+      return total == 0 ? 0 : m_Sum.load(std::memory_order_relaxed) / total;
+    }
+
+    inline uint64_t LatencyHistogram::maximum() const noexcept
+    {
+      return m_Maximum.load(std::memory_order_relaxed);
+    }
+
+    inline uint64_t LatencyHistogram::percentile(double fraction) const noexcept
+    {
+      uint64_t total = count();
+      if (total == 0)
+      {
+        return 0;
+      }
+
+      // Nearest rank: the smallest sample with at least that fraction of all samples at or below it, so the 99th
+      // and 100th percentiles of a few samples are the largest one.
+      uint64_t rank =
+        std::max< uint64_t >(1, static_cast< uint64_t >(std::ceil(fraction * static_cast< double >(total))));
+      uint64_t seen = 0;
+      for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++)
+      {
+        seen += m_Counts[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank)
+        {
+          return std::min(highestValueIn(bucket), maximum());
+        }
+      }
+
+      return maximum();
+    }
+
+    // Values below 2 * SUB_BUCKET_COUNT get a bucket each; above that, the bucket is the value's top five bits
+    // offset by how far they had to be shifted down.
+    inline size_t LatencyHistogram::bucketOf(uint64_t value) noexcept
+    {
+      if (value < 2 * SUB_BUCKET_COUNT)
+      {
+        return static_cast< size_t >(value);
+      }
+
+#ifdef _MSC_VER
+      unsigned long highest = 0;
+      _BitScanReverse64(&highest, value);
+#else
+      size_t highest = 63 - static_cast< size_t >(__builtin_clzll(value));
+#endif
+      size_t shift = static_cast< size_t >(highest) - SUB_BUCKET_BITS;
+      return shift * SUB_BUCKET_COUNT + static_cast< size_t >(value >> shift);
+    }
+
+    inline uint64_t LatencyHistogram::highestValueIn(size_t bucket) noexcept
+    {
+      if (bucket < 2 * SUB_BUCKET_COUNT)
+      {
+        return bucket;
+      }
+
+      size_t shift = bucket / SUB_BUCKET_COUNT - 1;
+      uint64_t top = bucket - shift * SUB_BUCKET_COUNT;
+      return ((top + 1) << shift) - 1;
+    }
+
+    inline ScopedLatency::ScopedLatency(LatencyHistogram& histogram):
+      m_Histogram(histogram),
+      m_Start(std::chrono::steady_clock::now())
+    {
+    }
+
+    inline ScopedLatency::~ScopedLatency()
+    {
+      m_Histogram.record(static_cast< uint64_t >(
+        std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now() - m_Start).count()));
+    }
+  }
+}
+#endif
@@ -0,0 +1,589 @@
+#include "KeyBitmap.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace bavykin
+{
+  namespace
+  {
+    size_t popcount(uint64_t word) noexcept
+    {
+#ifdef _MSC_VER
+      return static_cast< size_t >(__popcnt64(word));
+#else
+      return static_cast< size_t >(__builtin_popcountll(word));
+#endif
+    }
+
+    size_t lowestBit(uint64_t word) noexcept
+    {
+#ifdef _MSC_VER
+      unsigned long index = 0;
+      _BitScanForward64(&index, word);
+      return index;
+#else
+      return static_cast< size_t >(__builtin_ctzll(word));
+#endif
+    }
+
+    size_t highestBit(uint64_t word) noexcept
+    {
+#ifdef _MSC_VER
+      unsigned long index = 0;
+      _BitScanReverse64(&index, word);
+      return index;
+#else
+      return 63 - static_cast< size_t >(__builtin_clzll(word));
+#endif
+    }
+  }
+
+  KeyBitmap::const_iterator::const_iterator():
+    m_Containers(nullptr),
+    m_Container(0),
+    m_Position(0),
+    m_Bits(0),
+    m_Value(0)
+  {
+  }
+
+  KeyBitmap::const_iterator::const_iterator(const std::vector< Container >* containers, size_t container):
+    m_Containers(containers),
+    m_Container(container),
+    m_Position(0),
+    m_Bits(0),
+    m_Value(0)
+  {
+    enterContainer();
+    settle();
+  }
+
+  int KeyBitmap::const_iterator::operator*() const
+  {
+    return decode(m_Value);
+  }
+
+  KeyBitmap::const_iterator& KeyBitmap::const_iterator::operator++()
+  {
+    if ((*m_Containers)[m_Container].isBitmap())
+    {
+      m_Bits &= m_Bits - 1;
+    }
+    else
+    {
+      m_Position++;
+    }
+    settle();
+
+    return *this;
+  }
+
+  bool KeyBitmap::const_iterator::operator==(const const_iterator& right) const
+  {
+    return m_Container == right.m_Container && m_Position == right.m_Position && m_Bits == right.m_Bits;
+  }
+
+  bool KeyBitmap::const_iterator::operator!=(const const_iterator& right) const
+  {
+    return !(*this == right);
+  }
+
+  void KeyBitmap::const_iterator::enterContainer()
+  {
+    m_Position = 0;
+    m_Bits = 0;
+    if (m_Container < m_Containers->size() && (*m_Containers)[m_Container].isBitmap())
+    {
+      m_Bits = (*m_Containers)[m_Container].m_Words[0];
+    }
+  }
+
+  void KeyBitmap::const_iterator::settle()
+  {
+    while (m_Container < m_Containers->size())
+    {
+      const Container& current = (*m_Containers)[m_Container];
+      uint32_t high = static_cast< uint32_t >(current.m_High) << 16;
+
+      if (!current.isBitmap())
+      {
+        if (m_Position < current.m_Array.size())
+        {
+          m_Value = high | current.m_Array[m_Position];
+          return;
+        }
+      }
+      else
+      {
+        while (m_Bits == 0 && m_Position + 1 < WORD_COUNT)
+        {
+          m_Bits = current.m_Words[++m_Position];
+        }
+        if (m_Bits != 0)
+        {
+          m_Value = high | static_cast< uint32_t >(m_Position * 64 + lowestBit(m_Bits));
+          return;
+        }
+      }
+
+      m_Container++;
+      enterContainer();
+    }
+  }
+
+  KeyBitmap::KeyBitmap(): m_Size(0)
+  {
+  }
+
+  KeyBitmap KeyBitmap::unite(const KeyBitmap& left, const KeyBitmap& right)
+  {
+    return apply(left, right, Operation::Unite);
+  }
+
+  KeyBitmap KeyBitmap::intersect(const KeyBitmap& left, const KeyBitmap& right)
+  {
+    return apply(left, right, Operation::Intersect);
+  }
+
+  KeyBitmap KeyBitmap::subtract(const KeyBitmap& left, const KeyBitmap& right)
+  {
+    return apply(left, right, Operation::Subtract);
+  }
+
+  size_t KeyBitmap::size() const noexcept
+  {
+    return m_Size;
+  }
+
+  bool KeyBitmap::empty() const noexcept
+  {
+    return m_Size == 0;
+  }
+
+  bool KeyBitmap::contains(int key) const
+  {
+    uint32_t value = encode(key);
+    uint16_t high = static_cast< uint16_t >(value >> 16);
+    uint16_t low = static_cast< uint16_t >(value);
+    size_t index = findContainer(high);
+    if (index == m_Containers.size() || m_Containers[index].m_High != high)
+    {
+      return false;
+    }
+
+    const Container& container = m_Containers[index];
+    if (container.isBitmap())
+    {
+      return (container.m_Words[low >> 6] >> (low & 63)) & 1;
+    }
+
+    return std::binary_search(container.m_Array.begin(), container.m_Array.end(), low);
+  }
+
+  size_t KeyBitmap::rank(int key) const
+  {
+    uint32_t value = encode(key);
+    uint16_t high = static_cast< uint16_t >(value >> 16);
+    uint16_t low = static_cast< uint16_t >(value);
+    size_t index = findContainer(high);
+    if (index == m_Containers.size())
+    {
+      return m_Size;
+    }
+
+    const Container& container = m_Containers[index];
+    if (container.m_High != high)
+    {
+      return container.m_Rank;
+    }
+    if (container.isBitmap())
+    {
+      uint64_t below = (uint64_t(1) << (low & 63)) - 1;
+      return container.m_Rank + container.m_WordRanks[low >> 6] + popcount(container.m_Words[low >> 6] & below);
+    }
+
+    auto position = std::lower_bound(container.m_Array.begin(), container.m_Array.end(), low);
+    return container.m_Rank + static_cast< size_t >(position - container.m_Array.begin());
+  }
+
+  int KeyBitmap::minimum() const
+  {
+    if (empty())
+    {
+      throw std::out_of_range("The key set is empty.");
+    }
+
+    return *cbegin();
+  }
+
+  int KeyBitmap::maximum() const
+  {
+    if (empty())
+    {
+      throw std::out_of_range("The key set is empty.");
+    }
+
+    const Container& last = m_Containers.back();
+    uint32_t high = static_cast< uint32_t >(last.m_High) << 16;
+    if (!last.isBitmap())
+    {
+      return decode(high | last.m_Array.back());
+    }
+
+    size_t word = WORD_COUNT - 1;
+    while (last.m_Words[word] == 0)
+    {
+      word--;
+    }
+
+    return decode(high | static_cast< uint32_t >(word * 64 + highestBit(last.m_Words[word])));
+  }
+
+  size_t KeyBitmap::memoryUsage() const
+  {
+    size_t result = m_Containers.capacity() * sizeof(Container);
+
+    for (const Container& container : m_Containers)
+    {
+      result += container.m_Array.capacity() * sizeof(uint16_t) + container.m_Words.capacity() * sizeof(uint64_t) +
+        container.m_WordRanks.capacity() * sizeof(uint16_t);
+    }
+
+    return result;
+  }
+
+  KeyBitmap::ShapeStatistics KeyBitmap::shapeStats() const
+  {
+    ShapeStatistics statistics = { m_Size, 0, m_Containers.size(), 0, 0, 0 };
+
+    for (size_t i = 0; i < m_Containers.size(); i++)
+    {
+      const Container& container = m_Containers[i];
+      if (i != 0 && m_Containers[i - 1].m_High >= container.m_High)
+      {
+        statistics.m_OrderViolations++;
+      }
+
+      size_t count = 0;
+      bool ranksMatch = true;
+      if (container.isBitmap())
+      {
+        statistics.m_BitmapContainers++;
+        for (size_t word = 0; word < container.m_Words.size(); word++)
+        {
+          ranksMatch = ranksMatch && word < container.m_WordRanks.size() && container.m_WordRanks[word] == count;
+          count += popcount(container.m_Words[word]);
+        }
+      }
+      else
+      {
+        count = container.m_Array.size();
+        for (size_t j = 1; j < container.m_Array.size(); j++)
+        {
+          if (container.m_Array[j - 1] >= container.m_Array[j])
+          {
+            statistics.m_OrderViolations++;
+          }
+        }
+      }
+
+      if (!ranksMatch || count != container.m_Count || container.m_Rank != statistics.m_Keys)
+      {
+        statistics.m_CountMismatches++;
+      }
+      statistics.m_Keys += count;
+    }
+
+    return statistics;
+  }
+
+  bool KeyBitmap::validate() const
+  {
+    return shapeStats().isValid();
+  }
+
+  bool KeyBitmap::ShapeStatistics::isValid() const noexcept
+  {
+    return m_Keys == m_Size && m_CountMismatches == 0 && m_OrderViolations == 0;
+  }
+
+  KeyBitmap::const_iterator KeyBitmap::cbegin() const
+  {
+    return const_iterator(&m_Containers, 0);
+  }
+
+  KeyBitmap::const_iterator KeyBitmap::cend() const
+  {
+    return const_iterator(&m_Containers, m_Containers.size());
+  }
+
+  bool KeyBitmap::Container::isBitmap() const noexcept
+  {
+    return !m_Words.empty();
+  }
+
+  void KeyBitmap::append(uint32_t value)
+  {
+    uint16_t high = static_cast< uint16_t >(value >> 16);
+    uint16_t low = static_cast< uint16_t >(value);
+
+    if (m_Containers.empty() || m_Containers.back().m_High != high)
+    {
+      if (!m_Containers.empty())
+      {
+        seal(m_Containers.back());
+      }
+      m_Containers.push_back(Container{ high, m_Size, 0, {}, {}, {} });
+    }
+
+    Container& container = m_Containers.back();
+    if (container.isBitmap())
+    {
+      container.m_Words[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+    else
+    {
+      container.m_Array.push_back(low);
+      if (container.m_Array.size() > ARRAY_LIMIT)
+      {
+        toBitmap(container);
+      }
+    }
+    container.m_Count++;
+    m_Size++;
+  }
+
+  void KeyBitmap::appendContainer(Container&& container)
+  {
+    if (container.m_Count == 0)
+    {
+      return;
+    }
+
+    if (container.isBitmap() && container.m_Count <= ARRAY_LIMIT)
+    {
+      std::vector< uint16_t > values;
+      values.reserve(container.m_Count);
+      for (size_t word = 0; word < WORD_COUNT; word++)
+      {
+        for (uint64_t bits = container.m_Words[word]; bits != 0; bits &= bits - 1)
+        {
+          values.push_back(static_cast< uint16_t >(word * 64 + lowestBit(bits)));
+        }
+      }
+      container.m_Array.swap(values);
+      container.m_Words = std::vector< uint64_t >();
+      container.m_WordRanks = std::vector< uint16_t >();
+    }
+    else if (!container.isBitmap() && container.m_Count > ARRAY_LIMIT)
+    {
+      toBitmap(container);
+    }
+
+    container.m_Rank = m_Size;
+    seal(container);
+    m_Size += container.m_Count;
+    m_Containers.push_back(std::move(container));
+  }
+
+  void KeyBitmap::finish()
+  {
+    if (!m_Containers.empty())
+    {
+      seal(m_Containers.back());
+    }
+    m_Containers.shrink_to_fit();
+  }
+
+  size_t KeyBitmap::findContainer(uint16_t high) const
+  {
+    auto position = std::lower_bound(m_Containers.begin(), m_Containers.end(), high,
+      [](const Container& container, uint16_t value) {
+        return container.m_High < value;
+      });
+
+    return static_cast< size_t >(position - m_Containers.begin());
+  }
+
+  void KeyBitmap::seal(Container& container)
+  {
+    if (!container.isBitmap())
+    {
+      container.m_Array.shrink_to_fit();
+      return;
+    }
+
+    container.m_WordRanks.resize(WORD_COUNT);
+    size_t rank = 0;
+    for (size_t word = 0; word < WORD_COUNT; word++)
+    {
+      container.m_WordRanks[word] = static_cast< uint16_t >(rank);
+      rank += popcount(container.m_Words[word]);
+    }
+  }
+
+  void KeyBitmap::toBitmap(Container& container)
+  {
+    container.m_Words = wordsOf(container);
+    container.m_Array = std::vector< uint16_t >();
+  }
+
+  std::vector< uint64_t > KeyBitmap::wordsOf(const Container& container)
+  {
+    if (container.isBitmap())
+    {
+      return container.m_Words;
+    }
+
+    std::vector< uint64_t > words(WORD_COUNT, 0);
+    for (uint16_t low : container.m_Array)
+    {
+      words[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+
+    return words;
+  }
+
+  KeyBitmap::Container KeyBitmap::combine(const Container& left, const Container& right, Operation operation)
+  {
+    Container result = { left.m_High, 0, 0, {}, {}, {} };
+
+    if (operation == Operation::Intersect && left.isBitmap() && !right.isBitmap())
+    {
+      for (uint16_t low : right.m_Array)
+      {
+        if ((left.m_Words[low >> 6] >> (low & 63)) & 1)
+        {
+          result.m_Array.push_back(low);
+        }
+      }
+      result.m_Count = result.m_Array.size();
+
+      return result;
+    }
+
+    if (!left.isBitmap() && (!right.isBitmap() || operation != Operation::Unite))
+    {
+      // A sorted-array left side bounds intersections and differences, so they stay array-sized.
+      auto output = std::back_inserter(result.m_Array);
+      if (right.isBitmap())
+      {
+        bool keepPresent = operation == Operation::Intersect;
+        for (uint16_t low : left.m_Array)
+        {
+          if ((((right.m_Words[low >> 6] >> (low & 63)) & 1) != 0) == keepPresent)
+          {
+            result.m_Array.push_back(low);
+          }
+        }
+      }
+      else if (operation == Operation::Unite)
+      {
+        std::set_union(left.m_Array.begin(), left.m_Array.end(), right.m_Array.begin(), right.m_Array.end(), output);
+      }
+      else if (operation == Operation::Intersect)
+      {
+        std::set_intersection(left.m_Array.begin(), left.m_Array.end(), right.m_Array.begin(), right.m_Array.end(),
+          output);
+      }
+      else
+      {
+        std::set_difference(left.m_Array.begin(), left.m_Array.end(), right.m_Array.begin(), right.m_Array.end(),
+          output);
+      }
+      result.m_Count = result.m_Array.size();
+
+      return result;
+    }
+
+    std::vector< uint64_t > leftStorage;
+    std::vector< uint64_t > rightStorage;
+    const uint64_t* leftWords = left.isBitmap() ? left.m_Words.data() : (leftStorage = wordsOf(left)).data();
+    const uint64_t* rightWords = right.isBitmap() ? right.m_Words.data() : (rightStorage = wordsOf(right)).data();
+    result.m_Words.resize(WORD_COUNT);
+    uint64_t* words = result.m_Words.data();
+
+    // Separate loops per operation keep each one a plain word-wise loop the compiler can vectorize.
+    switch (operation)
+    {
+    case Operation::Unite:
+      for (size_t i = 0; i < WORD_COUNT; i++)
+      {
+        words[i] = leftWords[i] | rightWords[i];
+      }
+      break;
+    case Operation::Intersect:
+      for (size_t i = 0; i < WORD_COUNT; i++)
+      {
+        words[i] = leftWords[i] & rightWords[i];
+      }
+      break;
+    case Operation::Subtract:
+      for (size_t i = 0; i < WORD_COUNT; i++)
+      {
+        words[i] = leftWords[i] & ~rightWords[i];
+      }
+      break;
+    }
+
+    for (size_t i = 0; i < WORD_COUNT; i++)
+    {
+      result.m_Count += popcount(words[i]);
+    }
+
+    return result;
+  }
+
+  KeyBitmap KeyBitmap::apply(const KeyBitmap& left, const KeyBitmap& right, Operation operation)
+  {
+    KeyBitmap result;
+    size_t i = 0;
+    size_t j = 0;
+
+    while (i < left.m_Containers.size() || j < right.m_Containers.size())
+    {
+      if (j == right.m_Containers.size() ||
+        (i < left.m_Containers.size() && left.m_Containers[i].m_High < right.m_Containers[j].m_High))
+      {
+        if (operation != Operation::Intersect)
+        {
+          result.appendContainer(Container(left.m_Containers[i]));
+        }
+        i++;
+      }
+      else if (i == left.m_Containers.size() || right.m_Containers[j].m_High < left.m_Containers[i].m_High)
+      {
+        if (operation == Operation::Unite)
+        {
+          result.appendContainer(Container(right.m_Containers[j]));
+        }
+        j++;
+      }
+      else
+      {
+        result.appendContainer(combine(left.m_Containers[i], right.m_Containers[j], operation));
+        i++;
+        j++;
+      }
+    }
+    result.m_Containers.shrink_to_fit();
+
+    return result;
+  }
+
+  uint32_t KeyBitmap::encode(int key) noexcept
+  {
+    return static_cast< uint32_t >(key) ^ 0x80000000u;
+  }
+
+  int KeyBitmap::decode(uint32_t value) noexcept
+  {
+    return static_cast< int >(value ^ 0x80000000u);
+  }
+}
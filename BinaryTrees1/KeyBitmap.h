@@ -0,0 +1,131 @@
+#ifndef KEY_BITMAP_H
+#define KEY_BITMAP_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bavykin
+{
+  // Roaring-style set of int keys. Keys are split by their upper 16 bits into containers; a container holds its
+  // lower halves as a sorted array while it has at most 4096 of them and as a 65536-bit bitmap beyond that, so both
+  // sparse and dense stretches cost at most two bytes per key. Set operations work container by container, using
+  // word-level AND/OR/ANDNOT with popcount where either side is a bitmap.
+  class KeyBitmap
+  {
+  private:
+    struct Container;
+
+  public:
+    // Layout of the set as measured by one pass over every container. A count mismatch is a container whose
+    // recorded count, rank or per-word ranks disagree with the keys it actually holds.
+    struct ShapeStatistics
+    {
+      size_t m_Size;
+      size_t m_Keys;
+      size_t m_Containers;
+      size_t m_BitmapContainers;
+      size_t m_CountMismatches;
+      size_t m_OrderViolations;
+
+      bool isValid() const noexcept;
+    };
+
+    class const_iterator
+    {
+    public:
+      const_iterator();
+
+      int operator*() const;
+      const_iterator& operator++();
+      bool operator==(const const_iterator& right) const;
+      bool operator!=(const const_iterator& right) const;
+
+    private:
+      friend class KeyBitmap;
+
+      const std::vector< Container >* m_Containers;
+      size_t m_Container;
+      size_t m_Position;
+      uint64_t m_Bits;
+      uint32_t m_Value;
+
+      const_iterator(const std::vector< Container >* containers, size_t container);
+      void enterContainer();
+      void settle();
+    };
+
+    KeyBitmap();
+
+    template < typename InputIt >
+    static KeyBitmap fromSorted(InputIt first, InputIt last);
+    static KeyBitmap unite(const KeyBitmap& left, const KeyBitmap& right);
+    static KeyBitmap intersect(const KeyBitmap& left, const KeyBitmap& right);
+    static KeyBitmap subtract(const KeyBitmap& left, const KeyBitmap& right);
+
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+    bool contains(int key) const;
+    size_t rank(int key) const;
+    int minimum() const;
+    int maximum() const;
+    size_t memoryUsage() const;
+    ShapeStatistics shapeStats() const;
+    bool validate() const;
+
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+
+  private:
+    static constexpr size_t WORD_COUNT = 1024;
+    static constexpr size_t ARRAY_LIMIT = 4096;
+
+    struct Container
+    {
+      uint16_t m_High;
+      size_t m_Rank;
+      size_t m_Count;
+      std::vector< uint16_t > m_Array;
+      std::vector< uint64_t > m_Words;
+      std::vector< uint16_t > m_WordRanks;
+
+      bool isBitmap() const noexcept;
+    };
+
+    enum class Operation
+    {
+      Unite,
+      Intersect,
+      Subtract
+    };
+
+    std::vector< Container > m_Containers;
+    size_t m_Size;
+
+    void append(uint32_t value);
+    void appendContainer(Container&& container);
+    void finish();
+    size_t findContainer(uint16_t high) const;
+    static void seal(Container& container);
+    static void toBitmap(Container& container);
+    static std::vector< uint64_t > wordsOf(const Container& container);
+    static Container combine(const Container& left, const Container& right, Operation operation);
+    static KeyBitmap apply(const KeyBitmap& left, const KeyBitmap& right, Operation operation);
+    static uint32_t encode(int key) noexcept;
+    static int decode(uint32_t value) noexcept;
+  };
+
+  template < typename InputIt >
+  KeyBitmap KeyBitmap::fromSorted(InputIt first, InputIt last)
+  {
+    KeyBitmap result;
+
+    for (; first != last; ++first)
+    {
+      result.append(encode(*first));
+    }
+    result.finish();
+
+    return result;
+  }
+}
+#endif
@@ -0,0 +1,218 @@
+#ifndef LOOKUP_CACHE_H
+#define LOOKUP_CACHE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+namespace bavykin
+{
+  // Direct-mapped cache of tree nodes in front of a search, for skewed lookups: a hit costs one hash and one
+  // comparison instead of a descent that misses the processor cache at every level. Each key maps to one slot and a
+  // later key mapping there replaces it, so keys looked up often keep their slots while rare ones pass through.
+  // A slot only ever holds the node of a key that maps to it, so an erased node is forgotten by clearing one slot.
+  // Slots and counters are relaxed atomics: concurrent const lookups may fill slots, though the counters may then
+  // lose a few updates. Disabled, with no slots, until resized.
+  template < class Key, class Node >
+  class LookupCache
+  {
+  public:
+    struct Statistics
+    {
+      size_t m_Slots;
+      uint64_t m_Hits;
+      uint64_t m_Misses;
+    };
+
+    // Keys without a std::hash specialization cannot be cached; resizing such a cache to any slots throws.
+    static constexpr bool IS_AVAILABLE = std::is_default_constructible< std::hash< Key > >::value;
+
+    LookupCache();
+    LookupCache(const LookupCache& right);
+    LookupCache(LookupCache&& right) noexcept;
+
+    LookupCache& operator=(const LookupCache& right);
+    LookupCache& operator=(LookupCache&& right) noexcept;
+
+    void resize(size_t slots);
+    template < class Equal >
+    Node* find(const Key& key, size_t& slot, Equal equal) const;
+    void remember(size_t slot, Node* value) const noexcept;
+    void forget(const Key& key, const Node* value) noexcept;
+    void reset() noexcept;
+    Statistics statistics() const noexcept;
+
+  private:
+    std::unique_ptr< std::atomic< Node* >[] > m_Slots;
+    size_t m_SlotCount;
+    unsigned m_Shift;
+    mutable std::atomic< uint64_t > m_Hits;
+    mutable std::atomic< uint64_t > m_Misses;
+
+    size_t slotOf(const Key& key) const;
+    static void bump(std::atomic< uint64_t >& counter) noexcept;
+  };
+
+  template < class Key, class Node >
+  LookupCache< Key, Node >::LookupCache(): m_Slots(nullptr), m_SlotCount(0), m_Shift(64), m_Hits(0), m_Misses(0)
+  {
+  }
+
+  // A copy has as many slots, all empty: the nodes it would point to belong to the original.
+  template < class Key, class Node >
+  LookupCache< Key, Node >::LookupCache(const LookupCache& right): LookupCache()
+  {
+    resize(right.m_SlotCount);
+  }
+
+  template < class Key, class Node >
+  LookupCache< Key, Node >::LookupCache(LookupCache&& right) noexcept:
+    m_Slots(std::move(right.m_Slots)),
+    m_SlotCount(right.m_SlotCount),
+    m_Shift(right.m_Shift),
+    m_Hits(right.m_Hits.load(std::memory_order_relaxed)),
+    m_Misses(right.m_Misses.load(std::memory_order_relaxed))
+  {
+    right.m_SlotCount = 0;
+    right.m_Shift = 64;
+  }
+
+  template < class Key, class Node >
+  LookupCache< Key, Node >& LookupCache< Key, Node >::operator=(const LookupCache& right)
+  {
+    if (this != &right)
+    {
+      resize(right.m_SlotCount);
+    }
+
+    return *this;
+  }
+
+  template < class Key, class Node >
+  LookupCache< Key, Node >& LookupCache< Key, Node >::operator=(LookupCache&& right) noexcept
+  {
+    if (this != &right)
+    {
+      m_Slots = std::move(right.m_Slots);
+      m_SlotCount = right.m_SlotCount;
+      m_Shift = right.m_Shift;
+      m_Hits.store(right.m_Hits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      m_Misses.store(right.m_Misses.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      right.m_SlotCount = 0;
+      right.m_Shift = 64;
+    }
+
+    return *this;
+  }
+
+  // Rounds slots up to a power of two, at least two; zero disables the cache. Either way every slot starts empty
+  // and the counters restart.
+  template < class Key, class Node >
+  void LookupCache< Key, Node >::resize(size_t slots)
+  {
+    if (slots != 0 && !IS_AVAILABLE)
+    {
+      throw std::logic_error("Lookup cache needs a std::hash specialization for the key type.");
+    }
+
+    size_t wanted = slots < 2 ? 2 : slots;
+    unsigned bits = 0;
+    while (slots != 0 && bits < 32 && (size_t(1) << bits) < wanted)
+    {
+      bits++;
+    }
+
+    m_SlotCount = slots != 0 ? size_t(1) << bits : 0;
+    m_Shift = 64 - bits;
+    m_Slots.reset(m_SlotCount != 0 ? new std::atomic< Node* >[m_SlotCount] : nullptr);
+    m_Hits.store(0, std::memory_order_relaxed);
+    m_Misses.store(0, std::memory_order_relaxed);
+    reset();
+  }
+
+  // Returns the cached node when equal accepts it for the key, otherwise nullptr and the slot to remember the node
+  // the search then finds.
+  template < class Key, class Node >
+  template < class Equal >
+  Node* LookupCache< Key, Node >::find(const Key& key, size_t& slot, Equal equal) const
+  {
+    if (m_SlotCount == 0)
+    {
+      return nullptr;
+    }
+
+    slot = slotOf(key);
+    Node* cached = m_Slots[slot].load(std::memory_order_relaxed);
+    if (cached != nullptr && equal(cached))
+    {
+      bump(m_Hits);
+      return cached;
+    }
+
+    bump(m_Misses);
+    return nullptr;
+  }
+
+  template < class Key, class Node >
+  void LookupCache< Key, Node >::remember(size_t slot, Node* value) const noexcept
+  {
+    if (m_SlotCount != 0 && value != nullptr)
+    {
+      m_Slots[slot].store(value, std::memory_order_relaxed);
+    }
+  }
+
+  template < class Key, class Node >
+  void LookupCache< Key, Node >::forget(const Key& key, const Node* value) noexcept
+  {
+    if (m_SlotCount != 0)
+    {
+      std::atomic< Node* >& cached = m_Slots[slotOf(key)];
+      if (cached.load(std::memory_order_relaxed) == value)
+      {
+        cached.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  template < class Key, class Node >
+  void LookupCache< Key, Node >::reset() noexcept
+  {
+    for (size_t i = 0; i < m_SlotCount; i++)
+    {
+      m_Slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  template < class Key, class Node >
+  typename LookupCache< Key, Node >::Statistics LookupCache< Key, Node >::statistics() const noexcept
+  {
+    return Statistics{ m_SlotCount, m_Hits.load(std::memory_order_relaxed), m_Misses.load(std::memory_order_relaxed) };
+  }
+
+  // Fibonacci hashing: the top bits of the hash times 2^64 over the golden ratio, so that hashes which differ only in
+  // their high bits, or identity hashes of keys with a common stride, still spread over every slot.
+  template < class Key, class Node >
+  size_t LookupCache< Key, Node >::slotOf(const Key& key) const
+  {
+    if constexpr (IS_AVAILABLE)
+    {
+      uint64_t hash = static_cast< uint64_t >(std::hash< Key >()(key));
+      return static_cast< size_t >((hash * 0x9E3779B97F4A7C15ull) >> m_Shift);
+    }
+    else
+    {
+      return 0;
+    }
+  }
+
+  template < class Key, class Node >
+  void LookupCache< Key, Node >::bump(std::atomic< uint64_t >& counter) noexcept
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+}
+#endif
@@ -0,0 +1,21 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
+
+namespace bavykin
+{
+  // Asks for the cache line at the address to be brought into every cache level. It is only a hint: a bad address
+  // does not fault, and the call may be dropped entirely.
+  inline void prefetch(const void* address) noexcept
+  {
+#ifdef _MSC_VER
+    _mm_prefetch(static_cast< const char* >(address), _MM_HINT_T0);
+#else
+    __builtin_prefetch(address);
+#endif
+  }
+}
+#endif
@@ -0,0 +1,91 @@
+#include "ResultCache.h"
+
+namespace bavykin
+{
+  ResultCache::ResultCache(size_t capacity): m_Capacity(capacity), m_Statistics{ 0, 0, 0, 0 }
+  {
+  }
+
+  bool ResultCache::find(SetExpression::Operation operation, const std::vector< uint64_t >& inputs, Result& result)
+  {
+    std::lock_guard< std::mutex > lock(m_Mutex);
+
+    auto found = m_Index.find(Key{ operation, inputs });
+    if (found == m_Index.end())
+    {
+      m_Statistics.m_Misses++;
+      return false;
+    }
+
+    m_Recent.splice(m_Recent.begin(), m_Recent, found->second);
+    result = found->second->m_Result;
+    m_Statistics.m_Hits++;
+
+    return true;
+  }
+
+  void ResultCache::insert(SetExpression::Operation operation, const std::vector< uint64_t >& inputs,
+    const Result& result)
+  {
+    std::lock_guard< std::mutex > lock(m_Mutex);
+
+    if (m_Capacity == 0)
+    {
+      return;
+    }
+
+    Key key = { operation, inputs };
+    auto found = m_Index.find(key);
+    if (found != m_Index.end())
+    {
+      found->second->m_Result = result;
+      m_Recent.splice(m_Recent.begin(), m_Recent, found->second);
+      return;
+    }
+
+    if (m_Recent.size() == m_Capacity)
+    {
+      m_Index.erase(m_Recent.back().m_Key);
+      m_Recent.pop_back();
+      m_Statistics.m_Evictions++;
+    }
+
+    m_Recent.push_front(Entry{ key, result });
+    m_Index.emplace(std::move(key), m_Recent.begin());
+  }
+
+  void ResultCache::clear()
+  {
+    std::lock_guard< std::mutex > lock(m_Mutex);
+
+    m_Index.clear();
+    m_Recent.clear();
+  }
+
+  ResultCache::Statistics ResultCache::statistics() const
+  {
+    std::lock_guard< std::mutex > lock(m_Mutex);
+
+    Statistics current = m_Statistics;
+    current.m_Entries = m_Recent.size();
+
+    return current;
+  }
+
+  bool ResultCache::Key::operator==(const Key& right) const
+  {
+    return m_Operation == right.m_Operation && m_Inputs == right.m_Inputs;
+  }
+
+  size_t ResultCache::KeyHash::operator()(const Key& key) const
+  {
+    uint64_t result = static_cast< uint64_t >(key.m_Operation);
+
+    for (uint64_t input : key.m_Inputs)
+    {
+      result ^= input + 0x9e3779b97f4a7c15ull + (result << 6) + (result >> 2);
+    }
+
+    return static_cast< size_t >(result);
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "SetExpression.h"
+
+namespace bavykin
+{
+  // Memoizes derived datasets by operation and input versions. A version is handed out whenever a name is bound to
+  // a new value and is never reused, so an entry whose inputs were redefined simply stops matching and ages out of
+  // the least-recently-used list. Safe to share between the parallel scheduler's workers.
+  class ResultCache
+  {
+  public:
+    struct Result
+    {
+      ExpressionHandle m_Value;
+      uint64_t m_Version;
+    };
+
+    struct Statistics
+    {
+      size_t m_Hits;
+      size_t m_Misses;
+      size_t m_Evictions;
+      size_t m_Entries;
+    };
+
+    ResultCache(size_t capacity);
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    bool find(SetExpression::Operation operation, const std::vector< uint64_t >& inputs, Result& result);
+    void insert(SetExpression::Operation operation, const std::vector< uint64_t >& inputs, const Result& result);
+    void clear();
+    Statistics statistics() const;
+
+  private:
+    struct Key
+    {
+      SetExpression::Operation m_Operation;
+      std::vector< uint64_t > m_Inputs;
+
+      bool operator==(const Key& right) const;
+    };
+
+    struct KeyHash
+    {
+      size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+      Key m_Key;
+      Result m_Result;
+    };
+
+    size_t m_Capacity;
+    mutable std::mutex m_Mutex;
+    std::list< Entry > m_Recent;
+    std::unordered_map< Key, std::list< Entry >::iterator, KeyHash > m_Index;
+    Statistics m_Statistics;
+  };
+}
+#endif
@@ -0,0 +1,604 @@
+#include "SetExpression.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace bavykin
+{
+  namespace
+  {
+    // Nested operands are inlined into the fused merge only up to this many inputs; wider expressions materialize
+    // an operand first so long command chains cannot build unbounded expression trees.
+    const size_t MAX_FUSED_INPUTS = 16;
+
+    // Walks one input in key order, whichever representation it is stored in. The dense one wins when both are
+    // given; with neither, the cursor is done from the start.
+    class Cursor
+    {
+    public:
+      Cursor(const DataSet* tree, const DenseDataSet* dense):
+        m_Dense(dense),
+        m_Index(0),
+        m_Key(),
+        m_KeyEnd(),
+        m_Tree(),
+        m_TreeEnd()
+      {
+        if (m_Dense != nullptr)
+        {
+          m_Key = m_Dense->keys().cbegin();
+          m_KeyEnd = m_Dense->keys().cend();
+        }
+        else if (tree != nullptr)
+        {
+          m_Tree = tree->cbegin();
+          m_TreeEnd = tree->cend();
+        }
+      }
+
+      bool done() const
+      {
+        return m_Dense != nullptr ? m_Key == m_KeyEnd : m_Tree == m_TreeEnd;
+      }
+
+      int key() const
+      {
+        return m_Dense != nullptr ? *m_Key : m_Tree.m_Current->m_Content.first;
+      }
+
+      const DataSetValue* value() const
+      {
+        return m_Dense != nullptr ? &m_Dense->values()[m_Index] : &m_Tree.m_Current->m_Content.second;
+      }
+
+      void next()
+      {
+        if (m_Dense != nullptr)
+        {
+          ++m_Key;
+          m_Index++;
+        }
+        else
+        {
+          ++m_Tree;
+        }
+      }
+
+    private:
+      const DenseDataSet* m_Dense;
+      size_t m_Index;
+      KeyBitmap::const_iterator m_Key;
+      KeyBitmap::const_iterator m_KeyEnd;
+      DataSet::const_iterator m_Tree;
+      DataSet::const_iterator m_TreeEnd;
+    };
+  }
+
+  SetExpression::SetExpression(DataSetHandle value):
+    m_Operation(Operation::Leaf),
+    m_Name(value->getName()),
+    m_InputCount(1),
+    m_Cache{ std::move(value), nullptr }
+  {
+  }
+
+  SetExpression::SetExpression(DenseHandle value, const std::string& name):
+    m_Operation(Operation::Leaf),
+    m_Name(name),
+    m_InputCount(1),
+    m_Cache{ nullptr, std::move(value) }
+  {
+  }
+
+  SetExpression::SetExpression(Operation operation, const std::string& name, std::vector< ExpressionHandle > operands):
+    m_Operation(operation),
+    m_Name(name),
+    m_InputCount(0),
+    m_Operands(std::move(operands))
+  {
+    for (const ExpressionHandle& operand : m_Operands)
+    {
+      m_InputCount += operand->inputCount();
+    }
+  }
+
+  ExpressionHandle SetExpression::fromDataSet(DataSetHandle value)
+  {
+    if (value->size() != 0)
+    {
+      int minimum = value->cbegin().m_Current->m_Content.first;
+      int maximum = minimum;
+      for (auto i = value->cbegin(); i != value->cend(); ++i)
+      {
+        maximum = i.m_Current->m_Content.first;
+      }
+
+      if (DenseDataSet::suits(value->size(), minimum, maximum))
+      {
+        return std::make_shared< const SetExpression >(DenseDataSet::fromDataSet(*value), value->getName());
+      }
+    }
+
+    return std::make_shared< const SetExpression >(std::move(value));
+  }
+
+  ExpressionHandle SetExpression::combine(Operation operation, const std::string& name,
+    std::vector< ExpressionHandle > operands)
+  {
+    size_t inputCount = 0;
+    for (const ExpressionHandle& operand : operands)
+    {
+      inputCount += operand->inputCount();
+    }
+
+    // Only nested expressions are evaluated here: a single command over many plain datasets is still one merge.
+    while (inputCount > MAX_FUSED_INPUTS)
+    {
+      const ExpressionHandle* widest = nullptr;
+      for (const ExpressionHandle& operand : operands)
+      {
+        if (operand->inputCount() > 1 && (widest == nullptr || operand->inputCount() > (*widest)->inputCount()))
+        {
+          widest = &operand;
+        }
+      }
+      if (widest == nullptr)
+      {
+        break;
+      }
+
+      inputCount -= (*widest)->inputCount() - 1;
+      (*widest)->evaluated();
+    }
+
+    return std::make_shared< const SetExpression >(operation, name, std::move(operands));
+  }
+
+  DataSetHandle SetExpression::materialize() const
+  {
+    Value value = evaluated();
+
+    return value.m_Tree != nullptr ? value.m_Tree : value.m_Dense->toDataSet(m_Name);
+  }
+
+  // The dense form of the dataset, or null while it is held as a tree.
+  DenseHandle SetExpression::dense() const
+  {
+    return evaluated().m_Dense;
+  }
+
+  size_t SetExpression::size() const
+  {
+    return evaluated().size();
+  }
+
+  bool SetExpression::isDense() const
+  {
+    return evaluated().m_Dense != nullptr;
+  }
+
+  bool SetExpression::isMaterialized() const
+  {
+    std::lock_guard< std::mutex > lock(m_Mutex);
+
+    return !m_Cache.empty();
+  }
+
+  size_t SetExpression::inputCount() const
+  {
+    return isMaterialized() ? 1 : m_InputCount;
+  }
+
+  size_t SetExpression::Value::size() const
+  {
+    return m_Dense != nullptr ? m_Dense->size() : m_Tree->size();
+  }
+
+  bool SetExpression::Value::empty() const
+  {
+    return m_Tree == nullptr && m_Dense == nullptr;
+  }
+
+  bool SetExpression::Value::operator==(const Value& right) const
+  {
+    return m_Tree == right.m_Tree && m_Dense == right.m_Dense;
+  }
+
+  SetExpression::Value SetExpression::evaluated() const
+  {
+    std::lock_guard< std::mutex > lock(m_Mutex);
+
+    if (m_Cache.empty())
+    {
+      FusedProgram program;
+      size_t root = compile(program);
+      m_Cache = evaluate(program, root, m_Name);
+      m_Operands.clear();
+    }
+
+    return m_Cache;
+  }
+
+  size_t SetExpression::compile(FusedProgram& program) const
+  {
+    std::vector< size_t > operands;
+    for (const ExpressionHandle& operand : m_Operands)
+    {
+      operands.push_back(compileOperand(*operand, program));
+    }
+
+    program.m_Steps.push_back(Step{ m_Operation, 0, std::move(operands) });
+
+    return program.m_Steps.size() - 1;
+  }
+
+  size_t SetExpression::compileOperand(const SetExpression& operand, FusedProgram& program)
+  {
+    std::lock_guard< std::mutex > lock(operand.m_Mutex);
+
+    if (!operand.m_Cache.empty())
+    {
+      program.m_Steps.push_back(Step{ Operation::Leaf, addInput(operand.m_Cache, program), std::vector< size_t >() });
+      return program.m_Steps.size() - 1;
+    }
+
+    return operand.compile(program);
+  }
+
+  size_t SetExpression::addInput(const Value& value, FusedProgram& program)
+  {
+    for (size_t i = 0; i < program.m_Inputs.size(); i++)
+    {
+      if (program.m_Inputs[i] == value)
+      {
+        return i;
+      }
+    }
+
+    program.m_Inputs.push_back(value);
+
+    return program.m_Inputs.size() - 1;
+  }
+
+  size_t SetExpression::resultBound(const FusedProgram& program, size_t step)
+  {
+    const Step& current = program.m_Steps[step];
+    size_t bound = 0;
+
+    switch (current.m_Operation)
+    {
+    case Operation::Leaf:
+      bound = program.m_Inputs[current.m_Input].size();
+      break;
+    case Operation::Union:
+      for (size_t operand : current.m_Operands)
+      {
+        bound += resultBound(program, operand);
+      }
+      break;
+    case Operation::Intersect:
+      bound = resultBound(program, current.m_Operands[0]);
+      for (size_t operand : current.m_Operands)
+      {
+        bound = std::min(bound, resultBound(program, operand));
+      }
+      break;
+    case Operation::Complement:
+      bound = resultBound(program, current.m_Operands[0]);
+      break;
+    }
+
+    return bound;
+  }
+
+  const DataSetValue* SetExpression::evaluateSteps(const FusedProgram& program, size_t root,
+    const std::vector< const DataSetValue* >& present, std::vector< const DataSetValue* >& results)
+  {
+    // Steps are stored in post-order, so every operand is evaluated before the step that uses it.
+    for (size_t i = 0; i <= root; i++)
+    {
+      const Step& step = program.m_Steps[i];
+      const DataSetValue* result = nullptr;
+
+      switch (step.m_Operation)
+      {
+      case Operation::Leaf:
+        result = present[step.m_Input];
+        break;
+      case Operation::Union:
+        for (size_t operand : step.m_Operands)
+        {
+          if (results[operand] != nullptr)
+          {
+            result = results[operand];
+            break;
+          }
+        }
+        break;
+      case Operation::Intersect:
+        result = results[step.m_Operands[0]];
+        for (size_t operand : step.m_Operands)
+        {
+          if (results[operand] == nullptr)
+          {
+            result = nullptr;
+            break;
+          }
+        }
+        break;
+      case Operation::Complement:
+        result = results[step.m_Operands[0]];
+        for (size_t j = 1; j < step.m_Operands.size() && result != nullptr; j++)
+        {
+          if (results[step.m_Operands[j]] != nullptr)
+          {
+            result = nullptr;
+          }
+        }
+        break;
+      }
+
+      results[i] = result;
+    }
+
+    return results[root];
+  }
+
+  SetExpression::Value SetExpression::evaluate(const FusedProgram& program, size_t root, const std::string& name)
+  {
+    using HeapEntry = std::pair< int, size_t >;
+    std::priority_queue< HeapEntry, std::vector< HeapEntry >, std::greater< HeapEntry > > heap;
+    std::vector< Cursor > cursors;
+    for (size_t i = 0; i < program.m_Inputs.size(); i++)
+    {
+      cursors.emplace_back(program.m_Inputs[i].m_Tree.get(), program.m_Inputs[i].m_Dense.get());
+      if (!cursors[i].done())
+      {
+        heap.emplace(cursors[i].key(), i);
+      }
+    }
+
+    // A single operation over plain inputs, which is what every command builds, is decided from the inputs holding
+    // the current key alone, so a key costs O(log k) heap work instead of a pass over all k operands.
+    const Step& top = program.m_Steps[root];
+    bool flat = isFlat(program, root);
+    if (flat && allDense(program))
+    {
+      return evaluateDense(program, root, name);
+    }
+
+    size_t leftInput = program.m_Steps[top.m_Operands[0]].m_Input;
+    std::vector< size_t > firstPosition(cursors.size(), top.m_Operands.size());
+    std::vector< bool > subtracted(cursors.size(), false);
+    for (size_t i = 0; flat && i < top.m_Operands.size(); i++)
+    {
+      size_t input = program.m_Steps[top.m_Operands[i]].m_Input;
+      firstPosition[input] = std::min(firstPosition[input], i);
+      subtracted[input] = subtracted[input] || i > 0;
+    }
+    bool stopAfterLeft = flat && top.m_Operation != Operation::Union;
+
+    size_t totalSize = 0;
+    for (const Value& input : program.m_Inputs)
+    {
+      totalSize += input.size();
+    }
+
+    std::vector< const DataSetValue* > present(cursors.size(), nullptr);
+    std::vector< const DataSetValue* > results(program.m_Steps.size(), nullptr);
+    std::vector< size_t > touched;
+    std::vector< std::pair< int, DataSetValue > > entries;
+    entries.reserve(std::min(resultBound(program, root), totalSize));
+
+    while (!heap.empty())
+    {
+      if (stopAfterLeft && cursors[leftInput].done())
+      {
+        break;
+      }
+
+      int key = heap.top().first;
+      touched.clear();
+      do
+      {
+        size_t input = heap.top().second;
+        Cursor& cursor = cursors[input];
+        heap.pop();
+
+        present[input] = cursor.value();
+        touched.push_back(input);
+        cursor.next();
+        if (!cursor.done())
+        {
+          heap.emplace(cursor.key(), input);
+        }
+      } while (!heap.empty() && heap.top().first == key);
+
+      const DataSetValue* result = nullptr;
+      if (!flat)
+      {
+        result = evaluateSteps(program, root, present, results);
+      }
+      else if (top.m_Operation == Operation::Union)
+      {
+        size_t first = touched[0];
+        for (size_t input : touched)
+        {
+          first = firstPosition[input] < firstPosition[first] ? input : first;
+        }
+        result = present[first];
+      }
+      else if (top.m_Operation == Operation::Intersect)
+      {
+        result = touched.size() == cursors.size() ? present[leftInput] : nullptr;
+      }
+      else
+      {
+        result = present[leftInput];
+        for (size_t input : touched)
+        {
+          result = subtracted[input] ? nullptr : result;
+        }
+      }
+
+      if (result != nullptr)
+      {
+        entries.emplace_back(key, *result);
+      }
+      for (size_t input : touched)
+      {
+        present[input] = nullptr;
+      }
+    }
+
+    return store(std::move(entries), name);
+  }
+
+  SetExpression::Value SetExpression::evaluateDense(const FusedProgram& program, size_t root, const std::string& name)
+  {
+    const Step& top = program.m_Steps[root];
+    std::vector< const DenseDataSet* > operands;
+    for (size_t operand : top.m_Operands)
+    {
+      operands.push_back(program.m_Inputs[program.m_Steps[operand].m_Input].m_Dense.get());
+    }
+
+    const DenseDataSet& left = *operands[0];
+    KeyBitmap keys = left.keys();
+    for (size_t i = 1; i < operands.size(); i++)
+    {
+      if (top.m_Operation == Operation::Union)
+      {
+        keys = KeyBitmap::unite(keys, operands[i]->keys());
+      }
+      else if (top.m_Operation == Operation::Intersect)
+      {
+        keys = KeyBitmap::intersect(keys, operands[i]->keys());
+      }
+      else
+      {
+        keys = KeyBitmap::subtract(keys, operands[i]->keys());
+      }
+    }
+
+    // Result keys are a subset of every operand they are looked up in, so values are found by walking both key sets
+    // in step instead of ranking each key separately.
+    std::vector< DataSetValue > values;
+    if (top.m_Operation != Operation::Union)
+    {
+      values.reserve(keys.size());
+      auto source = left.keys().cbegin();
+      size_t sourceIndex = 0;
+      for (auto i = keys.cbegin(); i != keys.cend(); ++i)
+      {
+        for (; *source != *i; ++source)
+        {
+          sourceIndex++;
+        }
+        values.push_back(left.values()[sourceIndex]);
+      }
+
+      return store(std::move(keys), std::move(values), name);
+    }
+
+    // Union keys come from several operands: keep one cursor per operand and take each key's value from the first
+    // operand whose cursor sits on it.
+    std::vector< Cursor > cursors;
+    for (const DenseDataSet* operand : operands)
+    {
+      cursors.emplace_back(nullptr, operand);
+    }
+
+    values.reserve(keys.size());
+    for (auto i = keys.cbegin(); i != keys.cend(); ++i)
+    {
+      const DataSetValue* value = nullptr;
+      for (Cursor& cursor : cursors)
+      {
+        if (!cursor.done() && cursor.key() == *i)
+        {
+          value = value == nullptr ? cursor.value() : value;
+          cursor.next();
+        }
+      }
+      values.push_back(*value);
+    }
+
+    return store(std::move(keys), std::move(values), name);
+  }
+
+  SetExpression::Value SetExpression::store(std::vector< std::pair< int, DataSetValue > >&& entries,
+    const std::string& name)
+  {
+    if (!entries.empty() && DenseDataSet::suits(entries.size(), entries.front().first, entries.back().first))
+    {
+      std::vector< int > keys;
+      std::vector< DataSetValue > values;
+      keys.reserve(entries.size());
+      values.reserve(entries.size());
+      for (std::pair< int, DataSetValue >& entry : entries)
+      {
+        keys.push_back(entry.first);
+        values.push_back(std::move(entry.second));
+      }
+
+      return Value{ nullptr,
+        std::make_shared< const DenseDataSet >(KeyBitmap::fromSorted(keys.begin(), keys.end()), std::move(values)) };
+    }
+
+    std::shared_ptr< DataSet > value = std::make_shared< DataSet >(name);
+    value->assignSorted(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+
+    return Value{ value, nullptr };
+  }
+
+  SetExpression::Value SetExpression::store(KeyBitmap&& keys, std::vector< DataSetValue >&& values,
+    const std::string& name)
+  {
+    if (!keys.empty() && DenseDataSet::suits(keys.size(), keys.minimum(), keys.maximum()))
+    {
+      return Value{ nullptr, std::make_shared< const DenseDataSet >(std::move(keys), std::move(values)) };
+    }
+
+    std::vector< std::pair< int, DataSetValue > > entries;
+    entries.reserve(values.size());
+    size_t index = 0;
+    for (auto i = keys.cbegin(); i != keys.cend(); ++i)
+    {
+      entries.emplace_back(*i, std::move(values[index++]));
+    }
+
+    std::shared_ptr< DataSet > value = std::make_shared< DataSet >(name);
+    value->assignSorted(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+
+    return Value{ value, nullptr };
+  }
+
+  bool SetExpression::isFlat(const FusedProgram& program, size_t root)
+  {
+    for (size_t operand : program.m_Steps[root].m_Operands)
+    {
+      if (program.m_Steps[operand].m_Operation != Operation::Leaf)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool SetExpression::allDense(const FusedProgram& program)
+  {
+    for (const Value& input : program.m_Inputs)
+    {
+      if (input.m_Dense == nullptr)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+}
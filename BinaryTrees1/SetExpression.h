@@ -0,0 +1,123 @@
+#ifndef SET_EXPRESSION_H
+#define SET_EXPRESSION_H
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "DenseDataSet.h"
+#include "Snapshot.h"
+
+namespace bavykin
+{
+  class SetExpression;
+  using ExpressionHandle = std::shared_ptr< const SetExpression >;
+
+  // A dataset that is either already built or a lazy N-ary union/intersect/complement over other datasets. Union
+  // takes each key's value from the first operand holding it, intersect keeps the first operand's keys present in
+  // every operand, and complement keeps the first operand's keys absent from all the others. Lazy datasets
+  // capture their inputs' handles at definition time, so redefining an input later never changes them. The whole
+  // expression is evaluated by one fused merge over the sorted inputs the first time it is read, and the result is
+  // cached; after that the node behaves like a built dataset and releases its operands.
+  //
+  // A built dataset is held either as a tree or, when its keys are dense, as a DenseDataSet. A single operation
+  // whose inputs are all dense runs on the key bitmaps word by word instead of merging entry by entry.
+  class SetExpression
+  {
+  public:
+    enum class Operation
+    {
+      Leaf,
+      Union,
+      Intersect,
+      Complement
+    };
+
+    SetExpression(DataSetHandle value);
+    SetExpression(DenseHandle value, const std::string& name);
+    SetExpression(Operation operation, const std::string& name, std::vector< ExpressionHandle > operands);
+    SetExpression(const SetExpression&) = delete;
+    SetExpression& operator=(const SetExpression&) = delete;
+
+    static ExpressionHandle fromDataSet(DataSetHandle value);
+    static ExpressionHandle combine(Operation operation, const std::string& name,
+      std::vector< ExpressionHandle > operands);
+
+    DataSetHandle materialize() const;
+    DenseHandle dense() const;
+    template < typename F >
+    void forEach(F function) const;
+    size_t size() const;
+    bool isDense() const;
+    bool isMaterialized() const;
+    size_t inputCount() const;
+
+  private:
+    struct Value
+    {
+      DataSetHandle m_Tree;
+      DenseHandle m_Dense;
+
+      size_t size() const;
+      bool empty() const;
+      bool operator==(const Value& right) const;
+    };
+
+    struct Step
+    {
+      Operation m_Operation;
+      size_t m_Input;
+      std::vector< size_t > m_Operands;
+    };
+
+    struct FusedProgram
+    {
+      std::vector< Value > m_Inputs;
+      std::vector< Step > m_Steps;
+    };
+
+    Operation m_Operation;
+    std::string m_Name;
+    size_t m_InputCount;
+    mutable std::mutex m_Mutex;
+    mutable std::vector< ExpressionHandle > m_Operands;
+    mutable Value m_Cache;
+
+    Value evaluated() const;
+    size_t compile(FusedProgram& program) const;
+    static size_t compileOperand(const SetExpression& operand, FusedProgram& program);
+    static size_t addInput(const Value& value, FusedProgram& program);
+    static size_t resultBound(const FusedProgram& program, size_t step);
+    static const DataSetValue* evaluateSteps(const FusedProgram& program, size_t root,
+      const std::vector< const DataSetValue* >& present, std::vector< const DataSetValue* >& results);
+    static Value evaluate(const FusedProgram& program, size_t root, const std::string& name);
+    static Value evaluateDense(const FusedProgram& program, size_t root, const std::string& name);
+    static bool isFlat(const FusedProgram& program, size_t root);
+    static bool allDense(const FusedProgram& program);
+    static Value store(std::vector< std::pair< int, DataSetValue > >&& entries, const std::string& name);
+    static Value store(KeyBitmap&& keys, std::vector< DataSetValue >&& values, const std::string& name);
+  };
+
+  template < typename F >
+  void SetExpression::forEach(F function) const
+  {
+    Value value = evaluated();
+
+    if (value.m_Dense != nullptr)
+    {
+      const std::vector< DataSetValue >& values = value.m_Dense->values();
+      size_t index = 0;
+      for (auto i = value.m_Dense->keys().cbegin(); i != value.m_Dense->keys().cend(); ++i)
+      {
+        function(*i, values[index++]);
+      }
+      return;
+    }
+
+    for (auto i = value.m_Tree->cbegin(); i != value.m_Tree->cend(); ++i)
+    {
+      function(i.m_Current->m_Content.first, i.m_Current->m_Content.second);
+    }
+  }
+}
+#endif
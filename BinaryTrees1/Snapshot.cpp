@@ -0,0 +1,360 @@
+#include "Snapshot.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bavykin
+{
+  namespace
+  {
+    const char SNAPSHOT_MAGIC[4] = { 'B', 'T', 'S', 'N' };
+    const uint32_t SNAPSHOT_VERSION = 1;
+
+    struct SnapshotHeader
+    {
+      char m_Magic[4];
+      uint32_t m_Version;
+      uint64_t m_DictionaryCount;
+      uint64_t m_HeapOffset;
+      uint64_t m_HeapSize;
+    };
+
+    struct SnapshotTableEntry
+    {
+      uint64_t m_NameOffset;
+      uint64_t m_NameLength;
+      uint64_t m_EntryCount;
+      uint64_t m_KeysOffset;
+      uint64_t m_ValuesOffset;
+    };
+
+    struct SnapshotValueRef
+    {
+      uint64_t m_Offset;
+      uint64_t m_Length;
+    };
+
+    uint64_t alignUp(uint64_t value)
+    {
+      return (value + 7) & ~static_cast< uint64_t >(7);
+    }
+
+    template < typename T >
+    void writePod(std::ostream& out, const T& value)
+    {
+      out.write(reinterpret_cast< const char* >(&value), sizeof(T));
+    }
+
+    void writePadding(std::ostream& out, uint64_t written)
+    {
+      static const char zeroes[8] = {};
+      out.write(zeroes, static_cast< std::streamsize >(alignUp(written) - written));
+    }
+
+    class MappedFile
+    {
+    public:
+      MappedFile(const std::string& path);
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+      ~MappedFile();
+
+      const char* data() const;
+      uint64_t size() const;
+
+    private:
+      const char* m_Data;
+      uint64_t m_Size;
+#ifdef _WIN32
+      HANDLE m_File;
+      HANDLE m_Mapping;
+#endif
+    };
+
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& path): m_Data(nullptr), m_Size(0), m_File(nullptr), m_Mapping(nullptr)
+    {
+      m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+      if (m_File == INVALID_HANDLE_VALUE)
+      {
+        throw std::runtime_error("The snapshot file was not opened.");
+      }
+
+      LARGE_INTEGER fileSize;
+      if (!GetFileSizeEx(m_File, &fileSize))
+      {
+        CloseHandle(m_File);
+        throw std::runtime_error("The snapshot file size cannot be read.");
+      }
+      m_Size = static_cast< uint64_t >(fileSize.QuadPart);
+
+      if (m_Size != 0)
+      {
+        m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_Mapping == nullptr)
+        {
+          CloseHandle(m_File);
+          throw std::runtime_error("The snapshot file cannot be mapped.");
+        }
+        m_Data = static_cast< const char* >(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_Data == nullptr)
+        {
+          CloseHandle(m_Mapping);
+          CloseHandle(m_File);
+          throw std::runtime_error("The snapshot file cannot be mapped.");
+        }
+      }
+    }
+
+    MappedFile::~MappedFile()
+    {
+      if (m_Data != nullptr)
+      {
+        UnmapViewOfFile(m_Data);
+      }
+      if (m_Mapping != nullptr)
+      {
+        CloseHandle(m_Mapping);
+      }
+      CloseHandle(m_File);
+    }
+#else
+    MappedFile::MappedFile(const std::string& path): m_Data(nullptr), m_Size(0)
+    {
+      int descriptor = open(path.c_str(), O_RDONLY);
+      if (descriptor < 0)
+      {
+        throw std::runtime_error("The snapshot file was not opened.");
+      }
+
+      struct stat fileInfo;
+      if (fstat(descriptor, &fileInfo) != 0)
+      {
+        close(descriptor);
+        throw std::runtime_error("The snapshot file size cannot be read.");
+      }
+      m_Size = static_cast< uint64_t >(fileInfo.st_size);
+
+      if (m_Size != 0)
+      {
+        void* mapped = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapped == MAP_FAILED)
+        {
+          close(descriptor);
+          throw std::runtime_error("The snapshot file cannot be mapped.");
+        }
+        madvise(mapped, m_Size, MADV_SEQUENTIAL);
+        m_Data = static_cast< const char* >(mapped);
+      }
+
+      close(descriptor);
+    }
+
+    MappedFile::~MappedFile()
+    {
+      if (m_Data != nullptr)
+      {
+        munmap(const_cast< char* >(m_Data), m_Size);
+      }
+    }
+#endif
+
+    const char* MappedFile::data() const
+    {
+      return m_Data;
+    }
+
+    uint64_t MappedFile::size() const
+    {
+      return m_Size;
+    }
+
+    template < typename T >
+    T readPod(const MappedFile& file, uint64_t offset)
+    {
+      if (offset > file.size() || file.size() - offset < sizeof(T))
+      {
+        throw std::runtime_error("The snapshot file is truncated.");
+      }
+
+      T value;
+      std::memcpy(&value, file.data() + offset, sizeof(T));
+      return value;
+    }
+
+    void checkRange(const MappedFile& file, uint64_t offset, uint64_t count, uint64_t elementSize)
+    {
+      if (offset > file.size() || count > (file.size() - offset) / elementSize)
+      {
+        throw std::runtime_error("The snapshot file is truncated.");
+      }
+    }
+  }
+
+  void saveSnapshot(const std::string& path, const DataSets& dataSets)
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+      throw std::runtime_error("The snapshot file was not opened.");
+    }
+
+    uint64_t dictionaryCount = dataSets.size();
+    uint64_t position = alignUp(sizeof(SnapshotHeader) + dictionaryCount * sizeof(SnapshotTableEntry));
+    uint64_t heapSize = 0;
+    std::vector< SnapshotTableEntry > table;
+    table.reserve(dictionaryCount);
+
+    for (auto i = dataSets.cbegin(); i != dataSets.cend(); ++i)
+    {
+      SnapshotTableEntry entry;
+      entry.m_NameOffset = heapSize;
+      entry.m_NameLength = i.m_Current->m_Content.first.size();
+      entry.m_EntryCount = i.m_Current->m_Content.second->size();
+      entry.m_KeysOffset = position;
+      position = alignUp(position + entry.m_EntryCount * sizeof(int32_t));
+      entry.m_ValuesOffset = position;
+      position += entry.m_EntryCount * sizeof(SnapshotValueRef);
+      heapSize += entry.m_NameLength;
+      table.push_back(entry);
+    }
+
+    uint64_t valuesHeapStart = heapSize;
+    for (auto i = dataSets.cbegin(); i != dataSets.cend(); ++i)
+    {
+      const DataSet& current = *i.m_Current->m_Content.second;
+      for (auto j = current.cbegin(); j != current.cend(); ++j)
+      {
+        heapSize += std::string_view(j.m_Current->m_Content.second).size();
+      }
+    }
+
+    SnapshotHeader header;
+    std::memcpy(header.m_Magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.m_Version = SNAPSHOT_VERSION;
+    header.m_DictionaryCount = dictionaryCount;
+    header.m_HeapOffset = position;
+    header.m_HeapSize = heapSize;
+
+    writePod(out, header);
+    for (const SnapshotTableEntry& entry : table)
+    {
+      writePod(out, entry);
+    }
+    writePadding(out, sizeof(SnapshotHeader) + dictionaryCount * sizeof(SnapshotTableEntry));
+
+    uint64_t valueOffset = valuesHeapStart;
+    for (auto i = dataSets.cbegin(); i != dataSets.cend(); ++i)
+    {
+      const DataSet& current = *i.m_Current->m_Content.second;
+      for (auto j = current.cbegin(); j != current.cend(); ++j)
+      {
+        writePod(out, static_cast< int32_t >(j.m_Current->m_Content.first));
+      }
+      writePadding(out, current.size() * sizeof(int32_t));
+
+      for (auto j = current.cbegin(); j != current.cend(); ++j)
+      {
+        SnapshotValueRef ref = { valueOffset, std::string_view(j.m_Current->m_Content.second).size() };
+        writePod(out, ref);
+        valueOffset += ref.m_Length;
+      }
+    }
+
+    for (auto i = dataSets.cbegin(); i != dataSets.cend(); ++i)
+    {
+      out.write(i.m_Current->m_Content.first.data(), i.m_Current->m_Content.first.size());
+    }
+    for (auto i = dataSets.cbegin(); i != dataSets.cend(); ++i)
+    {
+      const DataSet& current = *i.m_Current->m_Content.second;
+      for (auto j = current.cbegin(); j != current.cend(); ++j)
+      {
+        std::string_view value = j.m_Current->m_Content.second;
+        out.write(value.data(), static_cast< std::streamsize >(value.size()));
+      }
+    }
+
+    if (!out)
+    {
+      throw std::runtime_error("The snapshot file cannot be written.");
+    }
+  }
+
+  DataSets loadSnapshot(const std::string& path)
+  {
+    MappedFile file(path);
+
+    SnapshotHeader header = readPod< SnapshotHeader >(file, 0);
+    if (std::memcmp(header.m_Magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+      header.m_Version != SNAPSHOT_VERSION)
+    {
+      throw std::runtime_error("The file is not a supported snapshot.");
+    }
+
+    checkRange(file, sizeof(SnapshotHeader), header.m_DictionaryCount, sizeof(SnapshotTableEntry));
+    checkRange(file, header.m_HeapOffset, header.m_HeapSize, 1);
+    const char* heap = file.data() + header.m_HeapOffset;
+
+    std::vector< std::pair< std::string, DataSetHandle > > loaded;
+    loaded.reserve(static_cast< size_t >(header.m_DictionaryCount));
+
+    for (uint64_t i = 0; i < header.m_DictionaryCount; i++)
+    {
+      SnapshotTableEntry entry =
+        readPod< SnapshotTableEntry >(file, sizeof(SnapshotHeader) + i * sizeof(SnapshotTableEntry));
+      checkRange(file, entry.m_KeysOffset, entry.m_EntryCount, sizeof(int32_t));
+      checkRange(file, entry.m_ValuesOffset, entry.m_EntryCount, sizeof(SnapshotValueRef));
+      if (entry.m_NameOffset > header.m_HeapSize || entry.m_NameLength > header.m_HeapSize - entry.m_NameOffset)
+      {
+        throw std::runtime_error("The snapshot file is corrupted.");
+      }
+
+      std::string name(heap + entry.m_NameOffset, static_cast< size_t >(entry.m_NameLength));
+      if (!loaded.empty() && !(loaded.back().first < name))
+      {
+        throw std::runtime_error("The snapshot file is corrupted.");
+      }
+
+      std::vector< std::pair< int, DataSetValue > > entries;
+      entries.reserve(static_cast< size_t >(entry.m_EntryCount));
+      for (uint64_t j = 0; j < entry.m_EntryCount; j++)
+      {
+        int32_t key = readPod< int32_t >(file, entry.m_KeysOffset + j * sizeof(int32_t));
+        SnapshotValueRef ref = readPod< SnapshotValueRef >(file, entry.m_ValuesOffset + j * sizeof(SnapshotValueRef));
+        if (ref.m_Offset > header.m_HeapSize || ref.m_Length > header.m_HeapSize - ref.m_Offset ||
+          (!entries.empty() && entries.back().first >= key))
+        {
+          throw std::runtime_error("The snapshot file is corrupted.");
+        }
+
+        std::string_view value(heap + ref.m_Offset, static_cast< size_t >(ref.m_Length));
+        entries.emplace_back(key, DataSetValue(value));
+      }
+
+      std::shared_ptr< DataSet > restored = std::make_shared< DataSet >(name);
+      restored->assignSorted(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+      loaded.emplace_back(std::move(name), std::move(restored));
+    }
+
+    DataSets dataSets;
+    dataSets.assignSorted(std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+
+    return dataSets;
+  }
+}
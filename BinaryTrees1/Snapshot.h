@@ -0,0 +1,31 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include <memory>
+#include <string>
+#include "Dictionary.h"
+#include "StringPool.h"
+
+namespace bavykin
+{
+  // Datasets are immutable once built and shared by handle, so commands read them by reference and replacing a
+  // dataset never copies the others.
+  // Values are plain strings by default. Building with BAVYKIN_INTERNED_VALUES stores them as StringPool ids instead,
+  // which shrinks every node and turns the value copies made by set operations into integer copies.
+#ifdef BAVYKIN_INTERNED_VALUES
+  using DataSetValue = InternedString;
+#else
+  using DataSetValue = std::string;
+#endif
+  using DataSet = dictionary< int, DataSetValue >;
+  using DataSetHandle = std::shared_ptr< const DataSet >;
+  using DataSets = dictionary< std::string, DataSetHandle >;
+
+  // Binary snapshot layout (native endianness, every section 8-byte aligned):
+  //   SnapshotHeader
+  //   SnapshotTableEntry[dictionaryCount]  - sorted by dictionary name
+  //   per dictionary: int32 keys[entryCount], SnapshotValueRef values[entryCount]
+  //   string heap with dictionary names and values
+  void saveSnapshot(const std::string& path, const DataSets& dataSets);
+  DataSets loadSnapshot(const std::string& path);
+}
+#endif
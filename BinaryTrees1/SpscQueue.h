@@ -0,0 +1,155 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace bavykin
+{
+  // Bounded single-producer/single-consumer ring buffer. Exactly one thread may push and exactly one thread may pop.
+  // A side that cannot make progress may sleep in waitForSpace or waitForItems; a push or pop wakes it, and so does
+  // wake, for a caller that gives up on the queue.
+  template < typename T >
+  class SpscQueue
+  {
+  public:
+    SpscQueue(size_t capacity);
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool tryPush(T&& value);
+    bool tryPop(T& value);
+    void waitForSpace(const std::atomic< bool >& aborted);
+    void waitForItems(const std::atomic< bool >& aborted);
+    void wake();
+
+  private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    std::vector< T > m_Slots;
+    size_t m_Mask;
+    alignas(CACHE_LINE_SIZE) std::atomic< size_t > m_Head;
+    alignas(CACHE_LINE_SIZE) std::atomic< size_t > m_Tail;
+    alignas(CACHE_LINE_SIZE) size_t m_CachedHead;
+    alignas(CACHE_LINE_SIZE) size_t m_CachedTail;
+    std::atomic< int > m_Sleepers;
+    std::mutex m_SleepMutex;
+    std::condition_variable m_Woken;
+
+    template < typename Ready >
+    void sleepUntil(Ready ready, const std::atomic< bool >& aborted);
+    void wakeSleepers();
+  };
+
+  template < typename T >
+  SpscQueue< T >::SpscQueue(size_t capacity): m_Mask(0), m_Head(0), m_Tail(0), m_CachedHead(0), m_CachedTail(0),
+    m_Sleepers(0)
+  {
+    size_t rounded = 2;
+    while (rounded < capacity)
+    {
+      rounded <<= 1;
+    }
+
+    m_Slots.resize(rounded);
+    m_Mask = rounded - 1;
+  }
+
+  template < typename T >
+  bool SpscQueue< T >::tryPush(T&& value)
+  {
+    size_t tail = m_Tail.load(std::memory_order_relaxed);
+
+    if (tail - m_CachedHead > m_Mask)
+    {
+      m_CachedHead = m_Head.load(std::memory_order_acquire);
+      if (tail - m_CachedHead > m_Mask)
+      {
+        return false;
+      }
+    }
+
+    m_Slots[tail & m_Mask] = std::move(value);
+    m_Tail.store(tail + 1, std::memory_order_release);
+    wakeSleepers();
+
+    return true;
+  }
+
+  template < typename T >
+  bool SpscQueue< T >::tryPop(T& value)
+  {
+    size_t head = m_Head.load(std::memory_order_relaxed);
+
+    if (head == m_CachedTail)
+    {
+      m_CachedTail = m_Tail.load(std::memory_order_acquire);
+      if (head == m_CachedTail)
+      {
+        return false;
+      }
+    }
+
+    value = std::move(m_Slots[head & m_Mask]);
+    m_Head.store(head + 1, std::memory_order_release);
+    wakeSleepers();
+
+    return true;
+  }
+
+  // Called by the producer: returns once a slot is free or aborted is set.
+  template < typename T >
+  void SpscQueue< T >::waitForSpace(const std::atomic< bool >& aborted)
+  {
+    sleepUntil([this]() {
+      return m_Tail.load(std::memory_order_relaxed) - m_Head.load(std::memory_order_acquire) <= m_Mask;
+    }, aborted);
+  }
+
+  // Called by the consumer: returns once a value is queued or aborted is set.
+  template < typename T >
+  void SpscQueue< T >::waitForItems(const std::atomic< bool >& aborted)
+  {
+    sleepUntil([this]() {
+      return m_Head.load(std::memory_order_relaxed) != m_Tail.load(std::memory_order_acquire);
+    }, aborted);
+  }
+
+  // Wakes both sides, so that they see an aborted flag set before the call.
+  template < typename T >
+  void SpscQueue< T >::wake()
+  {
+    std::lock_guard< std::mutex > lock(m_SleepMutex);
+    m_Woken.notify_all();
+  }
+
+  // The sleeper announces itself before checking ready, and the other side publishes its push or pop before
+  // checking for sleepers; with a full fence on both sides, one of them sees the other, so no wake-up is lost.
+  template < typename T >
+  template < typename Ready >
+  void SpscQueue< T >::sleepUntil(Ready ready, const std::atomic< bool >& aborted)
+  {
+    std::unique_lock< std::mutex > lock(m_SleepMutex);
+    m_Sleepers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    m_Woken.wait(lock, [&]() {
+      return ready() || aborted.load(std::memory_order_relaxed);
+    });
+    m_Sleepers.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  template < typename T >
+  void SpscQueue< T >::wakeSleepers()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_Sleepers.load(std::memory_order_relaxed) != 0)
+    {
+      std::lock_guard< std::mutex > lock(m_SleepMutex);
+      m_Woken.notify_all();
+    }
+  }
+}
+#endif
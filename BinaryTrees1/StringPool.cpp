@@ -0,0 +1,150 @@
+#include "StringPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace bavykin
+{
+  StringPool& StringPool::instance()
+  {
+    // Deliberately leaked: values may be read by destructors of other static objects.
+    static StringPool* pool = new StringPool();
+    return *pool;
+  }
+
+  StringPool::StringPool():
+    m_Blocks(new std::atomic< std::string_view* >[(size_t(UINT32_MAX) >> BLOCK_BITS) + 1]),
+    m_ArenaNext(nullptr),
+    m_ArenaFree(0),
+    m_ArenaBytes(0),
+    m_Size(0)
+  {
+    for (size_t i = 0; i <= (size_t(UINT32_MAX) >> BLOCK_BITS); i++)
+    {
+      m_Blocks[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    intern(std::string_view());
+  }
+
+  uint32_t StringPool::intern(std::string_view value)
+  {
+    std::lock_guard< std::mutex > lock(m_Mutex);
+
+    auto found = m_Ids.find(value);
+    if (found != m_Ids.end())
+    {
+      return found->second;
+    }
+    if (m_Size > UINT32_MAX)
+    {
+      throw std::length_error("The string pool is full.");
+    }
+
+    uint32_t id = static_cast< uint32_t >(m_Size);
+    std::atomic< std::string_view* >& block = m_Blocks[id >> BLOCK_BITS];
+    if (block.load(std::memory_order_relaxed) == nullptr)
+    {
+      block.store(new std::string_view[BLOCK_SIZE], std::memory_order_release);
+    }
+
+    std::string_view stored(store(value), value.size());
+    block.load(std::memory_order_relaxed)[id & (BLOCK_SIZE - 1)] = stored;
+    m_Ids.emplace(stored, id);
+    m_Size++;
+
+    return id;
+  }
+
+  std::string_view StringPool::view(uint32_t id) const
+  {
+    return m_Blocks[id >> BLOCK_BITS].load(std::memory_order_acquire)[id & (BLOCK_SIZE - 1)];
+  }
+
+  size_t StringPool::size() const
+  {
+    std::lock_guard< std::mutex > lock(m_Mutex);
+
+    return m_Size;
+  }
+
+  size_t StringPool::memoryUsage() const
+  {
+    std::lock_guard< std::mutex > lock(m_Mutex);
+
+    // The hash index is estimated as one bucket pointer plus one node (next pointer, key, id, cached hash) per id.
+    size_t table = ((size_t(UINT32_MAX) >> BLOCK_BITS) + 1) * sizeof(std::atomic< std::string_view* >);
+    size_t blocks = (m_Size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    size_t index = m_Ids.bucket_count() * sizeof(void*) +
+      m_Ids.size() * (sizeof(void*) + sizeof(std::pair< const std::string_view, uint32_t >) + sizeof(size_t));
+
+    return table + m_ArenaBytes + blocks * BLOCK_SIZE * sizeof(std::string_view) + index;
+  }
+
+  const char* StringPool::store(std::string_view value)
+  {
+    if (value.empty())
+    {
+      return "";
+    }
+
+    if (value.size() > m_ArenaFree)
+    {
+      size_t chunkSize = std::max(ARENA_CHUNK_SIZE, value.size());
+      m_Arena.emplace_back(new char[chunkSize]);
+      m_ArenaBytes += chunkSize;
+      m_ArenaNext = m_Arena.back().get();
+      m_ArenaFree = chunkSize;
+    }
+
+    char* result = m_ArenaNext;
+    std::memcpy(result, value.data(), value.size());
+    m_ArenaNext += value.size();
+    m_ArenaFree -= value.size();
+
+    return result;
+  }
+
+  InternedString::InternedString() noexcept: m_Id(0)
+  {
+  }
+
+  InternedString::InternedString(std::string_view value): m_Id(StringPool::instance().intern(value))
+  {
+  }
+
+  InternedString::InternedString(const std::string& value): m_Id(StringPool::instance().intern(value))
+  {
+  }
+
+  InternedString::operator std::string_view() const
+  {
+    return view();
+  }
+
+  std::string_view InternedString::view() const
+  {
+    return StringPool::instance().view(m_Id);
+  }
+
+  uint32_t InternedString::id() const noexcept
+  {
+    return m_Id;
+  }
+
+  bool InternedString::operator==(const InternedString& right) const noexcept
+  {
+    return m_Id == right.m_Id;
+  }
+
+  bool InternedString::operator!=(const InternedString& right) const noexcept
+  {
+    return m_Id != right.m_Id;
+  }
+
+  std::ostream& operator<<(std::ostream& out, const InternedString& value)
+  {
+    return out << value.view();
+  }
+}
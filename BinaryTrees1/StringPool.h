@@ -0,0 +1,71 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace bavykin
+{
+  // Process-wide arena of distinct strings. Every string is stored once and addressed by a 32-bit id; the text
+  // never moves and is never freed, so looking an id up needs no lock and the returned view stays valid for the
+  // rest of the program. Id 0 is the empty string.
+  class StringPool
+  {
+  public:
+    static StringPool& instance();
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    uint32_t intern(std::string_view value);
+    std::string_view view(uint32_t id) const;
+    size_t size() const;
+    size_t memoryUsage() const;
+
+  private:
+    static constexpr size_t BLOCK_BITS = 16;
+    static constexpr size_t BLOCK_SIZE = size_t(1) << BLOCK_BITS;
+    static constexpr size_t ARENA_CHUNK_SIZE = size_t(1) << 16;
+
+    mutable std::mutex m_Mutex;
+    std::unique_ptr< std::atomic< std::string_view* >[] > m_Blocks;
+    std::vector< std::unique_ptr< char[] > > m_Arena;
+    char* m_ArenaNext;
+    size_t m_ArenaFree;
+    size_t m_ArenaBytes;
+    std::unordered_map< std::string_view, uint32_t > m_Ids;
+    size_t m_Size;
+
+    StringPool();
+    const char* store(std::string_view value);
+  };
+
+  // A dataset value held as its id in the StringPool: four bytes per node, copied and compared as an integer.
+  class InternedString
+  {
+  public:
+    InternedString() noexcept;
+    explicit InternedString(std::string_view value);
+    explicit InternedString(const std::string& value);
+
+    operator std::string_view() const;
+    std::string_view view() const;
+    uint32_t id() const noexcept;
+
+    bool operator==(const InternedString& right) const noexcept;
+    bool operator!=(const InternedString& right) const noexcept;
+
+  private:
+    uint32_t m_Id;
+  };
+
+  std::ostream& operator<<(std::ostream& out, const InternedString& value);
+}
+#endif
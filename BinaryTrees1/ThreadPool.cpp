@@ -0,0 +1,139 @@
+#include "ThreadPool.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    thread_local const ThreadPool* t_CurrentPool = nullptr;
+    thread_local size_t t_CurrentWorker = 0;
+  }
+
+  ThreadPool::ThreadPool(size_t threadCount): m_Queued(0), m_Unfinished(0), m_Stopping(false), m_NextQueue(0)
+  {
+    if (threadCount == 0)
+    {
+      threadCount = 1;
+    }
+
+    for (size_t i = 0; i < threadCount; i++)
+    {
+      m_Queues.push_back(std::unique_ptr< WorkerQueue >(new WorkerQueue()));
+    }
+
+    for (size_t i = 0; i < threadCount; i++)
+    {
+      m_Workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    {
+      std::lock_guard< std::mutex > lock(m_StateMutex);
+      m_Stopping = true;
+    }
+    m_WorkAvailable.notify_all();
+
+    for (std::thread& worker : m_Workers)
+    {
+      worker.join();
+    }
+  }
+
+  void ThreadPool::submit(std::function< void() > task)
+  {
+    size_t index = t_CurrentPool == this ? t_CurrentWorker : m_NextQueue++ % m_Queues.size();
+
+    {
+      std::lock_guard< std::mutex > lock(m_Queues[index]->m_Mutex);
+      m_Queues[index]->m_Tasks.push_front(std::move(task));
+    }
+
+    {
+      std::lock_guard< std::mutex > lock(m_StateMutex);
+      m_Queued++;
+      m_Unfinished++;
+    }
+    m_WorkAvailable.notify_one();
+  }
+
+  void ThreadPool::wait()
+  {
+    std::unique_lock< std::mutex > lock(m_StateMutex);
+    m_AllDone.wait(lock, [this]() {
+      return m_Unfinished == 0;
+    });
+  }
+
+  size_t ThreadPool::threadCount() const noexcept
+  {
+    return m_Workers.size();
+  }
+
+  void ThreadPool::workerLoop(size_t index)
+  {
+    t_CurrentPool = this;
+    t_CurrentWorker = index;
+
+    while (true)
+    {
+      {
+        std::unique_lock< std::mutex > lock(m_StateMutex);
+        m_WorkAvailable.wait(lock, [this]() {
+          return m_Stopping || m_Queued > 0;
+        });
+
+        if (m_Queued == 0)
+        {
+          return;
+        }
+        m_Queued--;
+      }
+
+      std::function< void() > task;
+      while (!tryTake(index, task))
+      {
+        std::this_thread::yield();
+      }
+
+      task();
+
+      bool finished = false;
+      {
+        std::lock_guard< std::mutex > lock(m_StateMutex);
+        finished = --m_Unfinished == 0;
+      }
+      if (finished)
+      {
+        m_AllDone.notify_all();
+      }
+    }
+  }
+
+  bool ThreadPool::tryTake(size_t index, std::function< void() >& task)
+  {
+    {
+      std::lock_guard< std::mutex > lock(m_Queues[index]->m_Mutex);
+      if (!m_Queues[index]->m_Tasks.empty())
+      {
+        task = std::move(m_Queues[index]->m_Tasks.front());
+        m_Queues[index]->m_Tasks.pop_front();
+        return true;
+      }
+    }
+
+    for (size_t offset = 1; offset < m_Queues.size(); offset++)
+    {
+      WorkerQueue& victim = *m_Queues[(index + offset) % m_Queues.size()];
+      std::lock_guard< std::mutex > lock(victim.m_Mutex);
+      if (!victim.m_Tasks.empty())
+      {
+        task = std::move(victim.m_Tasks.back());
+        victim.m_Tasks.pop_back();
+        return true;
+      }
+    }
+
+    return false;
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bavykin
+{
+  // Work-stealing pool: every worker owns a deque, pops its own newest task first and steals the oldest task of
+  // another worker when its deque runs dry. Tasks submitted from a worker go to that worker's deque.
+  class ThreadPool
+  {
+  public:
+    ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    void submit(std::function< void() > task);
+    void wait();
+    size_t threadCount() const noexcept;
+
+  private:
+    struct WorkerQueue
+    {
+      std::mutex m_Mutex;
+      std::deque< std::function< void() > > m_Tasks;
+    };
+
+    std::vector< std::unique_ptr< WorkerQueue > > m_Queues;
+    std::vector< std::thread > m_Workers;
+    std::mutex m_StateMutex;
+    std::condition_variable m_WorkAvailable;
+    std::condition_variable m_AllDone;
+    size_t m_Queued;
+    size_t m_Unfinished;
+    bool m_Stopping;
+    std::atomic< size_t > m_NextQueue;
+
+    void workerLoop(size_t index);
+    bool tryTake(size_t index, std::function< void() >& task);
+  };
+}
+#endif
@@ -0,0 +1,124 @@
+#ifndef THREE_WAY_COMPARE_H
+#define THREE_WAY_COMPARE_H
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#include <compare>
+#define BAVYKIN_HAS_THREE_WAY_COMPARISON
+#endif
+
+namespace bavykin
+{
+  template < class Compare, class Key, class = void >
+  struct HasCompareMember: std::false_type
+  {
+  };
+
+  template < class Compare, class Key >
+  struct HasCompareMember< Compare, Key,
+    std::void_t< decltype(std::declval< const Compare& >().compare(std::declval< const Key& >(),
+      std::declval< const Key& >())) > >: std::true_type
+  {
+  };
+
+  template < class Compare, class Key >
+  struct IsStringLess: std::false_type
+  {
+  };
+
+  template < class CharT, class Traits, class Allocator >
+  struct IsStringLess< std::less< std::basic_string< CharT, Traits, Allocator > >,
+    std::basic_string< CharT, Traits, Allocator > >: std::true_type
+  {
+  };
+
+  template < class CharT, class Traits, class Allocator >
+  struct IsStringLess< std::less<>, std::basic_string< CharT, Traits, Allocator > >: std::true_type
+  {
+  };
+
+#ifdef BAVYKIN_HAS_THREE_WAY_COMPARISON
+  template < class Compare, class Key >
+  constexpr bool RETURNS_ORDERING = std::is_same_v< std::invoke_result_t< const Compare&, const Key&, const Key& >,
+                                      std::strong_ordering > ||
+    std::is_same_v< std::invoke_result_t< const Compare&, const Key&, const Key& >, std::weak_ordering >;
+
+  template < class Compare, class Key >
+  constexpr bool IS_SPACESHIP_LESS =
+    (std::is_same_v< Compare, std::less< Key > > || std::is_same_v< Compare, std::less<> >) &&
+    std::three_way_comparable< Key, std::weak_ordering >;
+#else
+  template < class Compare, class Key >
+  constexpr bool RETURNS_ORDERING = false;
+
+  template < class Compare, class Key >
+  constexpr bool IS_SPACESHIP_LESS = false;
+#endif
+
+  // Adapts a tree comparator to the two questions a search asks: isLess for plain ordering, and compare for a
+  // three-way answer that is negative, zero or positive as left orders before, together with or after right.
+  // Comparators that can answer compare in one call are used that way:
+  //   - those with a compare(left, right) member returning such an int, beside the usual less-than operator;
+  //   - std::less over strings, which std::string::compare answers in one pass over the characters;
+  //   - with C++20, those returning std::strong_ordering or std::weak_ordering, such as std::compare_three_way, and
+  //     std::less over types with operator<=>.
+  // Any other comparator is asked twice, first whether left is less and then whether right is.
+  template < class Compare, class Key >
+  struct ThreeWayCompare
+  {
+    static constexpr bool IS_NATIVE = HasCompareMember< Compare, Key >::value || IsStringLess< Compare, Key >::value ||
+      RETURNS_ORDERING< Compare, Key > || IS_SPACESHIP_LESS< Compare, Key >;
+    // Comparator calls one compare costs, for the instrumentation counters.
+    static constexpr size_t CALLS = IS_NATIVE ? 1 : 2;
+
+    static bool isLess(const Compare& comp, const Key& left, const Key& right);
+    static int compare(const Compare& comp, const Key& left, const Key& right);
+  };
+
+  template < class Compare, class Key >
+  bool ThreeWayCompare< Compare, Key >::isLess(const Compare& comp, const Key& left, const Key& right)
+  {
+    if constexpr (RETURNS_ORDERING< Compare, Key >)
+    {
+      return comp(left, right) < 0;
+    }
+    else
+    {
+      return comp(left, right);
+    }
+  }
+
+  template < class Compare, class Key >
+  int ThreeWayCompare< Compare, Key >::compare(const Compare& comp, const Key& left, const Key& right)
+  {
+    if constexpr (HasCompareMember< Compare, Key >::value)
+    {
+      return static_cast< int >(comp.compare(left, right));
+    }
+    else if constexpr (IsStringLess< Compare, Key >::value)
+    {
+      return left.compare(right);
+    }
+#ifdef BAVYKIN_HAS_THREE_WAY_COMPARISON
+    else if constexpr (RETURNS_ORDERING< Compare, Key >)
+    {
+      std::weak_ordering order = comp(left, right);
+      return order < 0 ? -1 : order > 0 ? 1 : 0;
+    }
+    else if constexpr (IS_SPACESHIP_LESS< Compare, Key >)
+    {
+      std::weak_ordering order = left <=> right;
+      return order < 0 ? -1 : order > 0 ? 1 : 0;
+    }
+#endif
+    else
+    {
+      return comp(left, right) ? -1 : comp(right, left) ? 1 : 0;
+    }
+  }
+}
+#endif
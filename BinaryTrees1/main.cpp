@@ -21,7 +21,13 @@ int main(int argc, char* argv[])
     return 1;
   }
 
-  CommandExecutor().run(dictionaryDataSource);
+  {
+    CommandExecutor executor;
+    executor.run(dictionaryDataSource);
+#ifdef BAVYKIN_INSTRUMENTATION
+    executor.writeStatistics(std::cerr);
+#endif
+  }
 
   try
   {
@@ -35,7 +41,11 @@ int main(int argc, char* argv[])
         return 1;
       }
 
-      CommandExecutor().run(dictionaryDataSource);
+      CommandExecutor executor;
+      executor.run(dictionaryDataSource);
+#ifdef BAVYKIN_INSTRUMENTATION
+      executor.writeStatistics(std::cerr);
+#endif
     }
     else
     {
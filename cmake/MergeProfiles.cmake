@@ -0,0 +1,10 @@
+# Merges the raw profiles of a Clang training run: cmake -DPROFDATA=... -DDIRECTORY=... -DOUTPUT=... -P this file.
+file(GLOB raw "${DIRECTORY}/*.profraw")
+if(NOT raw)
+  message(FATAL_ERROR "No .profraw files in ${DIRECTORY}.")
+endif()
+
+execute_process(COMMAND ${PROFDATA} merge -output=${OUTPUT} ${raw} RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "llvm-profdata merge failed.")
+endif()
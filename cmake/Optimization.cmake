@@ -0,0 +1,84 @@
+# Compiler settings shared by every target: warnings, -march, link-time and profile-guided optimization. Targets
+# pick them up by linking bavykin_options privately.
+add_library(bavykin_options INTERFACE)
+
+if(MSVC)
+  target_compile_options(bavykin_options INTERFACE /W3 /permissive-)
+else()
+  target_compile_options(bavykin_options INTERFACE -Wall)
+  if(BAVYKIN_MARCH)
+    target_compile_options(bavykin_options INTERFACE -march=${BAVYKIN_MARCH})
+  endif()
+endif()
+
+if(BAVYKIN_LTO)
+  include(CheckIPOSupported)
+  check_ipo_supported(RESULT BAVYKIN_LTO_SUPPORTED OUTPUT BAVYKIN_LTO_ERROR LANGUAGES CXX)
+  if(BAVYKIN_LTO_SUPPORTED)
+    set(CMAKE_INTERPROCEDURAL_OPTIMIZATION_RELEASE ON)
+    set(CMAKE_INTERPROCEDURAL_OPTIMIZATION_RELWITHDEBINFO ON)
+  else()
+    message(WARNING "Link-time optimization is not supported: ${BAVYKIN_LTO_ERROR}")
+  endif()
+endif()
+
+set(BAVYKIN_PGO_CLANG_PROFILE "${BAVYKIN_PGO_DIR}/default.profdata")
+if(NOT BAVYKIN_PGO STREQUAL "OFF")
+  if(NOT CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+    message(FATAL_ERROR "BAVYKIN_PGO is only supported with GCC and Clang; use the Visual Studio project for MSVC PGO.")
+  endif()
+  if(NOT BAVYKIN_PGO MATCHES "^(GENERATE|USE)$")
+    message(FATAL_ERROR "BAVYKIN_PGO must be OFF, GENERATE or USE, not '${BAVYKIN_PGO}'.")
+  endif()
+endif()
+
+if(BAVYKIN_PGO STREQUAL "GENERATE")
+  # The worker threads update the same counters, so they are updated atomically to keep the profile consistent.
+  set(BAVYKIN_PGO_FLAGS -fprofile-generate=${BAVYKIN_PGO_DIR} -fprofile-update=atomic)
+  target_compile_options(bavykin_options INTERFACE ${BAVYKIN_PGO_FLAGS})
+  target_link_options(bavykin_options INTERFACE ${BAVYKIN_PGO_FLAGS})
+elseif(BAVYKIN_PGO STREQUAL "USE")
+  if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    if(NOT EXISTS "${BAVYKIN_PGO_CLANG_PROFILE}")
+      message(FATAL_ERROR "No profile at ${BAVYKIN_PGO_CLANG_PROFILE}; build pgo-train with BAVYKIN_PGO=GENERATE first.")
+    endif()
+    target_compile_options(bavykin_options INTERFACE -fprofile-use=${BAVYKIN_PGO_CLANG_PROFILE}
+      -Wno-profile-instr-unprofiled)
+  else()
+    if(NOT EXISTS "${BAVYKIN_PGO_DIR}")
+      message(FATAL_ERROR "No profiles in ${BAVYKIN_PGO_DIR}; build pgo-train with BAVYKIN_PGO=GENERATE first.")
+    endif()
+    target_compile_options(bavykin_options INTERFACE -fprofile-use=${BAVYKIN_PGO_DIR} -fprofile-correction
+      -Wno-missing-profile)
+  endif()
+endif()
+
+# pgo-train runs the benchmark suite on the instrumented build: the command replay and pipeline workloads cover parsing,
+# the executor and the trees, the density run covers the bitmap set operations. The scheduler and container cases are
+# left out; instrumented, they take minutes. Clang's raw profiles are merged into the file USE builds read.
+function(bavykin_add_pgo_training)
+  if(NOT BAVYKIN_PGO STREQUAL "GENERATE")
+    return()
+  endif()
+  if(NOT TARGET Benchmarks)
+    message(FATAL_ERROR "BAVYKIN_PGO=GENERATE trains on the benchmarks; enable BAVYKIN_BENCHMARKS.")
+  endif()
+
+  set(merge)
+  if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    find_program(BAVYKIN_LLVM_PROFDATA NAMES llvm-profdata REQUIRED)
+    set(merge COMMAND ${CMAKE_COMMAND} -DPROFDATA=${BAVYKIN_LLVM_PROFDATA} -DDIRECTORY=${BAVYKIN_PGO_DIR}
+      -DOUTPUT=${BAVYKIN_PGO_CLANG_PROFILE} -P ${PROJECT_SOURCE_DIR}/cmake/MergeProfiles.cmake)
+  endif()
+
+  file(MAKE_DIRECTORY ${BAVYKIN_PGO_DIR})
+  add_custom_target(pgo-train
+    COMMAND $<TARGET_FILE:Benchmarks> replay 300000
+    COMMAND $<TARGET_FILE:Benchmarks> pipeline 300000
+    COMMAND $<TARGET_FILE:Benchmarks> density 262144 2
+    ${merge}
+    DEPENDS Benchmarks BinaryTrees1
+    WORKING_DIRECTORY ${BAVYKIN_PGO_DIR}
+    USES_TERMINAL
+    VERBATIM)
+endfunction()
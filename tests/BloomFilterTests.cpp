@@ -0,0 +1,268 @@
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "BinarySearchTree.h"
+#include "BloomFilter.h"
+#include "Dictionary.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    using Tree = BST< int, int >;
+
+    void expectFindsModel(const Tree& tree, const std::map< int, int >& model, int range)
+    {
+      BAVYKIN_EXPECT(tree.size() == model.size());
+      for (int key = 0; key < range; key++)
+      {
+        std::map< int, int >::const_iterator expected = model.find(key);
+        Tree::iterator found = tree.find(key);
+        BAVYKIN_EXPECT((found == nullptr) == (expected == model.cend()));
+        BAVYKIN_EXPECT(found == nullptr || found->second == expected->second);
+      }
+    }
+
+    void testFilterAlone()
+    {
+      BloomFilter< int > filter;
+      BAVYKIN_EXPECT(!filter.enabled() && filter.mayContain(1));
+
+      filter.reset(1000);
+      for (int key = 0; key < 1000; key++)
+      {
+        BAVYKIN_EXPECT(filter.add(key * 3));
+      }
+      BAVYKIN_EXPECT(!filter.add(-1));
+
+      size_t falsePositives = 0;
+      for (int key = 0; key < 3000; key++)
+      {
+        bool added = key % 3 == 0;
+        BAVYKIN_EXPECT(!added || filter.mayContain(key));
+        falsePositives += !added && filter.mayContain(key) ? 1 : 0;
+      }
+      // About 1% of absent keys pass at the sized load; a few times that is still a working filter.
+      BAVYKIN_EXPECT(falsePositives < 2000 / 20);
+
+      filter.disable();
+      BAVYKIN_EXPECT(!filter.enabled() && filter.mayContain(4));
+    }
+
+    // Every change to a filtered tree against std::map, including the ones that rebuild the filter: growing past its
+    // capacity, batch merges, sorted rebuilds and turning it off and on. An erased key stays in the filter, so only
+    // false negatives would show, as keys the tree holds but find does not return.
+    void testNoFalseNegatives()
+    {
+      for (uint32_t seed = 0; seed < 20; seed++)
+      {
+        std::mt19937 random(seed);
+        const int range = 1000;
+        Tree tree;
+        tree.useMembershipFilter(true);
+        std::map< int, int > model;
+        for (int operation = 0; operation < 1000; operation++)
+        {
+          int key = static_cast< int >(random() % range);
+          switch (random() % 8)
+          {
+          case 0:
+          case 1:
+            tree.insert(std::make_pair(key, operation));
+            model[key] = operation;
+            break;
+          case 2:
+            tree.emplace_hint(tree.end(), key, operation);
+            model.emplace(key, operation);
+            break;
+          case 3:
+          case 4:
+            tree.erase(key);
+            model.erase(key);
+            break;
+          case 5:
+          {
+            std::vector< std::pair< int, int > > batch;
+            for (uint32_t i = random() % 100; i > 0; i--)
+            {
+              batch.emplace_back(static_cast< int >(random() % range), operation);
+              model[batch.back().first] = operation;
+            }
+            tree.insertBatch(batch.begin(), batch.end(), static_cast< Tree::BatchStrategy >(random() % 3));
+            break;
+          }
+          case 6:
+            tree.useMembershipFilter(false);
+            tree.insert(std::make_pair(key, operation));
+            model[key] = operation;
+            tree.useMembershipFilter(true);
+            break;
+          default:
+            if (random() % 8 == 0)
+            {
+              std::vector< std::pair< int, int > > sorted(model.cbegin(), model.cend());
+              tree.assignSorted(sorted.begin(), sorted.end());
+            }
+            break;
+          }
+        }
+        expectFindsModel(tree, model, range);
+
+        std::vector< int > keys;
+        for (int key = 0; key < range; key++)
+        {
+          keys.push_back(key);
+        }
+        std::vector< bool > contained;
+        tree.containsBatch(keys, contained);
+        for (int key = 0; key < range; key++)
+        {
+          BAVYKIN_EXPECT(contained[key] == (model.count(key) != 0));
+        }
+      }
+    }
+
+    void testEraseAndToggle()
+    {
+      Tree tree;
+      tree.useMembershipFilter(true);
+      std::map< int, int > model;
+      for (int key = 0; key < 500; key++)
+      {
+        tree.insert(std::make_pair(key, key));
+        model[key] = key;
+      }
+      for (int key = 0; key < 500; key += 2)
+      {
+        tree.erase(key);
+        model.erase(key);
+      }
+      expectFindsModel(tree, model, 1000);
+
+      tree.useMembershipFilter(false);
+      for (int key = 500; key < 1000; key++)
+      {
+        tree.insert(std::make_pair(key, key));
+        model[key] = key;
+      }
+      expectFindsModel(tree, model, 1000);
+      tree.useMembershipFilter(true);
+      expectFindsModel(tree, model, 1000);
+
+      tree.insert(std::make_pair(0, 1));
+      model[0] = 1;
+      expectFindsModel(tree, model, 1000);
+    }
+
+    void testCopies()
+    {
+      Tree tree;
+      tree.useMembershipFilter(true);
+      std::map< int, int > model;
+      for (int key = 0; key < 300; key += 3)
+      {
+        tree.insert(std::make_pair(key, key));
+        model[key] = key;
+      }
+
+      Tree copy(tree);
+      expectFindsModel(copy, model, 300);
+      copy.insert(std::make_pair(1, 1));
+      BAVYKIN_EXPECT(copy.find(1) != nullptr && tree.find(1) == nullptr);
+
+      Tree assigned;
+      assigned = copy;
+      BAVYKIN_EXPECT(assigned.find(1) != nullptr);
+      Tree moved(std::move(assigned));
+      BAVYKIN_EXPECT(moved.find(1) != nullptr);
+      moved.insert(std::make_pair(2, 2));
+      BAVYKIN_EXPECT(moved.find(2) != nullptr);
+      expectFindsModel(tree, model, 300);
+    }
+
+    void testDictionarySetOperations()
+    {
+      Dictionary< int, int > large("large");
+      Dictionary< int, int > small("small");
+      std::set< int > largeKeys;
+      std::set< int > smallKeys;
+      for (int key = 0; key < 5000; key += 2)
+      {
+        large.insert(key, key);
+        largeKeys.insert(key);
+      }
+      for (int key = 0; key < 5000; key += 7)
+      {
+        small.insert(key, key);
+        smallKeys.insert(key);
+      }
+      large.useMembershipFilter(true);
+      small.useMembershipFilter(true);
+
+      std::set< int > intersect;
+      std::set< int > complement;
+      for (int key : smallKeys)
+      {
+        (largeKeys.count(key) != 0 ? intersect : complement).insert(key);
+      }
+      Dictionary< int, int > gotIntersect = small.getIntersect(large);
+      Dictionary< int, int > gotComplement = small.getComplement(large);
+      BAVYKIN_EXPECT(gotIntersect.size() == intersect.size());
+      BAVYKIN_EXPECT(gotComplement.size() == complement.size());
+      for (int key : intersect)
+      {
+        BAVYKIN_EXPECT(gotIntersect.contains(key));
+      }
+      for (int key : complement)
+      {
+        BAVYKIN_EXPECT(gotComplement.contains(key));
+      }
+      BAVYKIN_EXPECT(large.getIntersect(small).size() == intersect.size());
+    }
+
+    void testUnsupportedComparator()
+    {
+      BST< int, int, std::greater< int > > descending;
+      descending.insert(std::make_pair(1, 1));
+      descending.useMembershipFilter(true);
+      BAVYKIN_EXPECT(descending.find(1) != nullptr && descending.find(2) == nullptr);
+
+      struct Custom
+      {
+        bool operator()(int left, int right) const
+        {
+          return left < right;
+        }
+      };
+      BST< int, int, Custom > custom;
+      custom.useMembershipFilter(false);
+      bool thrown = false;
+      try
+      {
+        custom.useMembershipFilter(true);
+      }
+      catch (const std::logic_error&)
+      {
+        thrown = true;
+      }
+      BAVYKIN_EXPECT(thrown);
+    }
+  }
+
+  void runBloomFilterTests()
+  {
+    testFilterAlone();
+    testNoFalseNegatives();
+    testEraseAndToggle();
+    testCopies();
+    testDictionarySetOperations();
+    testUnsupportedComparator();
+  }
+}
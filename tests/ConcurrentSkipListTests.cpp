@@ -0,0 +1,121 @@
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "ConcurrentSkipList.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    const int ROUNDS = 5;
+    const int THREADS = 8;
+    const int OPERATIONS = 20000;
+    const int KEY_RANGE = 64;
+
+    // Eight writers insert, erase and look up a small key range, so that every key is contended, while a walker checks
+    // that iteration stays strictly ascending. Each writer counts the inserts and erases that reported success, per
+    // key; with linearizable operations the net count of a key over all writers is 1 exactly when it ends present.
+    // A found value must be one some writer stored. Failures inside the threads are counted, not thrown.
+    void testStress()
+    {
+      for (int round = 0; round < ROUNDS; round++)
+      {
+        ConcurrentSkipList< int, int > list;
+        std::vector< std::vector< int64_t > > balances(THREADS, std::vector< int64_t >(KEY_RANGE));
+        std::atomic< bool > stop(false);
+        std::atomic< int > disorders(0);
+        std::atomic< int > torn(0);
+
+        std::thread walker([&list, &stop, &disorders]()
+        {
+          while (!stop.load())
+          {
+            int last = -1;
+            for (ConcurrentSkipList< int, int >::const_iterator i = list.cbegin(); i != list.cend(); ++i)
+            {
+              if (i->first <= last)
+              {
+                disorders++;
+              }
+              last = i->first;
+            }
+          }
+        });
+
+        std::vector< std::thread > writers;
+        for (int thread = 0; thread < THREADS; thread++)
+        {
+          writers.emplace_back([&list, &balances, &torn, thread, round]()
+          {
+            std::mt19937 random(static_cast< uint32_t >(thread * 7 + round));
+            std::vector< int64_t >& balance = balances[thread];
+            for (int operation = 0; operation < OPERATIONS; operation++)
+            {
+              int key = static_cast< int >(random() % KEY_RANGE);
+              int value = 0;
+              switch (random() % 4)
+              {
+              case 0:
+                balance[key] += list.insert(std::make_pair(key, thread)) ? 1 : 0;
+                break;
+              case 1:
+                balance[key] += list.insert(key) ? 1 : 0;
+                break;
+              case 2:
+                balance[key] -= list.erase(key) ? 1 : 0;
+                break;
+              default:
+                if (list.lookup(key, value) && (value < 0 || value >= THREADS))
+                {
+                  torn++;
+                }
+                list.contains(key);
+                break;
+              }
+            }
+          });
+        }
+        for (std::thread& writer : writers)
+        {
+          writer.join();
+        }
+        stop.store(true);
+        walker.join();
+
+        size_t present = 0;
+        for (int key = 0; key < KEY_RANGE; key++)
+        {
+          int64_t net = 0;
+          for (const std::vector< int64_t >& balance : balances)
+          {
+            net += balance[key];
+          }
+          bool contained = list.contains(key);
+          BAVYKIN_EXPECT(net == (contained ? 1 : 0));
+          present += contained ? 1 : 0;
+        }
+
+        size_t walked = 0;
+        for (ConcurrentSkipList< int, int >::iterator i = list.begin(); i != list.end(); ++i)
+        {
+          walked++;
+        }
+        BAVYKIN_EXPECT(disorders.load() == 0);
+        BAVYKIN_EXPECT(torn.load() == 0);
+        BAVYKIN_EXPECT(walked == present);
+        BAVYKIN_EXPECT(list.size() == present);
+        list.reclaim();
+      }
+    }
+  }
+
+  void runConcurrentSkipListTests()
+  {
+    testStress();
+  }
+}
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <climits>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "DenseDataSet.h"
+#include "KeyBitmap.h"
+#include "SetExpression.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    using Keys = std::set< int >;
+    using Model = std::map< int, std::string >;
+    using Operation = SetExpression::Operation;
+
+    struct Span
+    {
+      int m_First;
+      int m_Length;
+      double m_Density;
+    };
+
+    // Containers hold 65536 keys each and start at multiples of 65536, so these spans put keys on both sides of
+    // the chunk boundaries at -65536, 0 and 65536. A density of 0.9 over 12000 keys fills a container past the
+    // 4096 keys an array container holds, so it becomes a bitmap; 0.3 keeps it an array while the whole set stays
+    // dense enough to be stored as a DenseDataSet.
+    Keys makeKeys(std::mt19937& random, const std::vector< Span >& spans)
+    {
+      Keys keys;
+      std::uniform_real_distribution< double > coin(0.0, 1.0);
+      for (const Span& span : spans)
+      {
+        for (int key = span.m_First; key < span.m_First + span.m_Length; key++)
+        {
+          if (coin(random) < span.m_Density)
+          {
+            keys.insert(key);
+          }
+        }
+      }
+
+      return keys;
+    }
+
+    std::vector< Keys > makeKeySets(std::mt19937& random)
+    {
+      const double sets[][3] = { { 0.9, 0.9, 0.9 }, { 0.3, 0.9, 0.3 }, { 0.9, 0.3, 0.9 }, { 0.3, 0.3, 0.3 } };
+      std::vector< Keys > result;
+      for (const auto& densities : sets)
+      {
+        result.push_back(makeKeys(random, { { -65536 - 6000, 12000, densities[0] }, { -6000, 12000, densities[1] },
+          { 65536 - 6000, 12000, densities[2] } }));
+      }
+
+      return result;
+    }
+
+    size_t rankOf(const std::vector< int >& sorted, int key)
+    {
+      return static_cast< size_t >(std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin());
+    }
+
+    KeyBitmap toBitmap(const Keys& keys)
+    {
+      return KeyBitmap::fromSorted(keys.begin(), keys.end());
+    }
+
+    bool sameKeys(const KeyBitmap& bitmap, const Keys& keys)
+    {
+      if (bitmap.size() != keys.size() || bitmap.empty() != keys.empty())
+      {
+        return false;
+      }
+
+      auto expected = keys.begin();
+      for (auto i = bitmap.cbegin(); i != bitmap.cend(); ++i, ++expected)
+      {
+        if (expected == keys.end() || *i != *expected)
+        {
+          return false;
+        }
+      }
+
+      return expected == keys.end();
+    }
+
+    void testBitmapQueries()
+    {
+      std::mt19937 random(36);
+      std::vector< Keys > sets = makeKeySets(random);
+      Keys extremes = { INT_MIN, INT_MIN + 1, -65537, -65536, -1, 0, 65535, 65536, INT_MAX - 1, INT_MAX };
+      sets.push_back(extremes);
+      sets.push_back(makeKeys(random, { { -65536 - 6000, 140000, 0.02 } }));
+      sets.push_back(Keys());
+
+      for (const Keys& keys : sets)
+      {
+        KeyBitmap bitmap = toBitmap(keys);
+        std::vector< int > sorted(keys.begin(), keys.end());
+        BAVYKIN_EXPECT(sameKeys(bitmap, keys));
+        BAVYKIN_EXPECT(bitmap.validate());
+        if (!keys.empty())
+        {
+          BAVYKIN_EXPECT(bitmap.minimum() == *keys.begin());
+          BAVYKIN_EXPECT(bitmap.maximum() == *keys.rbegin());
+        }
+
+        for (int probe = -65536 - 7000; probe < 65536 + 7000; probe += 7)
+        {
+          BAVYKIN_EXPECT(bitmap.contains(probe) == (keys.count(probe) != 0));
+          BAVYKIN_EXPECT(bitmap.rank(probe) == rankOf(sorted, probe));
+        }
+        for (int probe : extremes)
+        {
+          BAVYKIN_EXPECT(bitmap.contains(probe) == (keys.count(probe) != 0));
+          BAVYKIN_EXPECT(bitmap.rank(probe) == rankOf(sorted, probe));
+        }
+      }
+    }
+
+    // Every pairing of array and bitmap containers goes through the word-by-word operations.
+    void testBitmapOperations()
+    {
+      std::mt19937 random(3600);
+      std::vector< Keys > sets = makeKeySets(random);
+      sets.push_back(makeKeys(random, { { -65536 - 6000, 140000, 0.02 } }));
+      sets.push_back(Keys());
+
+      for (const Keys& left : sets)
+      {
+        for (const Keys& right : sets)
+        {
+          Keys united;
+          Keys common;
+          Keys rest;
+          std::set_union(left.begin(), left.end(), right.begin(), right.end(), std::inserter(united, united.end()));
+          std::set_intersection(left.begin(), left.end(), right.begin(), right.end(),
+            std::inserter(common, common.end()));
+          std::set_difference(left.begin(), left.end(), right.begin(), right.end(), std::inserter(rest, rest.end()));
+
+          KeyBitmap unitedBitmap = KeyBitmap::unite(toBitmap(left), toBitmap(right));
+          KeyBitmap commonBitmap = KeyBitmap::intersect(toBitmap(left), toBitmap(right));
+          KeyBitmap restBitmap = KeyBitmap::subtract(toBitmap(left), toBitmap(right));
+          BAVYKIN_EXPECT(sameKeys(unitedBitmap, united) && unitedBitmap.validate());
+          BAVYKIN_EXPECT(sameKeys(commonBitmap, common) && commonBitmap.validate());
+          BAVYKIN_EXPECT(sameKeys(restBitmap, rest) && restBitmap.validate());
+        }
+      }
+    }
+
+    Model makeModel(const Keys& keys, const std::string& prefix)
+    {
+      Model model;
+      for (int key : keys)
+      {
+        model.emplace(key, prefix + std::to_string(key));
+      }
+
+      return model;
+    }
+
+    DataSetHandle makeTree(const Model& model, const std::string& name)
+    {
+      std::vector< std::pair< int, DataSetValue > > entries;
+      for (const std::pair< const int, std::string >& entry : model)
+      {
+        entries.emplace_back(entry.first, DataSetValue(entry.second));
+      }
+
+      std::shared_ptr< DataSet > result = std::make_shared< DataSet >(name);
+      result->assignSorted(entries.begin(), entries.end());
+
+      return result;
+    }
+
+    Model contentOf(const SetExpression& expression)
+    {
+      Model content;
+      expression.forEach([&content](int key, const DataSetValue& value) {
+        content.emplace(key, std::string(std::string_view(value)));
+      });
+
+      return content;
+    }
+
+    Model contentOf(const DataSet& value)
+    {
+      Model content;
+      for (auto i = value.cbegin(); i != value.cend(); ++i)
+      {
+        content.emplace(i->first, std::string(std::string_view(i->second)));
+      }
+
+      return content;
+    }
+
+    Model expected(Operation operation, const std::vector< Model >& operands)
+    {
+      Model result;
+      if (operation == Operation::Union)
+      {
+        for (const Model& operand : operands)
+        {
+          result.insert(operand.begin(), operand.end());
+        }
+        return result;
+      }
+
+      for (const std::pair< const int, std::string >& entry : operands[0])
+      {
+        size_t holders = 0;
+        for (size_t i = 1; i < operands.size(); i++)
+        {
+          holders += operands[i].count(entry.first);
+        }
+        if (operation == Operation::Intersect ? holders == operands.size() - 1 : holders == 0)
+        {
+          result.insert(entry);
+        }
+      }
+
+      return result;
+    }
+
+    void testDenseDataSet()
+    {
+      std::mt19937 random(360);
+      for (const Keys& keys : makeKeySets(random))
+      {
+        Model model = makeModel(keys, "v");
+        DenseHandle dense = DenseDataSet::fromDataSet(*makeTree(model, "dense"));
+
+        BAVYKIN_EXPECT(dense->size() == model.size());
+        BAVYKIN_EXPECT(sameKeys(dense->keys(), keys));
+        for (const std::pair< const int, std::string >& entry : model)
+        {
+          BAVYKIN_EXPECT(std::string_view(dense->values()[dense->keys().rank(entry.first)]) == entry.second);
+        }
+        BAVYKIN_EXPECT(contentOf(*dense->toDataSet("dense")) == model);
+      }
+    }
+
+    // The same operations over dense inputs, which run on the key bitmaps, and over tree inputs, which run the
+    // entry-by-entry merge, have to agree with each other and with std::map.
+    void testDenseAndTreeOperationsAgree()
+    {
+      std::mt19937 random(36000);
+      std::vector< Keys > sets = makeKeySets(random);
+      const std::string prefixes[] = { "a", "b", "c", "d" };
+      std::vector< Model > models;
+      std::vector< ExpressionHandle > dense;
+      std::vector< ExpressionHandle > trees;
+      for (size_t i = 0; i < sets.size(); i++)
+      {
+        models.push_back(makeModel(sets[i], prefixes[i]));
+        dense.push_back(SetExpression::fromDataSet(makeTree(models.back(), prefixes[i])));
+        trees.push_back(std::make_shared< const SetExpression >(makeTree(models.back(), prefixes[i])));
+        BAVYKIN_EXPECT(dense.back()->isDense());
+        BAVYKIN_EXPECT(!trees.back()->isDense());
+      }
+
+      const Operation operations[] = { Operation::Union, Operation::Intersect, Operation::Complement };
+      const std::vector< std::vector< size_t > > operandLists = { { 0, 1 }, { 1, 0 }, { 2, 3 }, { 0, 3 }, { 3, 1, 2 },
+        { 0, 1, 2, 3 } };
+      for (Operation operation : operations)
+      {
+        for (const std::vector< size_t >& list : operandLists)
+        {
+          std::vector< Model > operandModels;
+          std::vector< ExpressionHandle > denseOperands;
+          std::vector< ExpressionHandle > treeOperands;
+          std::vector< ExpressionHandle > mixedOperands;
+          for (size_t i = 0; i < list.size(); i++)
+          {
+            operandModels.push_back(models[list[i]]);
+            denseOperands.push_back(dense[list[i]]);
+            treeOperands.push_back(trees[list[i]]);
+            mixedOperands.push_back(i % 2 == 0 ? dense[list[i]] : trees[list[i]]);
+          }
+
+          Model model = expected(operation, operandModels);
+          ExpressionHandle denseResult = SetExpression::combine(operation, "out", denseOperands);
+          ExpressionHandle treeResult = SetExpression::combine(operation, "out", treeOperands);
+          ExpressionHandle mixedResult = SetExpression::combine(operation, "out", mixedOperands);
+          BAVYKIN_EXPECT(contentOf(*denseResult) == model);
+          BAVYKIN_EXPECT(contentOf(*treeResult) == model);
+          BAVYKIN_EXPECT(contentOf(*mixedResult) == model);
+          BAVYKIN_EXPECT(contentOf(*denseResult->materialize()) == model);
+          BAVYKIN_EXPECT(denseResult->size() == model.size());
+        }
+      }
+    }
+  }
+
+  void runDenseTests()
+  {
+    testBitmapQueries();
+    testBitmapOperations();
+    testDenseDataSet();
+    testDenseAndTreeOperationsAgree();
+  }
+}
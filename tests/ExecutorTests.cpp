@@ -0,0 +1,127 @@
+#include <sstream>
+#include <string>
+#include "CommandExecutor.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    enum class Mode
+    {
+      Serial,
+      Pipelined,
+      Parallel
+    };
+
+    const char DATASETS[] = "first 1 name 2 surname 3 city\n"
+                            "second 2 surname 4 mouse\n";
+
+    std::string runScript(Mode mode, const std::string& script)
+    {
+      std::ostringstream output;
+      {
+        CommandExecutor executor(output);
+        std::istringstream datasets(DATASETS);
+        executor.readFile(datasets);
+
+        std::istringstream commands(script);
+        if (mode == Mode::Serial)
+        {
+          executor.execute(commands);
+        }
+        else if (mode == Mode::Pipelined)
+        {
+          executor.executePipelined(commands);
+        }
+        else
+        {
+          executor.executeParallel(commands, 4);
+        }
+      }
+
+      return output.str();
+    }
+
+    size_t countLines(const std::string& text, const std::string& line)
+    {
+      size_t count = 0;
+      std::istringstream lines(text);
+      std::string current;
+      while (std::getline(lines, current))
+      {
+        count += current == line;
+      }
+
+      return count;
+    }
+
+    // Derive commands without enough operands used to crash the parallel planner, which stepped past the end of
+    // an empty argument list; every mode has to answer them, and everything else, the same way.
+    void testMalformedCommandsAgreeAcrossModes()
+    {
+      const std::string script = "union\n"
+                                 "intersect\n"
+                                 "complement\n"
+                                 "union out\n"
+                                 "union out first\n"
+                                 "intersect out first missing\n"
+                                 "print\n"
+                                 "print missing\n"
+                                 "union both first second\n"
+                                 "print both\n"
+                                 "intersect common first second\n"
+                                 "print common\n"
+                                 "complement rest first second\n"
+                                 "print rest\n";
+
+      std::string serial = runScript(Mode::Serial, script);
+      BAVYKIN_EXPECT(countLines(serial, "<INVALID COMMAND>") == 8);
+      BAVYKIN_EXPECT(countLines(serial, "both 1 name 2 surname 3 city 4 mouse") == 1);
+      BAVYKIN_EXPECT(countLines(serial, "common 2 surname") == 1);
+      BAVYKIN_EXPECT(countLines(serial, "rest 1 name 3 city") == 1);
+      BAVYKIN_EXPECT(runScript(Mode::Pipelined, script) == serial);
+      BAVYKIN_EXPECT(runScript(Mode::Parallel, script) == serial);
+    }
+
+    // A dense dataset is checked in the form it is stored in, not through a tree built for the check.
+    void testCheckReportsStorage()
+    {
+      std::string dense = "dense";
+      for (int key = -50; key < 50; key++)
+      {
+        dense += " " + std::to_string(key) + " value";
+      }
+
+      std::ostringstream output;
+      {
+        CommandExecutor executor(output);
+        std::istringstream datasets(dense + "\n" + DATASETS);
+        executor.readFile(datasets);
+        std::istringstream commands("check dense\n"
+                                    "check first\n"
+                                    "check missing\n");
+        executor.execute(commands);
+      }
+
+      std::istringstream lines(output.str());
+      std::string denseLine;
+      std::string treeLine;
+      std::string missingLine;
+      std::getline(lines, denseLine);
+      std::getline(lines, treeLine);
+      std::getline(lines, missingLine);
+      BAVYKIN_EXPECT(denseLine == "dense storage dense keys 100 values 100 containers 2 bitmap-containers 0 "
+                                  "count-mismatches 0 order-violations 0 valid");
+      BAVYKIN_EXPECT(treeLine.compare(0, 33, "first storage tree nodes 3 height") == 0);
+      BAVYKIN_EXPECT(missingLine == "<INVALID COMMAND>");
+    }
+  }
+
+  void runExecutorTests()
+  {
+    testMalformedCommandsAgreeAcrossModes();
+    testCheckReportsStorage();
+  }
+}
@@ -0,0 +1,106 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FlatStringMap.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    // Same FNV-1a hash as FlatStringMap, so the test can choose keys that land on the same slot.
+    uint64_t fnv1a(const std::string& key)
+    {
+      uint64_t result = 14695981039346656037ull;
+      for (unsigned char symbol : key)
+      {
+        result ^= symbol;
+        result *= 1099511628211ull;
+      }
+
+      return result;
+    }
+
+    // Returns count keys whose hashes share the low 12 bits, so they probe the same chain at every table size up
+    // to 4096 slots, plus one more such key that is never inserted.
+    std::vector< std::string > collidingKeys(size_t count)
+    {
+      std::vector< std::string > keys;
+      const uint64_t bucket = fnv1a("key0") & 0xfff;
+      for (int i = 0; keys.size() <= count; i++)
+      {
+        std::string key = "key" + std::to_string(i);
+        if ((fnv1a(key) & 0xfff) == bucket)
+        {
+          keys.push_back(key);
+        }
+      }
+
+      return keys;
+    }
+
+    void testCollidingKeys()
+    {
+      std::vector< std::string > keys = collidingKeys(6);
+      const std::string absent = keys.back();
+      keys.pop_back();
+
+      FlatStringMap< int > map;
+      for (size_t i = 0; i < keys.size(); i++)
+      {
+        map.insert(keys[i], static_cast< int >(i));
+      }
+
+      BAVYKIN_EXPECT(map.size() == keys.size());
+      for (size_t i = 0; i < keys.size(); i++)
+      {
+        const int* found = map.find(keys[i]);
+        BAVYKIN_EXPECT(found != nullptr && *found == static_cast< int >(i));
+      }
+      BAVYKIN_EXPECT(map.find(absent) == nullptr);
+
+      map.insert(keys[2], 42);
+      BAVYKIN_EXPECT(map.size() == keys.size());
+      BAVYKIN_EXPECT(*map.find(keys[2]) == 42);
+      BAVYKIN_EXPECT(*map.find(keys[3]) == 3);
+    }
+
+    void testCollidingKeysAcrossGrowth()
+    {
+      std::vector< std::string > keys = collidingKeys(20);
+      const std::string absent = keys.back();
+      keys.pop_back();
+
+      FlatStringMap< int > map;
+      for (int i = 0; i < 500; i++)
+      {
+        map.insert("other" + std::to_string(i), -i);
+        if (i % 25 == 0)
+        {
+          map.insert(keys[i / 25], i);
+        }
+      }
+
+      BAVYKIN_EXPECT(map.size() == 500 + keys.size());
+      for (size_t i = 0; i < keys.size(); i++)
+      {
+        const int* found = map.find(keys[i]);
+        BAVYKIN_EXPECT(found != nullptr && *found == static_cast< int >(i * 25));
+      }
+      for (int i = 0; i < 500; i++)
+      {
+        const int* found = map.find("other" + std::to_string(i));
+        BAVYKIN_EXPECT(found != nullptr && *found == -i);
+      }
+      BAVYKIN_EXPECT(map.find(absent) == nullptr);
+      BAVYKIN_EXPECT(map.find("") == nullptr);
+    }
+  }
+
+  void runFlatStringMapTests()
+  {
+    testCollidingKeys();
+    testCollidingKeysAcrossGrowth();
+  }
+}
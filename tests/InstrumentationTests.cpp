@@ -0,0 +1,78 @@
+#include <cstdint>
+#include "Instrumentation.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    // Nearest rank puts the high percentiles of a few samples on the largest one.
+    void testPercentilesOfFewSamples()
+    {
+      instrumentation::LatencyHistogram histogram;
+      histogram.record(100);
+      histogram.record(200000);
+
+      BAVYKIN_EXPECT(histogram.percentile(0.5) < 200);
+      BAVYKIN_EXPECT(histogram.percentile(0.99) == 200000);
+      BAVYKIN_EXPECT(histogram.percentile(1.0) == 200000);
+    }
+
+    // Values below 32 have buckets of their own, so these percentiles are exact: the p-th percentile of n samples is
+    // the sample of rank ceil(p * n), and at least the first.
+    void testNearestRankBoundaries()
+    {
+      instrumentation::LatencyHistogram histogram;
+      BAVYKIN_EXPECT(histogram.percentile(0.5) == 0);
+
+      for (uint64_t value = 1; value <= 4; value++)
+      {
+        histogram.record(value);
+      }
+      BAVYKIN_EXPECT(histogram.percentile(0.0) == 1);
+      BAVYKIN_EXPECT(histogram.percentile(0.25) == 1);
+      BAVYKIN_EXPECT(histogram.percentile(0.26) == 2);
+      BAVYKIN_EXPECT(histogram.percentile(0.5) == 2);
+      BAVYKIN_EXPECT(histogram.percentile(0.51) == 3);
+      BAVYKIN_EXPECT(histogram.percentile(0.75) == 3);
+      BAVYKIN_EXPECT(histogram.percentile(0.76) == 4);
+
+      instrumentation::LatencyHistogram repeated;
+      for (int i = 0; i < 7; i++)
+      {
+        repeated.record(5);
+      }
+      for (int i = 0; i < 3; i++)
+      {
+        repeated.record(20);
+      }
+      BAVYKIN_EXPECT(repeated.percentile(0.7) == 5);
+      BAVYKIN_EXPECT(repeated.percentile(0.71) == 20);
+      BAVYKIN_EXPECT(repeated.percentile(0.99) == 20);
+    }
+
+    // Buckets are within 6.25% of the values they hold.
+    void testPercentilesOfUniformSamples()
+    {
+      instrumentation::LatencyHistogram histogram;
+      for (uint64_t value = 1; value <= 1000; value++)
+      {
+        histogram.record(value);
+      }
+
+      BAVYKIN_EXPECT(histogram.count() == 1000);
+      BAVYKIN_EXPECT(histogram.percentile(0.0) == 1);
+      BAVYKIN_EXPECT(histogram.percentile(0.5) >= 500 && histogram.percentile(0.5) <= 532);
+      BAVYKIN_EXPECT(histogram.percentile(0.99) >= 990 && histogram.percentile(0.99) <= 1000);
+      BAVYKIN_EXPECT(histogram.percentile(1.0) == 1000);
+    }
+  }
+
+  void runInstrumentationTests()
+  {
+    testPercentilesOfFewSamples();
+    testNearestRankBoundaries();
+    testPercentilesOfUniformSamples();
+  }
+}
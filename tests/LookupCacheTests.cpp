@@ -0,0 +1,186 @@
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "BinarySearchTree.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    using Tree = BST< int, int >;
+
+    Tree filledTree(int count)
+    {
+      Tree tree;
+      for (int key = 0; key < count; key++)
+      {
+        tree.insert(std::make_pair(key, key * 10));
+      }
+
+      return tree;
+    }
+
+    void testHitAfterMiss()
+    {
+      Tree tree = filledTree(100);
+      tree.resizeLookupCache(64);
+      BAVYKIN_EXPECT(tree.lookupStatistics().m_Slots == 64);
+
+      BAVYKIN_EXPECT(tree.find(42)->second == 420);
+      BAVYKIN_EXPECT(tree.lookupStatistics().m_Misses == 1);
+      BAVYKIN_EXPECT(tree.find(42)->second == 420);
+      BAVYKIN_EXPECT(tree.lookupStatistics().m_Hits == 1);
+
+      tree.resizeLookupCache(0);
+      BAVYKIN_EXPECT(tree.find(42)->second == 420);
+      BAVYKIN_EXPECT(tree.lookupStatistics().m_Slots == 0 && tree.lookupStatistics().m_Hits == 0);
+    }
+
+    // An erased key must not be found through its slot, and a key inserted again is a new node, which a find then
+    // caches and hits with its new value.
+    void testEraseAndReinsert()
+    {
+      Tree tree = filledTree(100);
+      tree.resizeLookupCache(64);
+      BAVYKIN_EXPECT(tree.find(7) != tree.end());
+      BAVYKIN_EXPECT(tree.find(8) != tree.end());
+
+      tree.erase(7);
+      tree.erase(tree.find(8));
+      Tree::LookupStatistics beforeFinds = tree.lookupStatistics();
+      BAVYKIN_EXPECT(tree.find(7) == tree.end());
+      BAVYKIN_EXPECT(tree.find(8) == tree.end());
+      BAVYKIN_EXPECT(tree.lookupStatistics().m_Hits == beforeFinds.m_Hits);
+
+      tree.insert(std::make_pair(7, 700));
+      tree.insert(tree.end(), std::make_pair(8, 800));
+      BAVYKIN_EXPECT(tree.find(7)->second == 700);
+      BAVYKIN_EXPECT(tree.find(8)->second == 800);
+      Tree::LookupStatistics beforeHits = tree.lookupStatistics();
+      BAVYKIN_EXPECT(tree.find(7)->second == 700);
+      BAVYKIN_EXPECT(tree.find(8)->second == 800);
+      BAVYKIN_EXPECT(tree.lookupStatistics().m_Hits == beforeHits.m_Hits + 2);
+
+      tree.insert(std::make_pair(7, 7000));
+      BAVYKIN_EXPECT(tree.find(7)->second == 7000);
+      BAVYKIN_EXPECT(tree.validate());
+    }
+
+    // Whatever replaces the nodes must also empty the slots that pointed to them.
+    void testWholesaleChanges()
+    {
+      Tree tree = filledTree(100);
+      tree.resizeLookupCache(64);
+      BAVYKIN_EXPECT(tree.find(3) != tree.end());
+
+      tree.clear();
+      BAVYKIN_EXPECT(tree.find(3) == tree.end());
+
+      std::vector< std::pair< int, int > > sorted = { { 1, 1 }, { 3, 33 }, { 5, 5 } };
+      tree.insert(std::make_pair(3, 3));
+      BAVYKIN_EXPECT(tree.find(3)->second == 3);
+      tree.assignSorted(sorted.begin(), sorted.end());
+      BAVYKIN_EXPECT(tree.find(3)->second == 33);
+
+      std::vector< std::pair< int, int > > batch = { { 3, 333 }, { 4, 4 } };
+      tree.insertBatch(batch.begin(), batch.end(), Tree::BatchStrategy::Rebuild);
+      BAVYKIN_EXPECT(tree.find(3)->second == 333);
+
+      Tree copy(tree);
+      BAVYKIN_EXPECT(copy.lookupStatistics().m_Slots == 64);
+      copy.find(3)->second = -3;
+      BAVYKIN_EXPECT(tree.find(3)->second == 333);
+      BAVYKIN_EXPECT(copy.find(3)->second == -3);
+
+      Tree moved(std::move(copy));
+      BAVYKIN_EXPECT(moved.find(3)->second == -3);
+      copy = tree;
+      BAVYKIN_EXPECT(copy.find(3)->second == 333);
+    }
+
+    // A two-slot cache makes keys evict each other constantly, against std::map as the model.
+    void testRandomized()
+    {
+      for (uint32_t seed = 0; seed < 20; seed++)
+      {
+        std::mt19937 random(seed);
+        Tree tree;
+        tree.resizeLookupCache(2);
+        std::map< int, int > model;
+        for (int operation = 0; operation < 2000; operation++)
+        {
+          int key = static_cast< int >(random() % 64);
+          switch (random() % 6)
+          {
+          case 0:
+            tree.insert(std::make_pair(key, operation));
+            model[key] = operation;
+            break;
+          case 1:
+            tree.erase(key);
+            model.erase(key);
+            break;
+          case 2:
+          {
+            std::vector< std::pair< int, int > > batch = { { key, operation }, { key / 2, operation } };
+            tree.insertBatch(batch.begin(), batch.end(), static_cast< Tree::BatchStrategy >(random() % 3));
+            model[key] = operation;
+            model[key / 2] = operation;
+            break;
+          }
+          default:
+          {
+            Tree::iterator found = tree.find(key);
+            std::map< int, int >::const_iterator expected = model.find(key);
+            BAVYKIN_EXPECT((found == tree.end()) == (expected == model.cend()));
+            BAVYKIN_EXPECT(found == tree.end() || found->second == expected->second);
+            break;
+          }
+          }
+        }
+        Tree::LookupStatistics statistics = tree.lookupStatistics();
+        BAVYKIN_EXPECT(statistics.m_Hits != 0 && statistics.m_Misses != 0);
+      }
+    }
+
+    struct Unhashable
+    {
+      int m_Value;
+
+      bool operator<(const Unhashable& right) const
+      {
+        return m_Value < right.m_Value;
+      }
+    };
+
+    void testUnhashableKey()
+    {
+      BST< Unhashable, int > tree;
+      tree.resizeLookupCache(0);
+      bool thrown = false;
+      try
+      {
+        tree.resizeLookupCache(16);
+      }
+      catch (const std::logic_error&)
+      {
+        thrown = true;
+      }
+      BAVYKIN_EXPECT(thrown);
+    }
+  }
+
+  void runLookupCacheTests()
+  {
+    testHitAfterMiss();
+    testEraseAndReinsert();
+    testWholesaleChanges();
+    testRandomized();
+    testUnhashableKey();
+  }
+}
@@ -0,0 +1,117 @@
+#include <sstream>
+#include <string>
+#include <vector>
+#include "CommandExecutor.h"
+#include "ResultCache.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    const SetExpression::Operation UNION = SetExpression::Operation::Union;
+
+    bool hits(ResultCache& cache, const std::vector< uint64_t >& inputs, uint64_t version)
+    {
+      ResultCache::Result result = { nullptr, 0 };
+      return cache.find(UNION, inputs, result) && result.m_Version == version;
+    }
+
+    void testHitAndEviction()
+    {
+      ResultCache cache(2);
+      cache.insert(UNION, { 1, 2 }, ResultCache::Result{ nullptr, 10 });
+      cache.insert(UNION, { 3, 4 }, ResultCache::Result{ nullptr, 11 });
+
+      BAVYKIN_EXPECT(hits(cache, { 1, 2 }, 10));
+      BAVYKIN_EXPECT(!hits(cache, { 2, 1 }, 10));
+      ResultCache::Result ignored = { nullptr, 0 };
+      BAVYKIN_EXPECT(!cache.find(SetExpression::Operation::Intersect, { 1, 2 }, ignored));
+
+      // { 1, 2 } was used last, so { 3, 4 } is the least recently used entry.
+      cache.insert(UNION, { 5, 6 }, ResultCache::Result{ nullptr, 12 });
+      BAVYKIN_EXPECT(!hits(cache, { 3, 4 }, 11));
+      BAVYKIN_EXPECT(hits(cache, { 1, 2 }, 10));
+      BAVYKIN_EXPECT(hits(cache, { 5, 6 }, 12));
+
+      ResultCache::Statistics statistics = cache.statistics();
+      BAVYKIN_EXPECT(statistics.m_Hits == 3);
+      BAVYKIN_EXPECT(statistics.m_Misses == 3);
+      BAVYKIN_EXPECT(statistics.m_Evictions == 1);
+      BAVYKIN_EXPECT(statistics.m_Entries == 2);
+
+      cache.insert(UNION, { 5, 6 }, ResultCache::Result{ nullptr, 13 });
+      BAVYKIN_EXPECT(hits(cache, { 5, 6 }, 13));
+      BAVYKIN_EXPECT(cache.statistics().m_Entries == 2);
+
+      cache.clear();
+      BAVYKIN_EXPECT(!hits(cache, { 1, 2 }, 10));
+      BAVYKIN_EXPECT(cache.statistics().m_Entries == 0);
+
+      ResultCache disabled(0);
+      disabled.insert(UNION, { 1, 2 }, ResultCache::Result{ nullptr, 10 });
+      BAVYKIN_EXPECT(!hits(disabled, { 1, 2 }, 10));
+    }
+
+    // stats lines that describe something other than the result cache; they depend on the build, on timing and on
+    // how often the executor looks datasets up.
+    const std::string OTHER_STATISTICS[] = { "lookup-cache ", "latency ", "tree " };
+
+    // Runs the script and keeps every output line but those of other statistics.
+    std::string run(const std::string& script)
+    {
+      std::ostringstream output;
+      {
+        CommandExecutor executor(output);
+        std::istringstream datasets("a 1 x 2 y\nb 2 z 3 w\n");
+        executor.readFile(datasets);
+        std::istringstream commands(script);
+        executor.execute(commands);
+      }
+
+      std::string kept;
+      std::istringstream lines(output.str());
+      std::string line;
+      while (std::getline(lines, line))
+      {
+        bool other = false;
+        for (const std::string& prefix : OTHER_STATISTICS)
+        {
+          other = other || line.compare(0, prefix.size(), prefix) == 0;
+        }
+        if (!other)
+        {
+          kept += line + "\n";
+        }
+      }
+
+      return kept;
+    }
+
+    // A repeated command hits the cache, and redefining one of its inputs makes the same command miss and see the
+    // new value.
+    void testRedefinedInputInvalidates()
+    {
+      std::string output = run("union c a b\n"
+                               "union d a b\n"
+                               "print d\n"
+                               "stats\n"
+                               "complement a a b\n"
+                               "union c a b\n"
+                               "print c\n"
+                               "stats\n");
+
+      BAVYKIN_EXPECT(output == "d 1 x 2 y 3 w\n"
+                               "result-cache hits 1 misses 1 evictions 0 entries 1\n"
+                               "c 1 x 2 z 3 w\n"
+                               "result-cache hits 1 misses 3 evictions 0 entries 3\n");
+    }
+  }
+
+  void runResultCacheTests()
+  {
+    testHitAndEviction();
+    testRedefinedInputInvalidates();
+  }
+}
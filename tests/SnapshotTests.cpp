@@ -0,0 +1,209 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Snapshot.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    const char SNAPSHOT_PATH[] = "snapshot-test.bin";
+
+    // Offsets into the layout described in Snapshot.h: a 32-byte header, then 40-byte table entries whose fourth
+    // field is the offset of the dictionary's keys.
+    const size_t HEADER_SIZE = 32;
+    const size_t TABLE_ENTRY_SIZE = 40;
+    const size_t KEYS_OFFSET_FIELD = 24;
+
+    using Entries = std::vector< std::pair< int, std::string > >;
+
+    DataSetHandle makeDictionary(const std::string& name, Entries entries)
+    {
+      std::vector< std::pair< int, DataSetValue > > values;
+      for (const std::pair< int, std::string >& entry : entries)
+      {
+        values.emplace_back(entry.first, DataSetValue(entry.second));
+      }
+
+      std::shared_ptr< DataSet > result = std::make_shared< DataSet >(name);
+      result->assignSorted(values.begin(), values.end());
+
+      return result;
+    }
+
+    DataSets makeDataSets()
+    {
+      Entries large;
+      for (int key = -500; key < 500; key += 3)
+      {
+        large.emplace_back(key, "value " + std::to_string(key));
+      }
+
+      std::vector< std::pair< std::string, DataSetHandle > > named;
+      named.emplace_back("empty", makeDictionary("empty", {}));
+      named.emplace_back("large", makeDictionary("large", large));
+      named.emplace_back("small", makeDictionary("small", { { INT32_MIN, "" }, { 0, "zero" }, { INT32_MAX, "a b" } }));
+
+      DataSets dataSets;
+      dataSets.assignSorted(named.begin(), named.end());
+
+      return dataSets;
+    }
+
+    template < class Dict >
+    std::vector< std::pair< int, std::string > > entriesOf(const Dict& value)
+    {
+      std::vector< std::pair< int, std::string > > entries;
+      for (auto i = value.cbegin(); i != value.cend(); ++i)
+      {
+        entries.emplace_back(i->first, std::string(std::string_view(i->second)));
+      }
+
+      return entries;
+    }
+
+    std::vector< char > readFile(const std::string& path)
+    {
+      std::ifstream in(path, std::ios::binary);
+      return std::vector< char >(std::istreambuf_iterator< char >(in), std::istreambuf_iterator< char >());
+    }
+
+    void writeFile(const std::string& path, const std::vector< char >& bytes, size_t length)
+    {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out.write(bytes.data(), static_cast< std::streamsize >(length));
+    }
+
+    template < class T >
+    void patch(std::vector< char >& bytes, size_t offset, T value)
+    {
+      std::memcpy(bytes.data() + offset, &value, sizeof(T));
+    }
+
+    template < class T >
+    T peek(const std::vector< char >& bytes, size_t offset)
+    {
+      T value;
+      std::memcpy(&value, bytes.data() + offset, sizeof(T));
+      return value;
+    }
+
+    // Loads bytes as a snapshot and returns the error it was rejected with, or an empty string if it loaded.
+    std::string loadError(const std::vector< char >& bytes, size_t length)
+    {
+      writeFile(SNAPSHOT_PATH, bytes, length);
+      try
+      {
+        loadSnapshot(SNAPSHOT_PATH);
+      }
+      catch (const std::runtime_error& error)
+      {
+        return error.what();
+      }
+
+      return "";
+    }
+
+    void testRoundTrip()
+    {
+      DataSets saved = makeDataSets();
+      saveSnapshot(SNAPSHOT_PATH, saved);
+      DataSets loaded = loadSnapshot(SNAPSHOT_PATH);
+
+      BAVYKIN_EXPECT(loaded.size() == saved.size());
+      for (auto i = saved.cbegin(), j = loaded.cbegin(); i != saved.cend(); ++i, ++j)
+      {
+        BAVYKIN_EXPECT(j != loaded.cend());
+        BAVYKIN_EXPECT(i->first == j->first);
+        BAVYKIN_EXPECT(entriesOf(*i->second) == entriesOf(*j->second));
+      }
+      BAVYKIN_EXPECT(loaded.contains("large"));
+      const DataSet& large = *loaded.find("large")->second;
+      BAVYKIN_EXPECT(large.contains(-500) && !large.contains(-499));
+
+      saveSnapshot(SNAPSHOT_PATH, DataSets());
+      BAVYKIN_EXPECT(loadSnapshot(SNAPSHOT_PATH).size() == 0);
+    }
+
+    // The string heap ends the file, so every proper prefix is short of it.
+    void testTruncated()
+    {
+      saveSnapshot(SNAPSHOT_PATH, makeDataSets());
+      std::vector< char > bytes = readFile(SNAPSHOT_PATH);
+      for (size_t length = 0; length < bytes.size(); length++)
+      {
+        BAVYKIN_EXPECT(loadError(bytes, length) == "The snapshot file is truncated.");
+      }
+    }
+
+    void testCorrupted()
+    {
+      saveSnapshot(SNAPSHOT_PATH, makeDataSets());
+      const std::vector< char > bytes = readFile(SNAPSHOT_PATH);
+      size_t largeEntry = HEADER_SIZE + TABLE_ENTRY_SIZE;
+      size_t largeKeys = static_cast< size_t >(peek< uint64_t >(bytes, largeEntry + KEYS_OFFSET_FIELD));
+
+      std::vector< char > unsortedKeys = bytes;
+      patch(unsortedKeys, largeKeys + sizeof(int32_t), peek< int32_t >(bytes, largeKeys));
+      BAVYKIN_EXPECT(loadError(unsortedKeys, unsortedKeys.size()) == "The snapshot file is corrupted.");
+
+      std::vector< char > nameOutsideHeap = bytes;
+      patch(nameOutsideHeap, largeEntry, uint64_t(1) << 40);
+      BAVYKIN_EXPECT(loadError(nameOutsideHeap, nameOutsideHeap.size()) == "The snapshot file is corrupted.");
+
+      std::vector< char > unsortedNames = bytes;
+      patch(unsortedNames, HEADER_SIZE, peek< uint64_t >(bytes, largeEntry));
+      patch(unsortedNames, HEADER_SIZE + sizeof(uint64_t), peek< uint64_t >(bytes, largeEntry + sizeof(uint64_t)));
+      BAVYKIN_EXPECT(loadError(unsortedNames, unsortedNames.size()) == "The snapshot file is corrupted.");
+
+      std::vector< char > keysOutsideFile = bytes;
+      patch(keysOutsideFile, largeEntry + KEYS_OFFSET_FIELD, uint64_t(bytes.size()));
+      BAVYKIN_EXPECT(loadError(keysOutsideFile, keysOutsideFile.size()) == "The snapshot file is truncated.");
+    }
+
+    void testWrongMagicAndVersion()
+    {
+      saveSnapshot(SNAPSHOT_PATH, makeDataSets());
+      const std::vector< char > bytes = readFile(SNAPSHOT_PATH);
+
+      std::vector< char > wrongMagic = bytes;
+      wrongMagic[0] = 'X';
+      BAVYKIN_EXPECT(loadError(wrongMagic, wrongMagic.size()) == "The file is not a supported snapshot.");
+
+      std::vector< char > wrongVersion = bytes;
+      patch(wrongVersion, 4, peek< uint32_t >(bytes, 4) + 1);
+      BAVYKIN_EXPECT(loadError(wrongVersion, wrongVersion.size()) == "The file is not a supported snapshot.");
+
+      std::remove(SNAPSHOT_PATH);
+      bool thrown = false;
+      try
+      {
+        loadSnapshot(SNAPSHOT_PATH);
+      }
+      catch (const std::runtime_error&)
+      {
+        thrown = true;
+      }
+      BAVYKIN_EXPECT(thrown);
+    }
+  }
+
+  void runSnapshotTests()
+  {
+    testRoundTrip();
+    testTruncated();
+    testCorrupted();
+    testWrongMagicAndVersion();
+    std::remove(SNAPSHOT_PATH);
+  }
+}
@@ -0,0 +1,69 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include "StringPool.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    // Enough distinct strings to fill more than one id block, and long enough ones to need several arena chunks.
+    const int SHORT_COUNT = 70000;
+    const int LONG_COUNT = 8;
+    const size_t LONG_SIZE = 100000;
+
+    void testIdsSurviveGrowth()
+    {
+      StringPool& pool = StringPool::instance();
+      BAVYKIN_EXPECT(pool.intern("") == 0);
+      BAVYKIN_EXPECT(pool.view(0).empty());
+
+      std::vector< std::string > texts;
+      for (int i = 0; i < SHORT_COUNT; i++)
+      {
+        texts.push_back("string-pool-test " + std::to_string(i));
+        if (i % (SHORT_COUNT / LONG_COUNT) == 0)
+        {
+          texts.push_back(std::string(LONG_SIZE, static_cast< char >('a' + i % 26)) + std::to_string(i));
+        }
+      }
+
+      std::vector< uint32_t > ids;
+      std::vector< const char* > addresses;
+      for (const std::string& text : texts)
+      {
+        ids.push_back(pool.intern(text));
+        addresses.push_back(pool.view(ids.back()).data());
+      }
+
+      BAVYKIN_EXPECT(pool.size() > texts.size());
+      for (size_t i = 0; i < texts.size(); i++)
+      {
+        BAVYKIN_EXPECT(pool.intern(texts[i]) == ids[i]);
+        BAVYKIN_EXPECT(pool.view(ids[i]) == texts[i]);
+        BAVYKIN_EXPECT(pool.view(ids[i]).data() == addresses[i]);
+      }
+    }
+
+    void testInternedString()
+    {
+      InternedString empty;
+      InternedString first(std::string("string-pool-test value"));
+      InternedString second(std::string_view("string-pool-test value"));
+      InternedString other(std::string("string-pool-test other"));
+
+      BAVYKIN_EXPECT(empty.id() == 0 && empty.view().empty());
+      BAVYKIN_EXPECT(first == second && first.id() == second.id());
+      BAVYKIN_EXPECT(first != other);
+      BAVYKIN_EXPECT(static_cast< std::string_view >(first) == "string-pool-test value");
+    }
+  }
+
+  void runStringPoolTests()
+  {
+    testIdsSurviveGrowth();
+    testInternedString();
+  }
+}
@@ -0,0 +1,25 @@
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+#include <stdexcept>
+#include <string>
+
+// Checks a condition inside a test and fails the test, by throwing TestFailure, with the condition's text and place.
+#define BAVYKIN_EXPECT(condition) ::bavykin::expect((condition), #condition, __FILE__, __LINE__)
+
+namespace bavykin
+{
+  class TestFailure: public std::runtime_error
+  {
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+  inline void expect(bool condition, const char* text, const char* file, int line)
+  {
+    if (!condition)
+    {
+      throw TestFailure(std::string(file) + ":" + std::to_string(line) + ": expected " + text);
+    }
+  }
+}
+#endif
@@ -0,0 +1,21 @@
+#ifndef TESTS_H
+#define TESTS_H
+
+namespace bavykin
+{
+  void runTreeTests();
+  void runTreeFuzzTests();
+  void runSnapshotTests();
+  void runThreadPoolTests();
+  void runFlatStringMapTests();
+  void runResultCacheTests();
+  void runExecutorTests();
+  void runStringPoolTests();
+  void runDenseTests();
+  void runInstrumentationTests();
+  void runConcurrentSkipListTests();
+  void runThreeWayCompareTests();
+  void runLookupCacheTests();
+  void runBloomFilterTests();
+}
+#endif
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "TestUtils.h"
+#include "Tests.h"
+#include "ThreadPool.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    void testWaitCoversNestedTasks()
+    {
+      ThreadPool pool(4);
+      pool.wait();
+
+      std::atomic< int > finished(0);
+      for (int i = 0; i < 100; i++)
+      {
+        pool.submit([&pool, &finished]() {
+          for (int j = 0; j < 10; j++)
+          {
+            pool.submit([&finished]() {
+              std::this_thread::sleep_for(std::chrono::microseconds(50));
+              finished++;
+            });
+          }
+          finished++;
+        });
+      }
+
+      pool.wait();
+      BAVYKIN_EXPECT(finished == 1100);
+
+      pool.submit([&finished]() {
+        finished++;
+      });
+      pool.wait();
+      BAVYKIN_EXPECT(finished == 1101);
+    }
+
+    // The parent task keeps its worker busy until one of the tasks it queued on that worker's own deque has run, so
+    // the only way for the children to run is for the other worker to steal them.
+    void testIdleWorkerSteals()
+    {
+      ThreadPool pool(2);
+      std::atomic< bool > stolen(false);
+      std::atomic< int > finished(0);
+
+      pool.submit([&pool, &stolen, &finished]() {
+        std::thread::id parent = std::this_thread::get_id();
+        for (int i = 0; i < 8; i++)
+        {
+          pool.submit([parent, &stolen, &finished]() {
+            if (std::this_thread::get_id() != parent)
+            {
+              stolen = true;
+            }
+            finished++;
+          });
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!stolen && std::chrono::steady_clock::now() < deadline)
+        {
+          std::this_thread::yield();
+        }
+      });
+
+      pool.wait();
+      BAVYKIN_EXPECT(stolen);
+      BAVYKIN_EXPECT(finished == 8);
+    }
+
+    void testZeroThreadsMeansOne()
+    {
+      ThreadPool pool(0);
+      BAVYKIN_EXPECT(pool.threadCount() == 1);
+
+      int finished = 0;
+      pool.submit([&finished]() {
+        finished++;
+      });
+      pool.wait();
+      BAVYKIN_EXPECT(finished == 1);
+    }
+  }
+
+  void runThreadPoolTests()
+  {
+    testWaitCoversNestedTasks();
+    testIdleWorkerSteals();
+    testZeroThreadsMeansOne();
+  }
+}
@@ -0,0 +1,160 @@
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BinarySearchTree.h"
+#include "TestUtils.h"
+#include "Tests.h"
+#include "ThreeWayCompare.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    // Descending order, with a compare member that must agree with the operator.
+    struct Descending
+    {
+      bool operator()(int left, int right) const
+      {
+        return left > right;
+      }
+
+      int compare(int left, int right) const
+      {
+        return left > right ? -1 : left < right ? 1 : 0;
+      }
+    };
+
+    // The same order as std::less< std::string >, but only as a less-than operator.
+    struct LessThanOnly
+    {
+      bool operator()(const std::string& left, const std::string& right) const
+      {
+        return left < right;
+      }
+    };
+
+    static_assert(ThreeWayCompare< std::less< std::string >, std::string >::IS_NATIVE, "string less is three-way");
+    static_assert(ThreeWayCompare< std::less<>, std::string >::IS_NATIVE, "transparent string less is three-way");
+    static_assert(ThreeWayCompare< Descending, int >::IS_NATIVE, "a compare member is used");
+    static_assert(!ThreeWayCompare< LessThanOnly, std::string >::IS_NATIVE, "a bare operator is asked twice");
+    static_assert(ThreeWayCompare< Descending, int >::CALLS == 1, "a native compare is one call");
+    static_assert(ThreeWayCompare< LessThanOnly, std::string >::CALLS == 2, "a fallback compare is two calls");
+#ifdef BAVYKIN_HAS_THREE_WAY_COMPARISON
+    static_assert(ThreeWayCompare< std::less< int >, int >::IS_NATIVE, "less over a <=> type is three-way");
+    static_assert(ThreeWayCompare< std::compare_three_way, int >::IS_NATIVE, "orderings are three-way");
+#else
+    static_assert(!ThreeWayCompare< std::less< int >, int >::IS_NATIVE, "less over int is asked twice");
+#endif
+
+    int sign(int value)
+    {
+      return value < 0 ? -1 : value > 0 ? 1 : 0;
+    }
+
+    template < class Compare, class Key >
+    void expectConsistent(const Key& left, const Key& right)
+    {
+      using Adapter = ThreeWayCompare< Compare, Key >;
+      Compare comp;
+      int expected = comp(left, right) ? -1 : comp(right, left) ? 1 : 0;
+      BAVYKIN_EXPECT(sign(Adapter::compare(comp, left, right)) == expected);
+      BAVYKIN_EXPECT(Adapter::isLess(comp, left, right) == (expected < 0));
+    }
+
+    void testCompareAgreesWithLess()
+    {
+      const std::string strings[] = { "", "a", "ab", "abc", "abd", "b", "key-prefix-10", "key-prefix-9" };
+      for (const std::string& left : strings)
+      {
+        for (const std::string& right : strings)
+        {
+          expectConsistent< std::less< std::string > >(left, right);
+          expectConsistent< std::less<> >(left, right);
+          expectConsistent< LessThanOnly >(left, right);
+        }
+      }
+      for (int left = -2; left <= 2; left++)
+      {
+        for (int right = -2; right <= 2; right++)
+        {
+          expectConsistent< Descending >(left, right);
+          expectConsistent< std::less< int > >(left, right);
+        }
+      }
+    }
+
+    // Random inserts, erases, finds and a batch merge against std::map with the same comparator, so that a compare
+    // whose sign disagreed with the comparator's order would misplace keys or miss them. The model takes a less-than
+    // comparator of the same order when the tree's returns an ordering.
+    template < class Compare, class Key, class ModelCompare = Compare, class Generate >
+    void checkTree(Generate generate)
+    {
+      std::mt19937 random(5);
+      BST< Key, int, Compare > tree;
+      std::map< Key, int, ModelCompare > model;
+      for (int i = 0; i < 20000; i++)
+      {
+        Key key = generate(random);
+        switch (random() % 3)
+        {
+        case 0:
+          tree.insert(std::make_pair(key, i));
+          model[key] = i;
+          break;
+        case 1:
+          tree.erase(key);
+          model.erase(key);
+          break;
+        default:
+          BAVYKIN_EXPECT((tree.find(key) != tree.end()) == (model.count(key) != 0));
+          break;
+        }
+      }
+
+      std::vector< std::pair< Key, int > > batch;
+      for (int i = 0; i < 3000; i++)
+      {
+        batch.emplace_back(generate(random), i);
+        model[batch.back().first] = i;
+      }
+      tree.insertBatch(batch.begin(), batch.end());
+
+      BAVYKIN_EXPECT(tree.validate());
+      BAVYKIN_EXPECT(tree.size() == model.size());
+      typename std::map< Key, int, ModelCompare >::const_iterator expected = model.cbegin();
+      for (typename BST< Key, int, Compare >::iterator i = tree.begin(); i != tree.end(); ++i, ++expected)
+      {
+        BAVYKIN_EXPECT(i->first == expected->first && i->second == expected->second);
+      }
+    }
+
+    void testTrees()
+    {
+      auto string = [](std::mt19937& random)
+      {
+        return "key-prefix-" + std::to_string(random() % 3000);
+      };
+      auto number = [](std::mt19937& random)
+      {
+        return static_cast< int >(random() % 3000);
+      };
+
+      checkTree< std::less< std::string >, std::string >(string);
+      checkTree< std::less<>, std::string >(string);
+      checkTree< LessThanOnly, std::string >(string);
+      checkTree< Descending, int >(number);
+#ifdef BAVYKIN_HAS_THREE_WAY_COMPARISON
+      checkTree< std::compare_three_way, int, std::less< int > >(number);
+#endif
+    }
+  }
+
+  void runThreeWayCompareTests()
+  {
+    testCompareAgreesWithLess();
+    testTrees();
+  }
+}
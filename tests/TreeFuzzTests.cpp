@@ -0,0 +1,140 @@
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+#include "BinarySearchTree.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    const uint32_t SEEDS = 60;
+    const int OPERATIONS = 400;
+
+    template < class Tree >
+    void expectSameEntries(Tree& tree, const std::map< int, int >& model)
+    {
+      BAVYKIN_EXPECT(tree.size() == model.size());
+      std::map< int, int >::const_iterator expected = model.cbegin();
+      for (typename Tree::iterator i = tree.begin(); i != tree.end(); ++i, ++expected)
+      {
+        BAVYKIN_EXPECT(expected != model.cend());
+        BAVYKIN_EXPECT(i->first == expected->first && i->second == expected->second);
+      }
+      BAVYKIN_EXPECT(expected == model.cend());
+    }
+
+    // Batched lookups of keys in random order, with repeats and misses, have to agree with the model.
+    template < class Tree >
+    void expectBatchLookups(const Tree& tree, const std::map< int, int >& model, std::mt19937& random, int range)
+    {
+      std::vector< int > keys;
+      for (int i = 0; i < 64; i++)
+      {
+        keys.push_back(static_cast< int >(random() % (range + 10)) - 5);
+      }
+
+      std::vector< typename Tree::iterator > found;
+      std::vector< bool > contained;
+      tree.findBatch(keys, found);
+      tree.containsBatch(keys, contained);
+      BAVYKIN_EXPECT(found.size() == keys.size() && contained.size() == keys.size());
+      for (size_t i = 0; i < keys.size(); i++)
+      {
+        std::map< int, int >::const_iterator expected = model.find(keys[i]);
+        bool missing = expected == model.cend();
+        BAVYKIN_EXPECT(contained[i] == !missing);
+        BAVYKIN_EXPECT(missing ? found[i] == typename Tree::iterator(nullptr) : found[i]->second == expected->second);
+      }
+    }
+
+    // Random sequences of plain, hinted and emplaced inserts, erases by key and by iterator, batch merges with each
+    // strategy and sorted rebuilds, against std::map as the model. The shape is validated after every step, so a
+    // broken parent link or balance invariant is caught where it appears. Runs once per balance policy.
+    template < class Balance >
+    void fuzzPolicy()
+    {
+      using Tree = BST< int, int, std::less< int >, Balance >;
+
+      for (uint32_t seed = 0; seed < SEEDS; seed++)
+      {
+        std::mt19937 random(seed);
+        int range = 1 + static_cast< int >(random() % 300);
+        Tree tree;
+        std::map< int, int > model;
+
+        for (int operation = 0; operation < OPERATIONS; operation++)
+        {
+          int key = static_cast< int >(random() % range);
+          switch (random() % 8)
+          {
+          case 0:
+          case 1:
+            tree.insert(std::make_pair(key, operation));
+            model[key] = operation;
+            break;
+          case 2:
+            tree.insert(tree.find(static_cast< int >(random() % range)), std::make_pair(key, operation));
+            model[key] = operation;
+            break;
+          case 3:
+            tree.emplace_hint(tree.end(), key, operation);
+            model.emplace(key, operation);
+            break;
+          case 4:
+            tree.erase(key);
+            model.erase(key);
+            break;
+          case 5:
+          {
+            typename Tree::iterator found = tree.find(key);
+            if (found != tree.end())
+            {
+              tree.erase(found);
+              model.erase(key);
+            }
+            break;
+          }
+          case 6:
+          {
+            std::vector< std::pair< int, int > > batch;
+            for (uint32_t i = random() % 50; i > 0; i--)
+            {
+              batch.emplace_back(static_cast< int >(random() % (range * 2)), operation);
+              model[batch.back().first] = operation;
+            }
+            typename Tree::BatchStrategy strategy = static_cast< typename Tree::BatchStrategy >(random() % 3);
+            tree.insertBatch(batch.begin(), batch.end(), strategy, 1 + random() % 3);
+            break;
+          }
+          default:
+            if (random() % 16 == 0)
+            {
+              std::vector< std::pair< int, int > > sorted(model.cbegin(), model.cend());
+              tree.assignSorted(sorted.begin(), sorted.end());
+            }
+            break;
+          }
+
+          BAVYKIN_EXPECT(tree.validate());
+          BAVYKIN_EXPECT(tree.size() == model.size());
+        }
+
+        expectSameEntries(tree, model);
+        expectBatchLookups(tree, model, random, range);
+        Tree copy(tree);
+        BAVYKIN_EXPECT(copy.validate());
+        expectSameEntries(copy, model);
+      }
+    }
+  }
+
+  void runTreeFuzzTests()
+  {
+    fuzzPolicy< AvlBalance >();
+    fuzzPolicy< RedBlackBalance >();
+  }
+}
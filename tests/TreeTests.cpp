@@ -0,0 +1,169 @@
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BinarySearchTree.h"
+#include "Dictionary.h"
+#include "TestUtils.h"
+#include "Tests.h"
+
+namespace bavykin
+{
+  namespace
+  {
+    template < class Container >
+    std::vector< int > keysOf(const Container& container)
+    {
+      std::vector< int > keys;
+      for (auto i = container.cbegin(); i != container.cend(); ++i)
+      {
+        keys.push_back(i.m_Current->m_Content.first);
+      }
+
+      return keys;
+    }
+
+    std::vector< int > range(int first, int last, int step)
+    {
+      std::vector< int > keys;
+      for (int key = first; key < last; key += step)
+      {
+        keys.push_back(key);
+      }
+
+      return keys;
+    }
+
+    void testInsertFindErase()
+    {
+      BST< int, std::string > tree;
+      const int keys[] = { 5, 3, 8, 1, 4, 7, 9, 2, 6 };
+      for (int key : keys)
+      {
+        tree.insert(std::make_pair(key, std::to_string(key)));
+      }
+      tree.insert(std::make_pair(4, std::string("four")));
+
+      BAVYKIN_EXPECT(tree.find(4).m_Current->m_Content.second == "four");
+      BAVYKIN_EXPECT(tree.find(10) == tree.end());
+      BAVYKIN_EXPECT(keysOf(tree) == range(1, 10, 1));
+
+      tree.erase(5);
+      tree.erase(1);
+      tree.erase(10);
+      BAVYKIN_EXPECT(tree.find(5) == tree.end());
+      BAVYKIN_EXPECT((keysOf(tree) == std::vector< int >{ 2, 3, 4, 6, 7, 8, 9 }));
+    }
+
+    // Rotations while inserting and erasing used to leave nodes with a null parent, and iteration, which climbs
+    // through parents, then stopped early.
+    void testIterationAfterRebalancing()
+    {
+      BST< int, int > tree;
+      for (int key = 0; key < 1000; key++)
+      {
+        tree.insert(std::make_pair((key * 7919) % 1000, key));
+      }
+      BAVYKIN_EXPECT(keysOf(tree) == range(0, 1000, 1));
+
+      for (int key = 1; key < 1000; key += 2)
+      {
+        tree.erase(key);
+      }
+      BAVYKIN_EXPECT(keysOf(tree) == range(0, 1000, 2));
+
+      std::vector< int > reversed;
+      BST< int, int >::iterator i = tree.end();
+      for (i = tree.find(998); i != tree.end(); --i)
+      {
+        reversed.push_back(i.m_Current->m_Content.first);
+      }
+      BAVYKIN_EXPECT(reversed.size() == 500 && reversed.front() == 998 && reversed.back() == 0);
+    }
+
+    void testCopy()
+    {
+      BST< int, int > tree;
+      for (int key = 0; key < 100; key++)
+      {
+        tree.insert(std::make_pair(key, key * key));
+      }
+
+      BST< int, int > copy(tree);
+      copy.erase(50);
+      BAVYKIN_EXPECT(tree.find(50) != tree.end());
+      BAVYKIN_EXPECT(copy.find(50) == copy.end());
+      BAVYKIN_EXPECT(keysOf(tree) == range(0, 100, 1));
+      BAVYKIN_EXPECT(keysOf(copy).size() == 99);
+
+      BST< int, int > assigned;
+      assigned = copy;
+      BAVYKIN_EXPECT(keysOf(assigned) == keysOf(copy));
+    }
+
+    // A batch may be unsorted and repeat keys; the last entry of a key wins, whichever way it is merged.
+    void testBulkBuilds()
+    {
+      std::vector< std::pair< int, int > > sorted;
+      for (int key = 0; key < 1000; key += 2)
+      {
+        sorted.emplace_back(key, key);
+      }
+
+      for (int strategy = 0; strategy < 3; strategy++)
+      {
+        BST< int, int > tree;
+        tree.assignSorted(sorted.begin(), sorted.end());
+        BAVYKIN_EXPECT(tree.size() == 500);
+        BAVYKIN_EXPECT(tree.validate());
+
+        std::vector< std::pair< int, int > > batch = { { 3, 3 }, { 1, 1 }, { 2, -2 }, { 3, -3 } };
+        tree.insertBatch(batch.begin(), batch.end(), static_cast< BST< int, int >::BatchStrategy >(strategy));
+        BAVYKIN_EXPECT(tree.size() == 502);
+        BAVYKIN_EXPECT(tree.find(2)->second == -2);
+        BAVYKIN_EXPECT(tree.find(3)->second == -3);
+        BAVYKIN_EXPECT(tree.validate());
+      }
+    }
+
+    void testDictionary()
+    {
+      Dictionary< int, std::string > left("left");
+      Dictionary< int, std::string > right("right");
+      for (int key = 0; key < 100; key++)
+      {
+        left.insert(key, "l");
+        if (key % 2 == 0)
+        {
+          right.insert(key, "r");
+        }
+      }
+
+      BAVYKIN_EXPECT(left.contains(3));
+      BAVYKIN_EXPECT(!right.contains(3));
+      BAVYKIN_EXPECT(keysOf(left.getIntersect(right)) == range(0, 100, 2));
+      BAVYKIN_EXPECT(keysOf(left.getComplement(right)) == range(1, 100, 2));
+      BAVYKIN_EXPECT(keysOf(right.getUnion(left)) == range(0, 100, 1));
+
+      bool threw = false;
+      try
+      {
+        right.find(3);
+      }
+      catch (const std::runtime_error&)
+      {
+        threw = true;
+      }
+      BAVYKIN_EXPECT(threw);
+    }
+  }
+
+  void runTreeTests()
+  {
+    testInsertFindErase();
+    testIterationAfterRebalancing();
+    testCopy();
+    testBulkBuilds();
+    testDictionary();
+  }
+}
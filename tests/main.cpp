@@ -0,0 +1,64 @@
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include "Tests.h"
+
+using namespace bavykin;
+
+struct TestEntry
+{
+  const char* m_Name;
+  void (*m_Function)();
+};
+
+const TestEntry TESTS[] = {
+  { "tree", &runTreeTests },
+  { "tree-fuzz", &runTreeFuzzTests },
+  { "snapshot", &runSnapshotTests },
+  { "thread-pool", &runThreadPoolTests },
+  { "flat-string-map", &runFlatStringMapTests },
+  { "result-cache", &runResultCacheTests },
+  { "executor", &runExecutorTests },
+  { "string-pool", &runStringPoolTests },
+  { "dense", &runDenseTests },
+  { "instrumentation", &runInstrumentationTests },
+  { "skip-list-stress", &runConcurrentSkipListTests },
+  { "three-way-compare", &runThreeWayCompareTests },
+  { "lookup-cache", &runLookupCacheTests },
+  { "bloom-filter", &runBloomFilterTests },
+};
+
+// Runs the named test, or every test without a name; CTest registers each test as its own case. A test fails by
+// throwing, so the exit status is the number of failed tests.
+int main(int argc, char* argv[])
+{
+  int failures = 0;
+  bool matched = false;
+  for (const TestEntry& entry : TESTS)
+  {
+    if (argc >= 2 && std::strcmp(entry.m_Name, argv[1]) != 0)
+    {
+      continue;
+    }
+
+    matched = true;
+    try
+    {
+      entry.m_Function();
+      std::cout << entry.m_Name << ": passed" << std::endl;
+    }
+    catch (const std::exception& exception)
+    {
+      std::cerr << entry.m_Name << ": " << exception.what() << std::endl;
+      failures++;
+    }
+  }
+
+  if (!matched)
+  {
+    std::cerr << "Unknown test '" << argv[1] << "'." << std::endl;
+    return 1;
+  }
+
+  return failures;
+}